@@ -0,0 +1,273 @@
+/**
+ * @file bench.c
+ * @brief Benchmark of the byte engine of convey's game of life, run by make bench
+ * @details
+ * Runs a fixed set of workloads - random soups at three densities, the
+ * R-pentomino, acorn and the Gosper glider gun - on square boards from 256 to
+ * 16384 cells a side under hedge, torus and klein, stepping them with the edge
+ * functions and mid() of life.c on the fastest kernel the CPU supports. Each
+ * workload runs for about BENCH_UPDATES cell updates, the best of BENCH_REPEAT
+ * runs being kept. The results are written to a CSV file and compared to a
+ * baseline file of the same form, row by row on the workload, size, edge and
+ * kernel. The benchmark fails if the baseline can not be read, if a workload
+ * has no row in it, or if any workload runs slower than the baseline by more
+ * than the tolerance.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "life.h"
+#include "kernel.h"
+
+/** Cell updates each workload runs for, split into generations by the area of the board. */
+#define BENCH_UPDATES (1L << 29)
+
+/** Runs of each workload, the fastest of which is kept. */
+#define BENCH_REPEAT 3
+
+/** Workloads of the benchmark rows. */
+#define BENCH_MAX 128
+
+/** A starting board: a random soup of some density, or a pattern in RLE placed in the middle. */
+struct workload_t {
+        const char *name;
+        double density;
+        const char *rle;
+};
+
+static const struct workload_t workloads[] = {
+    { "soup10", 0.10, NULL },
+    { "soup30", 0.30, NULL },
+    { "soup50", 0.50, NULL },
+    { "rpentomino", 0, "x = 3, y = 3\nb2o$2ob$bo!\n" },
+    { "acorn", 0, "x = 7, y = 3\nbo$3bo$2o2b3o!\n" },
+    { "gosper", 0, "x = 36, y = 9\n24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4bobo$10bo5bo7bo$11bo3bo$12b2o!\n" },
+};
+
+static const int sizes[] = { 256, 1024, 4096, 16384 };
+
+static const char edges[] = { 'h', 't', 'k' };
+
+static const char *names[] = { ['h'] = "hedge", ['t'] = "torus", ['k'] = "klein" };
+
+/** One row of the results or the baseline. */
+struct result_t {
+        char workload[32];
+        int size;
+        char edge[8];
+        char kernel[8];
+        double rate;		/* cell updates per second */
+};
+
+/**
+ * @brief Fill the matrix with a random soup, the same for every run. A random byte per cell is compared to the density.
+ * @param a the matrix
+ * @param density share of live cells
+ */
+static void soup(struct grid_t *a, double density){
+    unsigned threshold = density * 256;
+    uint64_t v = 0;
+    long state = 0;
+    int r, c;
+
+    for(r = 0; r < a->m_row; r++)
+        for(c = 0; c < a->n_col; c++){
+            if((c & 7) == 0)
+                v = hash_key(state++);
+            a->row[r][c] = (v & 255) < threshold;
+            v >>= 8;
+        }
+}
+
+/**
+ * @brief Set up the board of a workload.
+ * @param a the matrix, all dead
+ * @param w the workload
+ * @param type type of edge - hedge, torus, klein
+ */
+static void setup(struct grid_t *a, const struct workload_t *w, char type){
+    struct pattern_ctx_t in = { a, type, 0 };
+    FILE *fp;
+
+    if(!w->rle){
+        soup(a, w->density);
+        return;
+    }
+    fp = fmemopen((void *)w->rle, strlen(w->rle), "r");
+    if(!fp || pattern_read(fp, a->n_col / 2, a->m_row / 2, a->n_col, a->m_row, pattern_cell, &in) <= 0 || in.outside){
+        printf("Pattern %s could not be read.\n", w->name);
+        exit(EXIT_FAILURE);
+    }
+    fclose(fp);
+}
+
+/**
+ * @brief Run a workload a number of generations and time it.
+ * @param a present matrix, set up
+ * @param b future matrix
+ * @param type type of edge - hedge, torus, klein
+ * @param gens generations to run
+ * @return seconds taken
+ */
+static double run(struct grid_t *a, struct grid_t *b, char type, long gens){
+    struct timespec start, end;
+    struct grid_t *tmp;
+    long g;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(g = 0; g < gens; g++){
+        switch(type){
+            case 'h':
+                hedge(a, b);
+                break;
+            case 't':
+                torus(a, b);
+                break;
+            case 'k':
+                klein(a, b);
+                break;
+        }
+        mid(a, b);
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Read the rows of a results file.
+ * @param path the file
+ * @param rows set to the rows, at most BENCH_MAX
+ * @return number of rows read, -1 if the file could not be opened
+ */
+static int read_results(const char *path, struct result_t *rows){
+    FILE *fp = fopen(path, "r");
+    char line[256];
+    int n = 0;
+
+    if(!fp)
+        return -1;
+    while(n < BENCH_MAX && fgets(line, sizeof(line), fp))
+        if(sscanf(line, "%31[^,],%d,%7[^,],%7[^,],%*[^,],%*[^,],%lf", rows[n].workload, &rows[n].size, rows[n].edge, rows[n].kernel, &rows[n].rate) == 5)
+            n++;
+    fclose(fp);
+    return n;
+}
+
+/**
+ * @brief Run the benchmark.
+ * @details Options: -o results file (bench.csv), -b baseline file, -t tolerance in percent (10), -m largest board size.
+ * Without -b the results are only written.
+ * @param argc Number of command line arguments
+ * @param argv String or arguments.
+ * @return 0 if every workload was compared and none fell below the baseline by more than the tolerance, otherwise 1
+ */
+int main(int argc, char *argv[]){
+    const char *out_path = "bench.csv", *base_path = NULL;
+    struct result_t base[BENCH_MAX], *res;
+    struct grid_t *a, *b;
+    double tolerance = 10, secs, best, drop;
+    long gens;
+    int c, i, s, e, k, r, n_base = 0, n_res = 0, max_size = 16384, failed = 0, missing = 0;
+    FILE *out;
+
+    while((c = getopt(argc, argv, "o:b:t:m:")) != -1)
+        switch(c){
+            case 'o':
+                out_path = optarg;
+                break;
+            case 'b':
+                base_path = optarg;
+                break;
+            case 't':
+                tolerance = atof(optarg);
+                break;
+            case 'm':
+                max_size = atoi(optarg);
+                break;
+            default:
+                printf("usage: bench -o results.csv -b baseline.csv -t percent -m size\n");
+                exit(EXIT_FAILURE);
+        }
+
+    if(base_path && (n_base = read_results(base_path, base)) <= 0){
+        printf("Baseline %s could not be read. Write one with make bench-baseline.\n", base_path);
+        exit(EXIT_FAILURE);
+    }
+    res = malloc(BENCH_MAX * sizeof(struct result_t));
+    out = fopen(out_path, "w");
+    if(!res || !out){
+        printf("Results file %s could not be written.\n", out_path);
+        exit(EXIT_FAILURE);
+    }
+    kernel_select(NULL);
+    fprintf(out, "workload,size,edge,kernel,generations,seconds,updates_per_s\n");
+
+    for(s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])) && sizes[s] <= max_size; s++){
+        a = init_matrix(sizes[s], sizes[s]);
+        b = init_matrix(sizes[s], sizes[s]);
+        if(!a || !b){
+            printf("Matrix Initialization has failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        gens = BENCH_UPDATES / ((long)sizes[s] * sizes[s]);
+        if(gens < 1)
+            gens = 1;
+        for(i = 0; i < (int)(sizeof(workloads) / sizeof(workloads[0])); i++)
+            for(e = 0; e < 3; e++){
+                best = 0;
+                for(r = 0; r < BENCH_REPEAT; r++){
+                    memset(a->row[-1] - 1, 0, (size_t)(sizes[s] + 2) * a->stride);
+                    memset(b->row[-1] - 1, 0, (size_t)(sizes[s] + 2) * b->stride);
+                    setup(a, &workloads[i], edges[e]);
+                    secs = run(a, b, edges[e], gens);
+                    if(r == 0 || secs < best)
+                        best = secs;
+                }
+                res[n_res] = (struct result_t){ .size = sizes[s], .rate = (double)gens * sizes[s] * sizes[s] / best };
+                strcpy(res[n_res].workload, workloads[i].name);
+                strcpy(res[n_res].edge, names[(int)edges[e]]);
+                strcpy(res[n_res].kernel, kernel->name);
+                fprintf(out, "%s,%d,%s,%s,%ld,%.6f,%.4g\n", workloads[i].name, sizes[s], names[(int)edges[e]], kernel->name, gens, best, res[n_res].rate);
+                fflush(out);
+
+                printf("%-10s %5d %s: %.4g cell updates/s", workloads[i].name, sizes[s], names[(int)edges[e]], res[n_res].rate);
+                for(k = 0; k < n_base; k++)
+                    if(!strcmp(base[k].workload, res[n_res].workload) && base[k].size == res[n_res].size && !strcmp(base[k].edge, res[n_res].edge)
+                       && !strcmp(base[k].kernel, res[n_res].kernel)){
+                        drop = 100 * (1 - res[n_res].rate / base[k].rate);
+                        printf(", %+.1f%% against the baseline", -drop);
+                        if(drop > tolerance){
+                            printf(" - REGRESSION");
+                            failed++;
+                        }
+                        break;
+                    }
+                if(n_base && k == n_base){
+                    printf(" - NOT IN THE BASELINE");
+                    missing++;
+                }
+                printf("\n");
+                n_res++;
+            }
+        free_matrix(a);
+        free_matrix(b);
+    }
+    fclose(out);
+    free(res);
+
+    printf("%d workloads with the %s kernel written to %s", n_res, kernel->name, out_path);
+    if(n_base)
+        printf(", %d slower than the baseline by more than %.1f%%, %d not in it", failed, tolerance, missing);
+    printf("\n");
+    return failed || missing ? EXIT_FAILURE : EXIT_SUCCESS;
+}
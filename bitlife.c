@@ -0,0 +1,478 @@
+/**
+ * @file bitlife.c
+ * @brief Bit packed engine for convey's game of life
+ * @details 
+ * Every cell is one bit, so a 64 bit word holds 64 cells of a row.
+ * The eight neighbors of all 64 cells are summed at once with bitwise adders
+ * and the rule is applied to the bits of the sums, with a step of its own
+ * for each rule of RULE_LIST.
+ * Supports the same edges as life.c (hedge, torus, klein) with the same results.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+#include "bitlife.h"
+#include "rule.h"
+
+/** 
+ * @brief Creates the bit matrix and initializes all cells to 0. Return adress of Matrix is sussesful or NULL if malloc failed.
+ * @details One word more than the cells need is kept per row so the ghost cell right of the last collum has a bit.
+ * @param rows The number of rows
+ * @param cols The number of columns
+ */
+struct bitgrid_t *init_bitgrid(int rows, int cols)
+{
+    struct bitgrid_t *m;
+
+    m = malloc(sizeof(struct bitgrid_t));
+    if(!m)
+        return NULL;
+    m->m_row = rows;
+    m->n_col = cols;
+    m->words = BIT_WORDS(cols);
+    m->dirty = NULL;
+    m->hash = NULL;
+    m->stats = NULL;
+    m->census = NULL;
+    m->word = aligned_alloc(GRID_ALIGN, ((size_t)rows * m->words * sizeof(uint64_t) + GRID_ALIGN - 1) / GRID_ALIGN * GRID_ALIGN);
+    m->work = malloc(BIT_WORK(m->words) * sizeof(uint64_t));
+    if(!m->word || !m->work){
+        free(m->word);
+        free(m->work);
+        free(m);
+        return NULL;
+    }
+    memset(m->word, 0, (size_t)rows * m->words * sizeof(uint64_t));
+    return m;
+}
+
+/** 
+ * @brief Deletes the bit matrix space in memory
+ * @param m the matrix to be freed
+ */
+void free_bitgrid(struct bitgrid_t *m){
+    free(m->word);
+    free(m->work);
+    free(m);
+}
+
+/** 
+ * @brief Pack a byte matrix into a bit matrix of the same size.
+ * @details Eight cells are packed at a time: with a cell's low bit in each byte, one multiply moves byte i to bit
+ * 56 + i. The cells past the last multiple of eight are packed one at a time, so the ghost collum is never read.
+ * @param b bit matrix to fill
+ * @param g byte matrix to read
+ */
+void bit_from_grid(struct bitgrid_t *b, struct grid_t *g){
+    int r, c;
+    uint64_t *w, x;
+    for(r = 0; r < b->m_row; r++){
+        w = b->word + (long)r * b->words;
+        memset(w, 0, b->words * sizeof(uint64_t));
+        for(c = 0; c + 8 <= b->n_col; c += 8){
+            memcpy(&x, g->row[r] + c, 8);
+            w[c / 64] |= ((x & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56 << (c % 64);
+        }
+        for(; c < b->n_col; c++)
+            w[c / 64] |= (uint64_t)(g->row[r][c] & 1) << (c % 64);
+    }
+}
+
+/** 
+ * @brief Unpack a bit matrix into a byte matrix of the same size.
+ * @param g byte matrix to fill
+ * @param b bit matrix to read
+ */
+void bit_to_grid(struct grid_t *g, struct bitgrid_t *b){
+    int r, c;
+    uint64_t *w;
+    for(r = 0; r < b->m_row; r++){
+        w = b->word + (long)r * b->words;
+        for(c = 0; c < b->n_col; c++)
+            g->row[r][c] = (w[c / 64] >> (c % 64)) & 1;
+    }
+}
+
+/** 
+ * @brief Read one cell of the bit matrix.
+ * @param g bit matrix
+ * @param r row of the cell
+ * @param c collum of the cell
+ */
+static inline uint64_t bit(struct bitgrid_t *g, int r, int c){
+    return (g->word[(long)r * g->words + c / 64] >> (c % 64)) & 1;
+}
+
+/** 
+ * @brief Copy row j of the matrix, as seen from the edge type, into a work row with its ghost cells.
+ * @details Rows past the top and bottom wrap for torus and klein and are dead for hedge. The work row has a
+ * word before the row holding the ghost cell left of the row in its top bit, and the ghost cell right of the
+ * row is set at bit n_col.
+ * @param p matrix to read
+ * @param type type of edge - hedge, torus, klein
+ * @param j row to copy, -1 to m_row
+ * @param w work row at its first word, with words + 1 words after and one before
+ */
+static void load_row(struct bitgrid_t *p, char type, int j, uint64_t *w){
+    int m = p->m_row, n = p->n_col, g;
+
+    w[-1] = 0;
+    w[p->words] = 0;
+    if(j < 0 || j >= m){
+        if(type == 'h'){
+            memset(w, 0, p->words * sizeof(uint64_t));
+            return;
+        }
+        j = (j + m) % m;
+    }
+    memcpy(w, p->word + (long)j * p->words, p->words * sizeof(uint64_t));
+    switch(type){
+        case 't':
+            w[n / 64] |= bit(p, j, 0) << (n % 64);
+            w[-1] = bit(p, j, n - 1) << 63;
+            break;
+        case 'k':
+            g = m - 1 - j;
+            w[n / 64] |= bit(p, g, 0) << (n % 64);
+            w[-1] = bit(p, g, n - 1) << 63;
+            break;
+    }
+}
+
+/** 
+ * @brief Add each cell of a work row to its west and east neighbor, as a two bit sum per cell.
+ * @details The neighbors to the west and east are the row shifted by one bit, carrying the bit across words.
+ * @param w work row from load_row()
+ * @param s ones bit of the sums
+ * @param k twos bit of the sums
+ * @param words words in a row
+ */
+static void row_sums(const uint64_t *restrict w, uint64_t *restrict s, uint64_t *restrict k, int words){
+    uint64_t west, east;
+    int i;
+
+    for(i = 0; i < words; i++){
+        west = (w[i] << 1) | (w[i-1] >> 63);
+        east = (w[i] >> 1) | (w[i+1] << 63);
+        s[i] = west ^ w[i] ^ east;
+        k[i] = (west & w[i]) | (east & (west ^ w[i]));
+    }
+}
+
+/** 
+ * @brief Cells whose sum, held as the bit planes x0 to x3, is one of the sums set in a mask.
+ * @details With the mask a constant the loop unrolls into the sums of the mask alone.
+ * @param x0 ones of the sums
+ * @param x1 twos of the sums
+ * @param x2 fours of the sums
+ * @param x3 eights of the sums
+ * @param mask bit k set for a sum of k, 0 to 9
+ */
+static inline __attribute__((always_inline)) uint64_t sum_in(uint64_t x0, uint64_t x1, uint64_t x2, uint64_t x3, unsigned mask){
+    uint64_t in = 0;
+    int k;
+
+    for(k = 0; k <= 9; k++)
+        if(mask >> k & 1)
+            in |= (k & 1 ? x0 : ~x0) & (k & 2 ? x1 : ~x1) & (k & 4 ? x2 : ~x2) & (k & 8 ? x3 : ~x3);
+    return in;
+}
+
+/** 
+ * @brief Update one row of 64 cell words to the next generation from the row sums above, on and below it.
+ * @details The three two bit sums are added as bit planes: ones (x0), twos (x1), fours (x2) and eights (x3).
+ * The total counts the cell itself, so a dead cell is born with a total in birth, and a live cell stays alive with
+ * one more than a count in survive. Totals in both need no test of the cell, so B3/S23 is a total of 3, or of
+ * 4 and alive.
+ * @param sa ones of the row above
+ * @param ka twos of the row above
+ * @param sb ones of the row
+ * @param kb twos of the row
+ * @param sc ones of the row below
+ * @param kc twos of the row below
+ * @param b the row
+ * @param out next generation of row b
+ * @param words words in a row
+ * @param birth sums a dead cell is born with, bit k for a sum of k
+ * @param survive sums a live cell stays alive with
+ */
+static inline __attribute__((always_inline)) void step_words_rule(const uint64_t *restrict sa, const uint64_t *restrict ka, const uint64_t *restrict sb, const uint64_t *restrict kb, const uint64_t *restrict sc, const uint64_t *restrict kc, const uint64_t *restrict b, uint64_t *restrict out, int words, unsigned birth, unsigned survive){
+    uint64_t x0, x1, x2, x3, c1, c2, t0, t1;
+    unsigned alive = survive << 1, both = birth & alive;
+    int i;
+
+    for(i = 0; i < words; i++){
+        x0 = sa[i] ^ sb[i] ^ sc[i];
+        c1 = (sa[i] & sb[i]) | (sc[i] & (sa[i] ^ sb[i]));
+        t0 = ka[i] ^ kb[i] ^ kc[i];
+        t1 = (ka[i] & kb[i]) | (kc[i] & (ka[i] ^ kb[i]));
+        x1 = t0 ^ c1;
+        c2 = t0 & c1;
+        x2 = t1 ^ c2;
+        x3 = t1 & c2;
+
+        out[i] = sum_in(x0, x1, x2, x3, both) | (~b[i] & sum_in(x0, x1, x2, x3, birth & ~both)) | (b[i] & sum_in(x0, x1, x2, x3, alive & ~both));
+    }
+}
+
+/** Step of a row for a rule of RULE_LIST. */
+#define STEP_WORDS(id, name, birth, survive) \
+static void step_words_##id(const uint64_t *restrict sa, const uint64_t *restrict ka, const uint64_t *restrict sb, const uint64_t *restrict kb, const uint64_t *restrict sc, const uint64_t *restrict kc, const uint64_t *restrict b, uint64_t *restrict out, int words){ \
+    step_words_rule(sa, ka, sb, kb, sc, kc, b, out, words, birth, survive); \
+}
+RULE_LIST(STEP_WORDS)
+
+/** 
+ * @brief Step of a row for any rule, from a table of the totals of the rule made once per row.
+ * @details The total is split into its low two bits (x0, x1) and its high two (x2, x3). For each of the three
+ * values of the high bits a total can have, the table holds which of the four low values the rule gives life to,
+ * dead and alive, as words of all ones or zeros, so every word costs the same whatever the rule.
+ * @param sa ones of the row above
+ * @param ka twos of the row above
+ * @param sb ones of the row
+ * @param kb twos of the row
+ * @param sc ones of the row below
+ * @param kc twos of the row below
+ * @param b the row
+ * @param out next generation of row b
+ * @param words words in a row
+ */
+static void step_words_any(const uint64_t *restrict sa, const uint64_t *restrict ka, const uint64_t *restrict sb, const uint64_t *restrict kb, const uint64_t *restrict sc, const uint64_t *restrict kc, const uint64_t *restrict b, uint64_t *restrict out, int words){
+    uint64_t x0, x1, x2, x3, c1, c2, t0, t1, lo[4], hi[3], dead, live, next;
+    uint64_t table[2][3][4];
+    unsigned totals[2] = { rule.birth, rule.survive << 1 };
+    int i, a, h, l;
+
+    for(a = 0; a < 2; a++)
+        for(h = 0; h < 3; h++)
+            for(l = 0; l < 4; l++)
+                table[a][h][l] = -(uint64_t)(totals[a] >> (4 * h + l) & 1);
+    for(i = 0; i < words; i++){
+        x0 = sa[i] ^ sb[i] ^ sc[i];
+        c1 = (sa[i] & sb[i]) | (sc[i] & (sa[i] ^ sb[i]));
+        t0 = ka[i] ^ kb[i] ^ kc[i];
+        t1 = (ka[i] & kb[i]) | (kc[i] & (ka[i] ^ kb[i]));
+        x1 = t0 ^ c1;
+        c2 = t0 & c1;
+        x2 = t1 ^ c2;
+        x3 = t1 & c2;
+
+        lo[0] = ~x0 & ~x1;
+        lo[1] = x0 & ~x1;
+        lo[2] = ~x0 & x1;
+        lo[3] = x0 & x1;
+        hi[0] = ~x2 & ~x3;
+        hi[1] = x2 & ~x3;
+        hi[2] = x3;
+        next = 0;
+        for(h = 0; h < 3; h++){
+            dead = (lo[0] & table[0][h][0]) | (lo[1] & table[0][h][1]) | (lo[2] & table[0][h][2]) | (lo[3] & table[0][h][3]);
+            live = (lo[0] & table[1][h][0]) | (lo[1] & table[1][h][1]) | (lo[2] & table[1][h][2]) | (lo[3] & table[1][h][3]);
+            next |= hi[h] & ((dead & ~b[i]) | (live & b[i]));
+        }
+        out[i] = next;
+    }
+}
+
+/** Step of a row, by rule id. */
+typedef void (*words_fn)(const uint64_t *restrict, const uint64_t *restrict, const uint64_t *restrict, const uint64_t *restrict, const uint64_t *restrict, const uint64_t *restrict, const uint64_t *restrict, uint64_t *restrict, int);
+#define STEP_WORDS_FN(id, name, birth, survive) step_words_##id,
+static const words_fn step_words[RULE_ANY + 1] = { RULE_LIST(STEP_WORDS_FN) step_words_any };
+
+/** 
+ * @brief Change to the hash of a row of words, the difference of each word times its key.
+ * @param p present row
+ * @param f future row
+ * @param words words in the row
+ * @param key keys of the words of the row hashes
+ */
+static uint64_t bit_flip_hash(const uint64_t *p, const uint64_t *f, int words, const uint64_t *key){
+    uint64_t h = 0;
+    int i;
+
+    for(i = 0; i < words; i++)
+        h += (f[i] - p[i]) * key[i];
+    return h;
+}
+
+/** 
+ * @brief Count the bits of each byte of a word, into that byte.
+ * @param x the word
+ */
+static inline uint64_t byte_bits(uint64_t x){
+    x = x - (x >> 1 & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + (x >> 2 & 0x3333333333333333ULL);
+    return (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+}
+
+/** 
+ * @brief Sum of the eight bytes of a word.
+ * @param x the word
+ */
+static inline long byte_sum(uint64_t x){
+    x = (x & 0x00ff00ff00ff00ffULL) + (x >> 8 & 0x00ff00ff00ff00ffULL);
+    return (x * 0x0001000100010001ULL) >> 48;
+}
+
+/** 
+ * @brief Add row r to the counts: the live cells of f and those born or died since p.
+ * @details The bits of each byte are counted into it and those counts added up over 31 words at a time, before any
+ * byte could pass 255. Only the first and last word holding a live cell are kept on the way, without a branch.
+ * @param s the counts
+ * @param p present row
+ * @param f future row
+ * @param words words in the row
+ * @param r row
+ */
+static void bit_row_stats(struct stats_t *s, const uint64_t *p, const uint64_t *f, int words, int r){
+    uint64_t live, born, died;
+    int i = 0, k, first = words, last = -1;
+
+    while(i < words){
+        live = born = died = 0;
+        for(k = 0; k < 31 && i < words; k++, i++){
+            live += byte_bits(f[i]);
+            born += byte_bits(f[i] & ~p[i]);
+            died += byte_bits(p[i] & ~f[i]);
+            last = f[i] ? i : last;
+        }
+        s->population += byte_sum(live);
+        s->births += byte_sum(born);
+        s->deaths += byte_sum(died);
+    }
+    if(last < 0)
+        return;
+    for(first = 0; !f[first]; first++)
+        ;
+    first = 64 * first + __builtin_ctzll(f[first]);
+    last = 64 * last + 63 - __builtin_clzll(f[last]);
+    if(r < s->top)
+        s->top = r;
+    if(r > s->bottom)
+        s->bottom = r;
+    if(first < s->left)
+        s->left = first;
+    if(last > s->right)
+        s->right = last;
+}
+
+/** 
+ * @brief Live cells of a word, counted in its bytes and those added up by a multiply, as the count never passes 64.
+ * @param x the word
+ */
+static inline int word_bits(uint64_t x){
+    return (byte_bits(x) * 0x0101010101010101ULL) >> 56;
+}
+
+/** 
+ * @brief Count the live cells of every tile of a bit matrix, a span of 64 cells for each word.
+ * @param s the census
+ * @param b the matrix
+ */
+void census_bits(struct census_t *s, struct bitgrid_t *b){
+    int d[64], k, r, i, spans = (b->n_col + 63) / 64;
+    const uint64_t *w;
+
+    for(k = 0; k < CENSUS_LEVELS; k++)
+        memset(s->count[k], 0, (size_t)s->rows[k] * s->cols[k] * sizeof(int));
+    for(r = 0; r < b->m_row; r++)
+        for(i = 0, w = b->word + (long)r * b->words; i < spans; i += k){
+            for(k = 0; k < 64 && i + k < spans; k++)
+                d[k] = word_bits(w[i + k]);
+            census_add(s, r, i, d, k);
+        }
+}
+
+/** 
+ * @brief Advance the band of rows r0 to r1 - 1 of the bit matrix one generation with the given edge type.
+ * @details Three work rows (above, the row, below) with their sums are rotated down the band so every row is
+ * copied and summed once. Only p is read and only the band is written, so bands can run on separate threads, each
+ * with work rows of its own. The change of each word to the census is added up over the rows of the band in a tile
+ * and handed over once the band leaves the tile.
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param r0 first row of the band
+ * @param r1 row after the band
+ * @param work BIT_WORK(p->words) words of work rows
+ * @param stats counts of the band, started over here, or NULL
+ */
+void bit_step_band(struct bitgrid_t *p, struct bitgrid_t *f, char type, int r0, int r1, uint64_t *work, struct stats_t *stats){
+    int r, i, words = p->words, n = p->n_col, size = 3 * words + 2, *moved = (int *)(work + 3 * size);
+    uint64_t *row[3], *out;
+    words_fn step = step_words[rule.id];
+    uint64_t last = (n % 64) ? ~(uint64_t)0 >> (64 - n % 64) : 0;
+
+    /* each work row is the copied row with a word either side, then its ones and twos */
+    for(i = 0; i < 3; i++)
+        row[i] = work + i * size + 1;
+    for(i = 0; i < 2; i++){
+        load_row(p, type, r0 + i - 1, row[i]);
+        row_sums(row[i], row[i] + words + 1, row[i] + 2 * words + 1, words);
+    }
+
+    if(stats)
+        stats_clear(stats);
+    if(f->census)
+        memset(moved, 0, words * sizeof(int));
+    for(r = r0; r < r1; r++){
+        uint64_t *a = row[(r - r0) % 3], *b = row[(r - r0 + 1) % 3], *c = row[(r - r0 + 2) % 3];
+        load_row(p, type, r + 1, c);
+        row_sums(c, c + words + 1, c + 2 * words + 1, words);
+        out = f->word + (long)r * words;
+        step(a + words + 1, a + 2 * words + 1, b + words + 1, b + 2 * words + 1, c + words + 1, c + 2 * words + 1, b, out, words);
+        /* clear the bits past the last collum */
+        out[n / 64] &= last;
+        if((f->dirty || f->census) && memcmp(out, p->word + (long)r * words, words * sizeof(uint64_t))){
+            if(f->dirty)
+                f->dirty[r] = 1;
+            if(f->census)
+                for(i = 0; i < words; i++)
+                    if(out[i] != p->word[(long)r * words + i])
+                        moved[i] += word_bits(out[i]) - word_bits(p->word[(long)r * words + i]);
+        }
+        if(f->census && (r + 1 == r1 || (r + 1) % 64 == 0)){
+            census_add(f->census, r, 0, moved, (n + 63) / 64);
+            memset(moved, 0, words * sizeof(int));
+        }
+        if(f->hash)
+            rowhash_add(f->hash, f, r, bit_flip_hash(p->word + (long)r * words, out, words, f->hash->key));
+        if(stats)
+            bit_row_stats(stats, p->word + (long)r * words, out, words, r);
+    }
+}
+
+/** 
+ * @brief Advance the bit matrix one generation with the given edge type, on the work rows of p.
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ */
+void bit_step(struct bitgrid_t *p, struct bitgrid_t *f, char type){
+    bit_step_band(p, f, type, 0, p->m_row, p->work, f->stats);
+}
+
+/** 
+ * @brief Advance the bit matrix gens generations.
+ * @details p and f are swapped once per generation, so on return *p is the last generation.
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param gens number of generations
+ */
+void bit_run(struct bitgrid_t **p, struct bitgrid_t **f, char type, long gens){
+    struct bitgrid_t *tmp;
+
+    for(; gens > 0; gens--){
+        bit_step(*p, *f, type);
+        tmp = *p;
+        *p = *f;
+        *f = tmp;
+    }
+}
@@ -0,0 +1,49 @@
+/**
+ * @file bitlife.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the bit packed Conway Game of Life engine
+ */
+#ifndef BITLIFE_H_
+#define BITLIFE_H_
+
+#include <stdint.h>
+
+struct grid_t;
+struct rowhash_t;
+struct stats_t;
+struct census_t;
+
+/** Words per row of a bit matrix of n collums, one more than the cells need for the ghost cell past the last. */
+#define BIT_WORDS(n) ((n) / 64 + 1)
+
+/** Words of work rows bit_step_band() needs for rows of w words: three rows, each with a word either side, its ones
+ * and twos, and the change to the census of each word over the rows of a tile, an int a word. */
+#define BIT_WORK(w) (3 * (3 * (w) + 2) + (w) / 2 + 1)
+
+/**
+ * Matrix of cells stored one bit per cell, 64 cells to a word.
+ * Cell (r, c) is bit c % 64 of word[r * words + c / 64]. Bits past n_col are always 0.
+ */
+struct bitgrid_t {
+        uint64_t *word;
+        int m_row;
+        int n_col;
+        int words;
+        unsigned char *dirty;		/* if set, the step sets dirty[r] when row r of this matrix changes */
+        struct rowhash_t *hash;		/* if set, the step keeps the hashes of the rows up to date */
+        struct stats_t *stats;		/* if set, the step counts the generation it writes into this matrix */
+        struct census_t *census;	/* if set, the step keeps the live cells of each tile of this matrix */
+        uint64_t *work;			/* BIT_WORK(words) words for bit_step() when this is the present matrix */
+};
+
+struct bitgrid_t *init_bitgrid(int m_row, int n_col);
+void free_bitgrid(struct bitgrid_t *matrix);
+void bit_from_grid(struct bitgrid_t *b, struct grid_t *g);
+void bit_to_grid(struct grid_t *g, struct bitgrid_t *b);
+void census_bits(struct census_t *s, struct bitgrid_t *b);
+void bit_step(struct bitgrid_t *p, struct bitgrid_t *f, char type);
+void bit_run(struct bitgrid_t **p, struct bitgrid_t **f, char type, long gens);
+void bit_step_band(struct bitgrid_t *p, struct bitgrid_t *f, char type, int r0, int r1, uint64_t *work, struct stats_t *stats);
+
+#endif
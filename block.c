@@ -0,0 +1,220 @@
+/**
+ * @file block.c
+ * @brief Temporally blocked stepping of convey's game of life
+ * @details
+ * Stepping the whole matrix once per generation reads and writes every cell
+ * each generation, which is bound by memory once the matrix is larger than the
+ * cache. Here the matrix is split into tiles and each tile is advanced several
+ * generations while it sits in cache. A tile is copied into scratch with a
+ * halo of as many cells as generations on every side. Each generation the
+ * cells one further in from the edge of the scratch are updated, so after k
+ * generations the tile itself holds generation k and the halo is spent. The
+ * halo cells are worked out more than once, by every tile they border, which
+ * is the price of reading and writing the matrix once per k generations.
+ *
+ * Halo cells past the edge of the matrix are read through the edge type: dead
+ * for hedge, from the opposite side for torus, and for klein from the opposite
+ * side of the flipped row. The plane filled this way is a cover of the torus
+ * or klein bottle, so the cells of a halo evolve as the cells they were copied
+ * from would and the wrap stays right for any number of generations. For
+ * hedge the cells past the edge are not updated, so they stay dead.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+#include "kernel.h"
+#include "block.h"
+
+/**
+ * @brief Creates the tiles and scratch of a matrix. Return adress of blocks is sussesful or NULL if malloc failed.
+ * @details Tiles are BLOCK_WIDTH wide and as high as lets both scratch tiles fit in BLOCK_CACHE.
+ * @param m_row number of row in matrix
+ * @param n_col number of collum in matrix
+ * @param depth generations advanced per sweep, 1 to BLOCK_DEPTH_MAX
+ */
+struct block_t *init_block(int m_row, int n_col, int depth){
+    struct block_t *b = malloc(sizeof(struct block_t));
+    size_t size;
+
+    if(!b)
+        return NULL;
+    b->m_row = m_row;
+    b->n_col = n_col;
+    b->depth = depth;
+    b->width = n_col < BLOCK_WIDTH ? n_col : BLOCK_WIDTH;
+    /* a margin collum either side of the tile and its halo */
+    b->stride = (b->width + 2 * depth + 2 + GRID_ALIGN - 1) / GRID_ALIGN * GRID_ALIGN;
+    b->height = BLOCK_CACHE / 2 / b->stride - 2 * depth;
+    if(b->height < depth)
+        b->height = depth;
+    if(b->height > m_row)
+        b->height = m_row;
+    size = (size_t)(b->height + 2 * depth) * b->stride;
+    b->scratch[0] = aligned_alloc(GRID_ALIGN, size);
+    b->scratch[1] = aligned_alloc(GRID_ALIGN, size);
+    if(!b->scratch[0] || !b->scratch[1]){
+        free_block(b);
+        return NULL;
+    }
+    memset(b->scratch[0], 0, size);
+    memset(b->scratch[1], 0, size);
+    return b;
+}
+
+/**
+ * @brief Frees the tiles and scratch.
+ * @param b the blocks
+ */
+void free_block(struct block_t *b){
+    free(b->scratch[0]);
+    free(b->scratch[1]);
+    free(b);
+}
+
+/**
+ * @brief Cell at row y and collum x of the plane the edge type makes of the matrix.
+ * @param p Present Matrix - Current Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param y row, any
+ * @param x collum, any
+ */
+static unsigned char cover_cell(struct grid_t *p, char type, int y, int x){
+    return cover(type, p->m_row, p->n_col, &y, &x) ? p->row[y][x] : 0;
+}
+
+/**
+ * @brief Copy w cells of row y of the plane the edge type makes of the matrix from collum x0 into the scratch.
+ * @details The cells inside the matrix are copied straight from the row and only the halo cells past the left and
+ * right edge are looked up one by one.
+ * @param p Present Matrix - Current Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param y row, any
+ * @param x0 first collum, any
+ * @param w number of cells
+ * @param out scratch row at the first cell
+ */
+static void gather_row(struct grid_t *p, char type, int y, int x0, int w, unsigned char *out){
+    int m = p->m_row, n = p->n_col, x, lo, hi;
+
+    lo = x0 < 0 ? -x0 : 0;
+    hi = x0 + w > n ? n - x0 : w;
+    for(x = 0; x < lo && x < w; x++)
+        out[x] = cover_cell(p, type, y, x0 + x);
+    if(lo < hi){
+        if(type == 'h' && (y < 0 || y >= m))
+            memset(out + lo, 0, hi - lo);
+        else
+            memcpy(out + lo, p->row[((y % m) + m) % m] + x0 + lo, hi - lo);
+    }
+    for(x = hi > lo ? hi : lo; x < w; x++)
+        out[x] = cover_cell(p, type, y, x0 + x);
+}
+
+/**
+ * @brief Advance the tile of rows r0 to r1 - 1 and collums c0 to c1 - 1 gens generations in the scratch and write
+ * it into f.
+ * @param b the blocks
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - gens generations on
+ * @param type type of edge - hedge, torus, klein
+ * @param r0 first row of the tile
+ * @param r1 row after the tile
+ * @param c0 first collum of the tile
+ * @param c1 collum after the tile
+ * @param gens generations to advance, the width of the halo
+ */
+static void block_tile(struct block_t *b, struct grid_t *p, struct grid_t *f, char type, int r0, int r1, int c0, int c1, int gens){
+    int h = r1 - r0 + 2 * gens, w = c1 - c0 + 2 * gens, m = p->m_row, n = p->n_col;
+    int i, t, y0, y1, x0, x1, edge;
+    unsigned char *src, *dst;
+
+    /* for hedge the cells past the edge are never updated, so both scratch tiles must hold them dead */
+    edge = type == 'h' && (r0 < gens || r1 + gens > m || c0 < gens || c1 + gens > n);
+    for(i = 0; i < h; i++){
+        gather_row(p, type, r0 - gens + i, c0 - gens, w, b->scratch[0] + (size_t)i * b->stride + 1);
+        if(edge)
+            memcpy(b->scratch[1] + (size_t)i * b->stride + 1, b->scratch[0] + (size_t)i * b->stride + 1, w);
+    }
+
+    for(t = 1; t <= gens; t++){
+        src = b->scratch[(t - 1) & 1] + 1;
+        dst = b->scratch[t & 1] + 1;
+        y0 = t;
+        y1 = h - t;
+        x0 = t;
+        x1 = w - t;
+        if(type == 'h'){
+            if(y0 < gens - r0)
+                y0 = gens - r0;
+            if(y1 > gens - r0 + m)
+                y1 = gens - r0 + m;
+            if(x0 < gens - c0)
+                x0 = gens - c0;
+            if(x1 > gens - c0 + n)
+                x1 = gens - c0 + n;
+        }
+        for(i = y0; i < y1; i++)
+            kernel->row[rule.id](src + (size_t)(i - 1) * b->stride + x0, src + (size_t)i * b->stride + x0, src + (size_t)(i + 1) * b->stride + x0, dst + (size_t)i * b->stride + x0, x1 - x0);
+    }
+
+    dst = b->scratch[gens & 1] + 1 + (size_t)gens * b->stride + gens;
+    for(i = r0; i < r1; i++, dst += b->stride){
+        memcpy(f->row[i] + c0, dst, c1 - c0);
+        if((f->dirty || f->census) && memcmp(p->row[i] + c0, f->row[i] + c0, c1 - c0)){
+            if(f->dirty)
+                f->dirty[i] = 1;
+            if(f->census)
+                census_row(f->census, p->row[i], f->row[i], i, c0, c1 - c0);
+        }
+        if(f->hash)
+            rowhash_add(f->hash, f, i, flip_hash(p->row[i], f->row[i], c0, c1 - c0, f->hash->key));
+    }
+}
+
+/**
+ * @brief Advance the matrix in p gens generations into f, a tile at a time.
+ * @details p is only read, so every tile sees the same generation. The rows f marks dirty and the row hashes
+ * it keeps are for the change from p to f.
+ * @param b the blocks
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - gens generations on
+ * @param type type of edge - hedge, torus, klein
+ * @param gens generations to advance, 1 to the depth of the blocks
+ */
+void block_step(struct block_t *b, struct grid_t *p, struct grid_t *f, char type, int gens){
+    int r0, c0;
+
+    if(gens > b->depth)
+        gens = b->depth;
+    for(r0 = 0; r0 < b->m_row; r0 += b->height)
+        for(c0 = 0; c0 < b->n_col; c0 += b->width)
+            block_tile(b, p, f, type, r0, r0 + b->height < b->m_row ? r0 + b->height : b->m_row, c0, c0 + b->width < b->n_col ? c0 + b->width : b->n_col, gens);
+}
+
+/**
+ * @brief Advance the matrix gens generations, up to the depth of the blocks at a time.
+ * @details p and f are swapped once per sweep, so on return *p is the last generation.
+ * @param b the blocks
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param gens number of generations
+ */
+void block_run(struct block_t *b, struct grid_t **p, struct grid_t **f, char type, long gens){
+    struct grid_t *tmp;
+    int d;
+
+    for(; gens > 0; gens -= d){
+        d = gens < b->depth ? gens : b->depth;
+        block_step(b, *p, *f, type, d);
+        tmp = *p;
+        *p = *f;
+        *f = tmp;
+    }
+}
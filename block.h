@@ -0,0 +1,43 @@
+/**
+ * @file block.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the temporally blocked stepping of the byte matrix
+ */
+#ifndef BLOCK_H_
+#define BLOCK_H_
+
+struct grid_t;
+
+/** Generations each tile is advanced while it is in cache, unless -D is given. */
+#define BLOCK_DEPTH 16
+
+/** Largest number of generations a tile is advanced at once. */
+#define BLOCK_DEPTH_MAX 64
+
+/** Collums of a tile, the last tile of a row cut short. */
+#define BLOCK_WIDTH 2048
+
+/** Bytes the two scratch tiles may take together, well inside a level 2 cache. */
+#define BLOCK_CACHE (1024 * 1024)
+
+/**
+ * The matrix split into tiles of width by height cells. Each tile is copied with a halo of depth cells on every side
+ * into scratch and advanced depth generations there, the halo shrinking by a cell each generation.
+ */
+struct block_t {
+        int m_row;
+        int n_col;
+        int depth;			/* generations advanced per sweep of the matrix */
+        int height;			/* rows of a tile */
+        int width;			/* collums of a tile */
+        int stride;			/* bytes between the rows of a scratch tile */
+        unsigned char *scratch[2];	/* present and future tile with its halo */
+};
+
+struct block_t *init_block(int m_row, int n_col, int depth);
+void free_block(struct block_t *b);
+void block_step(struct block_t *b, struct grid_t *p, struct grid_t *f, char type, int gens);
+void block_run(struct block_t *b, struct grid_t **p, struct grid_t **f, char type, long gens);
+
+#endif
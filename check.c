@@ -0,0 +1,667 @@
+/**
+ * @file check.c
+ * @brief Check of every engine, kernel and edge of convey's game of life against a brute force reference, run by
+ * make check
+ * @details
+ * Random boards of a few sizes are stepped under a set of rules and every edge by a reference that counts the eight
+ * neighbours of each cell through cover(), and by each engine: the byte engine with every row kernel the CPU
+ * supports, alone, while counting its generations and on a thread pool, the tiled, blocked and dist engines with
+ * every kernel, the packed engine alone and on a thread pool, and each backend of liblife. Hashlife and the sparse
+ * plane are checked on a plane with no edge against a hedge board too large for the pattern to reach its edge.
+ * The kernel is picked before the rule is set, the order a program embedding the engines may use. Engines are
+ * compared after each run of 1, 2, 3 ... generations, and the first cell that differs is printed for each case that
+ * fails.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+#include "bitlife.h"
+#include "kernel.h"
+#include "rule.h"
+#include "pool.h"
+#include "tile.h"
+#include "block.h"
+#include "dist.h"
+#include "hashlife.h"
+#include "sparse.h"
+#include "engine.h"
+
+/** Generations each board is stepped. */
+#define CHECK_GENS 24
+
+/** Threads of the thread pool. */
+#define CHECK_THREADS 3
+
+/** Side of the soup checked on a plane with no edge. */
+#define CHECK_SOUP 20
+
+static const char *rules[] = { "B3/S23", "B36/S23", "B2/S", "B3678/S34678", "B1/S012", "B0/S8", "B45/S1358" };
+
+static const int shapes[][2] = { { 29, 37 }, { 64, 64 }, { 67, 130 } };
+
+static const char edges[] = { 'h', 't', 'k' };
+
+static const char *names[] = { ['h'] = "hedge", ['t'] = "torus", ['k'] = "klein" };
+
+static long cases, failed;
+
+/**
+ * @brief Step a board one generation the slow way, every neighbour found through cover().
+ * @param p present board, m rows of n cells
+ * @param f set to the next generation
+ * @param m rows
+ * @param n collums
+ * @param type type of edge - hedge, torus, klein
+ */
+static void reference(const unsigned char *p, unsigned char *f, int m, int n, char type){
+    int r, c, dr, dc, y, x, s;
+
+    for(r = 0; r < m; r++)
+        for(c = 0; c < n; c++){
+            s = 0;
+            for(dr = -1; dr <= 1; dr++)
+                for(dc = -1; dc <= 1; dc++){
+                    y = r + dr;
+                    x = c + dc;
+                    if((dr || dc) && cover(type, m, n, &y, &x))
+                        s += p[(long)y * n + x];
+                }
+            f[(long)r * n + c] = rule.next[p[(long)r * n + c]][s];
+        }
+}
+
+/**
+ * @brief Counts of generation gen of the reference.
+ * @param s set to the counts
+ * @param ref the generations
+ * @param gen the generation, above 0
+ * @param m rows
+ * @param n collums
+ */
+static void reference_stats(struct stats_t *s, const unsigned char *ref, int gen, int m, int n){
+    const unsigned char *p = ref + (long)(gen - 1) * m * n, *f = ref + (long)gen * m * n;
+    int r, c;
+
+    stats_clear(s);
+    for(r = 0; r < m; r++)
+        for(c = 0; c < n; c++){
+            s->births += f[r * n + c] && !p[r * n + c];
+            s->deaths += p[r * n + c] && !f[r * n + c];
+            if(!f[r * n + c])
+                continue;
+            s->population++;
+            s->top = r < s->top ? r : s->top;
+            s->bottom = r > s->bottom ? r : s->bottom;
+            s->left = c < s->left ? c : s->left;
+            s->right = c > s->right ? c : s->right;
+        }
+}
+
+/**
+ * @brief Compare a board to the reference, printing the first cell that differs.
+ * @param what engine and kernel
+ * @param type type of edge - hedge, torus, klein
+ * @param want board of the reference
+ * @param got board of the engine
+ * @param m rows
+ * @param n collums
+ * @param gen generation of the boards
+ */
+static void compare(const char *what, char type, const unsigned char *want, const unsigned char *got, int m, int n, long gen){
+    long i, size = (long)m * n;
+
+    cases++;
+    for(i = 0; i < size && want[i] == got[i]; i++)
+        ;
+    if(i == size)
+        return;
+    failed++;
+    printf("%s %s %s %dx%d generation %ld: cell %ld,%ld is %d, should be %d\n", what, rule.name, names[(int)type], m, n, gen, i / n, i % n, got[i], want[i]);
+}
+
+/**
+ * @brief Compare the census an engine kept to the live cells of each tile of the reference, printing the first tile
+ * that differs.
+ * @param what engine and kernel
+ * @param type type of edge - hedge, torus, klein
+ * @param s the census
+ * @param want board of the reference
+ * @param m rows
+ * @param n collums
+ * @param gen generation of the board
+ */
+static void compare_census(const char *what, char type, const struct census_t *s, const unsigned char *want, int m, int n, long gen){
+    int k, i, j, r, c, side;
+    long live;
+
+    cases++;
+    for(k = 0; k < CENSUS_LEVELS; k++){
+        side = 64 << 3 * k;
+        for(i = 0; i < s->rows[k]; i++)
+            for(j = 0; j < s->cols[k]; j++){
+                live = 0;
+                for(r = i * side; r < (i + 1) * side && r < m; r++)
+                    for(c = j * side; c < (j + 1) * side && c < n; c++)
+                        live += want[(long)r * n + c];
+                if(live == s->count[k][i * s->cols[k] + j])
+                    continue;
+                failed++;
+                printf("%s %s %s %dx%d generation %ld: census tile %d,%d of %d cells a side is %d, should be %ld\n", what, rule.name, names[(int)type], m, n, gen,
+                       i, j, side, s->count[k][i * s->cols[k] + j], live);
+                return;
+            }
+    }
+}
+
+/**
+ * @brief Copy a board into a matrix.
+ * @param g the matrix
+ * @param board m rows of n cells
+ */
+static void to_grid(struct grid_t *g, const unsigned char *board){
+    int r;
+
+    for(r = 0; r < g->m_row; r++)
+        memcpy(g->row[r], board + (long)r * g->n_col, g->n_col);
+}
+
+/**
+ * @brief Copy a matrix into a board.
+ * @param board set to m rows of n cells
+ * @param g the matrix
+ */
+static void from_grid(unsigned char *board, struct grid_t *g){
+    int r;
+
+    for(r = 0; r < g->m_row; r++)
+        memcpy(board + (long)r * g->n_col, g->row[r], g->n_col);
+}
+
+/**
+ * @brief Two matrices of the board size, the first holding generation 0. Leave if malloc failed.
+ * @param a set to the present matrix
+ * @param b set to the future matrix
+ * @param ref the generations
+ * @param m rows
+ * @param n collums
+ */
+static void start(struct grid_t **a, struct grid_t **b, const unsigned char *ref, int m, int n){
+    *a = init_matrix(m, n);
+    *b = init_matrix(m, n);
+    if(!*a || !*b){
+        printf("Matrix Initialization has failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    to_grid(*a, ref);
+}
+
+/**
+ * @brief Census of a board for a pair of matrices, counted from the first. Leave if malloc failed.
+ * @param a present matrix
+ * @param b future matrix
+ */
+static struct census_t *start_census(struct grid_t *a, struct grid_t *b){
+    struct census_t *s = init_census(a->m_row, a->n_col);
+
+    if(!s){
+        printf("Census Initialization has failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    census_grid(s, a);
+    a->census = b->census = s;
+    return s;
+}
+
+/**
+ * @brief Byte engine, one generation at a time: the edge function of the type, then mid(). Counting, a hedge board
+ * is stepped by hedge_box() instead unless the rule has B0, and the counts are compared too. The census is compared
+ * after every generation.
+ * @param ref the generations
+ * @param m rows
+ * @param n collums
+ * @param type type of edge - hedge, torus, klein
+ * @param count set to keep the counts of each generation
+ * @param got board to compare
+ */
+static void check_byte(const unsigned char *ref, int m, int n, char type, int count, unsigned char *got){
+    struct grid_t *a, *b, *tmp;
+    struct stats_t sa, sb, want;
+    struct census_t *s;
+    char what[64];
+    int g;
+
+    snprintf(what, sizeof(what), "byte/%s%s", kernel->name, count ? " counting" : "");
+    start(&a, &b, ref, m, n);
+    s = start_census(a, b);
+    if(count){
+        stats_grid(&sa, a);
+        stats_clear(&sb);
+        a->stats = &sa;
+        b->stats = &sb;
+    }
+    for(g = 1; g <= CHECK_GENS; g++){
+        if(count && type == 'h' && !(rule.birth & 1))
+            hedge_box(a, b);
+        else{
+            if(type == 'h')
+                hedge(a, b);
+            else if(type == 't')
+                torus(a, b);
+            else
+                klein(a, b);
+            mid(a, b);
+        }
+        tmp = a;
+        a = b;
+        b = tmp;
+        from_grid(got, a);
+        compare(what, type, ref + (long)g * m * n, got, m, n, g);
+        compare_census(what, type, s, ref + (long)g * m * n, m, n, g);
+        if(!count)
+            continue;
+        reference_stats(&want, ref, g, m, n);
+        cases++;
+        if(memcmp(&want, a->stats, sizeof(want))){
+            failed++;
+            printf("%s %s %s %dx%d generation %d: counts %ld %ld %ld rows %d to %d collums %d to %d, should be %ld %ld %ld rows %d to %d collums %d to %d\n",
+                   what, rule.name, names[(int)type], m, n, g, a->stats->population, a->stats->births, a->stats->deaths, a->stats->top, a->stats->bottom,
+                   a->stats->left, a->stats->right, want.population, want.births, want.deaths, want.top, want.bottom, want.left, want.right);
+        }
+    }
+    free_census(s);
+    free_matrix(a);
+    free_matrix(b);
+}
+
+/**
+ * @brief Hand each run of live cells of a matrix to cell, as the dist workers load their rectangles.
+ * @param arg the matrix
+ * @param cell called with ctx and each run of live cells
+ * @param ctx passed to cell
+ * @return number of live cells
+ */
+static long grid_load(void *arg, cell_fn cell, void *ctx){
+    struct grid_t *a = arg;
+    long cells = 0;
+    int r, c, k;
+
+    for(r = 0; r < a->m_row; r++)
+        for(c = 0; c < a->n_col; c += k){
+            for(k = 0; c + k < a->n_col && a->row[r][c+k]; k++)
+                ;
+            if(k)
+                cell(ctx, c, r, k);
+            cells += k;
+            if(!k)
+                k = 1;
+        }
+    return cells;
+}
+
+/**
+ * @brief Engines that step many generations at once: the byte and packed engines on the thread pool, and the blocked
+ * and dist engines. The census is compared too, but for dist, which keeps none. The dist board is only gathered
+ * and compared after every other chunk and the last, the rest only being waited for.
+ * @param ref the generations
+ * @param m rows
+ * @param n collums
+ * @param type type of edge - hedge, torus, klein
+ * @param engine "pool", "packed pool", "blocked", "dist shm" or "dist tcp"
+ * @param got board to compare
+ */
+static void check_chunks(const unsigned char *ref, int m, int n, char type, const char *engine, unsigned char *got){
+    struct grid_t *a, *b, *tmp;
+    struct bitgrid_t *p = NULL, *q = NULL;
+    struct pool_t *pool = NULL;
+    struct block_t *blocks = NULL;
+    struct dist_t *dist = NULL;
+    struct census_t *s = NULL;
+    char what[64];
+    int g, chunk, i;
+
+    snprintf(what, sizeof(what), "%s/%s", engine, kernel->name);
+    start(&a, &b, ref, m, n);
+    if(strncmp(engine, "dist", 4))
+        s = start_census(a, b);
+    if(!strcmp(engine, "pool") || !strcmp(engine, "packed pool"))
+        pool = pool_create(CHECK_THREADS, a->stride, BIT_WORDS(n));
+    if(!strcmp(engine, "packed pool")){
+        p = init_bitgrid(m, n);
+        q = init_bitgrid(m, n);
+        if(p && q){
+            bit_from_grid(p, a);
+            p->census = q->census = s;
+        }
+    }
+    if(!strcmp(engine, "blocked"))
+        blocks = init_block(m, n, 5);
+    if(!strncmp(engine, "dist", 4))
+        dist = dist_open(m, n, type, 2, 2, engine + 5, grid_load, a);
+    if(!pool && !blocks && !dist){
+        printf("%s could not be started.\n", engine);
+        exit(EXIT_FAILURE);
+    }
+
+    for(g = 0, chunk = 1; g < CHECK_GENS; g += chunk, chunk++){
+        if(chunk > CHECK_GENS - g)
+            chunk = CHECK_GENS - g;
+        if(p)
+            pool_bit_step(pool, &p, &q, type, chunk);
+        else if(pool)
+            pool_step(pool, &a, &b, type, chunk);
+        else if(blocks)
+            for(i = 0; i < chunk; i += blocks->depth){
+                block_step(blocks, a, b, type, chunk - i);
+                tmp = a;
+                a = b;
+                b = tmp;
+            }
+        else if(dist_step(dist, chunk % 2 && g + chunk < CHECK_GENS ? NULL : a, chunk)){
+            printf("A worker process has failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        if(dist && chunk % 2 && g + chunk < CHECK_GENS)
+            continue;
+        if(p)
+            bit_to_grid(a, p);
+        from_grid(got, a);
+        compare(what, type, ref + (long)(g + chunk) * m * n, got, m, n, g + chunk);
+        if(s)
+            compare_census(what, type, s, ref + (long)(g + chunk) * m * n, m, n, g + chunk);
+    }
+    if(s)
+        free_census(s);
+    if(pool)
+        pool_destroy(pool);
+    if(p){
+        free_bitgrid(p);
+        free_bitgrid(q);
+    }
+    if(blocks)
+        free_block(blocks);
+    if(dist)
+        dist_close(dist);
+    free_matrix(a);
+    free_matrix(b);
+}
+
+/**
+ * @brief Tiled engine and packed engine, one generation at a time, with their census. The packed one counts its
+ * census itself.
+ * @param ref the generations
+ * @param m rows
+ * @param n collums
+ * @param type type of edge - hedge, torus, klein
+ * @param packed set for the packed engine, otherwise the tiled one
+ * @param got board to compare
+ */
+static void check_single(const unsigned char *ref, int m, int n, char type, int packed, unsigned char *got){
+    struct grid_t *a, *b, *tmp;
+    struct bitgrid_t *p = NULL, *q = NULL, *btmp;
+    struct tiles_t *tiles = NULL;
+    struct census_t *s;
+    char what[64];
+    int g;
+
+    snprintf(what, sizeof(what), packed ? "packed" : "tiled/%s", kernel->name);
+    start(&a, &b, ref, m, n);
+    s = start_census(a, b);
+    if(packed){
+        p = init_bitgrid(m, n);
+        q = init_bitgrid(m, n);
+        if(p && q){
+            bit_from_grid(p, a);
+            /* started over from the bits, so census_bits() is checked too */
+            census_bits(s, p);
+            p->census = q->census = s;
+        }
+    }
+    else
+        tiles = init_tiles(m, n);
+    if(packed ? !p || !q : !tiles){
+        printf("Matrix Initialization has failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(g = 1; g <= CHECK_GENS; g++){
+        if(packed){
+            bit_step(p, q, type);
+            btmp = p;
+            p = q;
+            q = btmp;
+            bit_to_grid(a, p);
+        }
+        else{
+            tile_step(tiles, a, b, type);
+            tmp = a;
+            a = b;
+            b = tmp;
+        }
+        from_grid(got, a);
+        compare(what, type, ref + (long)g * m * n, got, m, n, g);
+        compare_census(what, type, s, ref + (long)g * m * n, m, n, g);
+    }
+    free_census(s);
+    if(packed){
+        free_bitgrid(p);
+        free_bitgrid(q);
+    }
+    else
+        free_tiles(tiles);
+    free_matrix(a);
+    free_matrix(b);
+}
+
+/**
+ * @brief A pattern whose last cell falls past the right edge of a hedge board, which should fail to load and leave
+ * the board dead.
+ * @param e the engine, its board dead
+ * @param what backend and kernel
+ * @param m rows
+ * @param n collums
+ * @param got board to read into
+ */
+static void check_load(struct life_engine_t *e, const char *what, int m, int n, unsigned char *got){
+    FILE *fp = tmpfile();
+    long i, loaded;
+
+    if( !(fp) ){
+        printf("Pattern file could not be made.\n");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(fp, "#Life 1.06\n0 0\n0 1\n1 0\n");
+    rewind(fp);
+    loaded = life_load(e, fp, n - 1, 0);
+    fclose(fp);
+    life_read_region(e, 0, 0, m, n, got);
+    for(i = 0; i < (long)m * n && !got[i]; i++)
+        ;
+    cases++;
+    if(loaded == -1 && i == (long)m * n)
+        return;
+    failed++;
+    printf("%s %dx%d: a load past the edge returned %ld and left %s\n", what, m, n, loaded, i < (long)m * n ? "live cells" : "the board dead");
+}
+
+/**
+ * @brief Each backend of liblife through engine.h, loaded and read back by region. Recording as it steps, each is
+ * then set back through its history every few generations down to the first and run on again from there. On hedge
+ * boards a load that fails is first checked to leave no cells behind.
+ * @param ref the generations
+ * @param m rows
+ * @param n collums
+ * @param type type of edge - hedge, torus, klein
+ * @param got board to compare
+ */
+static void check_library(const unsigned char *ref, int m, int n, char type, unsigned char *got){
+    struct life_engine_t *e;
+    const char *backend;
+    char what[64];
+    int i, g, chunk;
+
+    for(i = 0; (backend = life_backend(i)); i++){
+        snprintf(what, sizeof(what), "liblife %s/%s", backend, kernel->name);
+        if(!(e = life_create(m, n, type, backend))){
+            printf("%s could not be started.\n", what);
+            exit(EXIT_FAILURE);
+        }
+        if(type == 'h')
+            check_load(e, what, m, n, got);
+        if(life_record(e, (size_t)1 << 20, 8) || life_write_region(e, 0, 0, m, n, ref)){
+            printf("%s could not be started.\n", what);
+            exit(EXIT_FAILURE);
+        }
+        for(g = 0, chunk = 1; g < CHECK_GENS; g += chunk, chunk++){
+            if(chunk > CHECK_GENS - g)
+                chunk = CHECK_GENS - g;
+            if(life_step_n(e, chunk)){
+                printf("%s could not step %d generations.\n", what, chunk);
+                exit(EXIT_FAILURE);
+            }
+            life_read_region(e, 0, 0, m, n, got);
+            compare(what, type, ref + (long)(g + chunk) * m * n, got, m, n, g + chunk);
+        }
+        for(g = CHECK_GENS; g >= 0; g -= 3){
+            if(life_seek(e, g)){
+                printf("%s could not seek generation %d, holding %ld on.\n", what, g, life_oldest(e));
+                exit(EXIT_FAILURE);
+            }
+            life_read_region(e, 0, 0, m, n, got);
+            compare(what, type, ref + (long)g * m * n, got, m, n, g);
+        }
+        g += 3;
+        life_step_n(e, CHECK_GENS - g);
+        life_read_region(e, 0, 0, m, n, got);
+        compare(what, type, ref + (long)CHECK_GENS * m * n, got, m, n, CHECK_GENS);
+        life_destroy(e);
+    }
+}
+
+/**
+ * @brief Hashlife and the sparse plane, from a soup in the middle of a hedge board the soup can not grow out of in
+ * CHECK_GENS generations. Hashlife also runs with a cap of a few nodes, so garbage is collected in the middle of
+ * every step.
+ */
+static void check_plane(void){
+    int m = CHECK_SOUP + 2 * CHECK_GENS + 4, n = m, g, chunk, r, c;
+    unsigned char *ref = calloc((size_t)(CHECK_GENS + 1) * m * n, 1), *got = malloc((size_t)m * n);
+    struct grid_t *a = init_matrix(m, n);
+    struct hashlife_t *hl = hl_create(0), *capped = hl_create(64 * sizeof(struct node_t));
+    struct sparse_t *s = init_sparse();
+
+    if(!ref || !got || !a || !hl || !capped || !s){
+        printf("Matrix Initialization has failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(r = (m - CHECK_SOUP) / 2; r < (m + CHECK_SOUP) / 2; r++)
+        for(c = (n - CHECK_SOUP) / 2; c < (n + CHECK_SOUP) / 2; c++)
+            if((ref[r * n + c] = rand() % 100 < 35)){
+                hl_set_cell(hl, c, r);
+                hl_set_cell(capped, c, r);
+                if(sparse_add(s, c, r)){
+                    printf("Sparse plane allocation has failed.\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+    for(g = 1; g <= CHECK_GENS; g++)
+        reference(ref + (long)(g - 1) * m * n, ref + (long)g * m * n, m, n, 'h');
+
+    for(g = 0, chunk = 1; g < CHECK_GENS; g += chunk, chunk++){
+        if(chunk > CHECK_GENS - g)
+            chunk = CHECK_GENS - g;
+        hl_jump(hl, chunk);
+        hl_to_grid(hl, a, 0, 0);
+        from_grid(got, a);
+        compare("hashlife", 'h', ref + (long)(g + chunk) * m * n, got, m, n, g + chunk);
+        hl_jump(capped, chunk);
+        hl_to_grid(capped, a, 0, 0);
+        from_grid(got, a);
+        compare("hashlife capped", 'h', ref + (long)(g + chunk) * m * n, got, m, n, g + chunk);
+    }
+    if(!capped->collections){
+        printf("hashlife capped: no garbage was collected\n");
+        failed++;
+    }
+    for(g = 1; g <= CHECK_GENS; g++){
+        if(sparse_step(s)){
+            printf("Sparse plane allocation has failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        sparse_to_grid(a, s, 0, 0);
+        from_grid(got, a);
+        compare("sparse", 'h', ref + (long)g * m * n, got, m, n, g);
+    }
+    hl_destroy(hl);
+    hl_destroy(capped);
+    free_sparse(s);
+    free_matrix(a);
+    free(ref);
+    free(got);
+}
+
+/**
+ * @brief Run every check and report how many failed.
+ * @return EXIT_SUCCESS if every check passed
+ */
+int main(void){
+    const struct kernel_t *k;
+    unsigned char *ref, *got;
+    int i, j, e, g, m, n;
+
+    /* the first engine created picks a kernel of its own, so it is done before the kernels are picked below */
+    life_destroy(life_create(1, 1, 'h', NULL));
+    srand(1);
+
+    for(k = kernels; k->name; k++){
+        if(!k->supported())
+            continue;
+        kernel_select(k->name);
+        for(i = 0; i < (int)(sizeof(rules) / sizeof(rules[0])); i++){
+            rule_set(rules[i]);
+            for(j = 0; j < (int)(sizeof(shapes) / sizeof(shapes[0])); j++){
+                m = shapes[j][0];
+                n = shapes[j][1];
+                ref = malloc((size_t)(CHECK_GENS + 1) * m * n);
+                got = malloc((size_t)m * n);
+                if(!ref || !got){
+                    printf("Matrix Initialization has failed.\n");
+                    exit(EXIT_FAILURE);
+                }
+                for(e = 0; e < 3; e++){
+                    for(g = 0; g < m * n; g++)
+                        ref[g] = rand() % 100 < 35;
+                    for(g = 1; g <= CHECK_GENS; g++)
+                        reference(ref + (long)(g - 1) * m * n, ref + (long)g * m * n, m, n, edges[e]);
+
+                    check_byte(ref, m, n, edges[e], 0, got);
+                    check_byte(ref, m, n, edges[e], 1, got);
+                    check_chunks(ref, m, n, edges[e], "pool", got);
+                    check_single(ref, m, n, edges[e], 0, got);
+                    check_chunks(ref, m, n, edges[e], "blocked", got);
+                    check_chunks(ref, m, n, edges[e], "dist shm", got);
+                    check_chunks(ref, m, n, edges[e], "dist tcp", got);
+                    check_library(ref, m, n, edges[e], got);
+                    if(k != kernels)
+                        continue;
+                    check_single(ref, m, n, edges[e], 1, got);
+                    check_chunks(ref, m, n, edges[e], "packed pool", got);
+                }
+                free(ref);
+                free(got);
+            }
+            if(k == kernels && !(rule.birth & 1))
+                check_plane();
+        }
+    }
+
+    if(failed)
+        printf("%ld of %ld checks failed\n", failed, cases);
+    else
+        printf("all %ld checks passed\n", cases);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
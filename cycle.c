@@ -0,0 +1,179 @@
+/**
+ * @file cycle.c
+ * @brief Finds when the board of convey's game of life starts repeating
+ * @details 
+ * Each row is hashed as the sum of its groups of cells, sixteen of a byte row or a word of a packed row, each taken
+ * as a number and times the key of the group. The hash of the board is the XOR of the row hashes, each mixed with
+ * its row number. The steps keep both up to date: the difference of each group that changes times its key is added
+ * to its row, and a row that changed swaps its old mixed hash for the new one in the board hash, so rows that do
+ * not change cost nothing and a settled board nothing at all.
+ * Each generation the board hash is looked up among the hashes of the latest generations. A match means the board
+ * is the same as it was that many generations ago: a still life has period 1, an oscillator its period. A thread
+ * pool leaves the board hash of each generation of a job in a trail, which is looked up once the job is done.
+ * Two boards sharing a 64 bit hash by chance is taken as too unlikely to matter.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "life.h"
+#include "bitlife.h"
+#include "cycle.h"
+
+/** 
+ * @brief Creates the row hashes, their keys and an empty ring. Return adress of the struct is sussesful or NULL
+ * if malloc failed.
+ * @details There is a key for each group of sixteen collums of a byte row, more than the words of a packed row, and
+ * one more for the ghost collum.
+ * @param m_row number of rows of the board
+ * @param n_col number of collums of the board
+ */
+struct cycle_t *init_cycle(int m_row, int n_col){
+    struct cycle_t *c = malloc(sizeof(struct cycle_t));
+    int g, groups = n_col / 16 + 2;
+
+    if(!c)
+        return NULL;
+    c->hash.row = calloc(m_row, sizeof(uint64_t));
+    c->hash.even = NULL;
+    c->hash.trail = c->trail;
+    c->hash.key = malloc(groups * sizeof(uint64_t));
+    if(!c->hash.row || !c->hash.key){
+        free(c->hash.row);
+        free(c->hash.key);
+        free(c);
+        return NULL;
+    }
+    for(g = 0; g < groups; g++)
+        c->hash.key[g] = hash_key(g) | 1;
+    c->m_row = m_row;
+    cycle_reset(c);
+    return c;
+}
+
+/** 
+ * @brief Free the row hashes and the struct.
+ * @param c the hashes
+ */
+void free_cycle(struct cycle_t *c){
+    free(c->hash.row);
+    free(c->hash.key);
+    free(c);
+}
+
+/** 
+ * @brief Empty the ring, for a new board.
+ * @param c the hashes
+ */
+void cycle_reset(struct cycle_t *c){
+    c->used = 0;
+    c->next = 0;
+    c->found = -1;
+}
+
+/** 
+ * @brief Hash the board from row hashes set by the caller and empty the ring, before the first step.
+ * @param c the hashes
+ */
+void cycle_rows(struct cycle_t *c){
+    int r;
+
+    c->hash.board = 0;
+    c->hash.moved[0] = c->hash.moved[1] = 0;
+    for(r = 0; r < c->m_row; r++)
+        c->hash.board ^= row_mix(c->hash.row[r], r);
+    cycle_reset(c);
+}
+
+/** 
+ * @brief Hash every row of the matrix and empty the ring, before the first step.
+ * @param c the hashes
+ * @param g the matrix
+ */
+void cycle_grid(struct cycle_t *c, struct grid_t *g){
+    int r, i;
+
+    for(r = 0; r < g->m_row; r++){
+        c->hash.row[r] = 0;
+        for(i = 0; i < g->n_col; i++)
+            if(g->row[r][i])
+                c->hash.row[r] += ((uint64_t)1 << (i % 16)) * c->hash.key[i / 16];
+    }
+    c->hash.even = g;
+    cycle_rows(c);
+}
+
+/** 
+ * @brief Hash every row of the packed matrix and empty the ring, before the first step.
+ * @param c the hashes
+ * @param b the matrix
+ */
+void cycle_bits(struct cycle_t *c, struct bitgrid_t *b){
+    const uint64_t *w;
+    int r, i;
+
+    for(r = 0; r < b->m_row; r++){
+        c->hash.row[r] = 0;
+        w = b->word + (long)r * b->words;
+        for(i = 0; i < b->words; i++)
+            c->hash.row[r] += w[i] * c->hash.key[i];
+    }
+    c->hash.even = b;
+    cycle_rows(c);
+}
+
+/** 
+ * @brief Look for a board hash among the latest generations, and add it if it is not there.
+ * @param c the hashes
+ * @param h hash of the board
+ * @param generation generation of the board
+ * @return the period if the board was seen within the last CYCLE_RING generations, otherwise 0
+ */
+static long seen(struct cycle_t *c, uint64_t h, long generation){
+    int i;
+
+    for(i = 0; i < c->used; i++)
+        if(c->ring[i] == h){
+            c->found = generation;
+            return generation - c->gen[i];
+        }
+
+    c->ring[c->next] = h;
+    c->gen[c->next] = generation;
+    c->next = (c->next + 1) % CYCLE_RING;
+    if(c->used < CYCLE_RING)
+        c->used++;
+    return 0;
+}
+
+/** 
+ * @brief Look for the board among the latest generations, after a step on one thread.
+ * @details The changes the step made to the board hash are folded in first, a lookup in the ring being all the
+ * rest.
+ * @param c the hashes
+ * @param generation generation of the board
+ * @return the period if the board was seen within the last CYCLE_RING generations, otherwise 0
+ */
+long cycle_check(struct cycle_t *c, long generation){
+    c->hash.board ^= c->hash.moved[0] ^ c->hash.moved[1];
+    c->hash.moved[0] = c->hash.moved[1] = 0;
+    return seen(c, c->hash.board, generation);
+}
+
+/** 
+ * @brief Look for each generation of a thread pool job among the latest generations, from the trail it left.
+ * @param c the hashes
+ * @param generation generation of the board before the job
+ * @param gens generations the job ran, at most CYCLE_RING
+ * @return the period of the first generation that repeated an earlier one, otherwise 0
+ */
+long cycle_trail(struct cycle_t *c, long generation, long gens){
+    long g, period = 0;
+
+    for(g = 0; g < gens && !period; g++)
+        period = seen(c, c->trail[g], generation + g + 1);
+    return period;
+}
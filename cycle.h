@@ -0,0 +1,43 @@
+/**
+ * @file cycle.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for finding when the board starts repeating
+ */
+#ifndef CYCLE_H_
+#define CYCLE_H_
+
+#include <stdint.h>
+#include "life.h"
+
+struct bitgrid_t;
+
+/** Hashes of this many of the latest generations are kept, so cycles of up to this period are found. */
+#define CYCLE_RING 64
+
+/**
+ * Row hashes of the board and the hashes of the latest generations.
+ * The matrices being stepped share hash, so each step keeps it up to date from the cells that flip.
+ * A thread pool job stepping them may run at most CYCLE_RING generations, the length of trail.
+ */
+struct cycle_t {
+        struct rowhash_t hash;
+        int m_row;
+        uint64_t ring[CYCLE_RING];	/* hashes of the latest generations, oldest overwritten first */
+        long gen[CYCLE_RING];		/* generation of each hash in ring */
+        int used;
+        int next;
+        uint64_t trail[CYCLE_RING];	/* board hash after each generation of a thread pool job */
+        long found;			/* generation that repeated an earlier one, once one has */
+};
+
+struct cycle_t *init_cycle(int m_row, int n_col);
+void free_cycle(struct cycle_t *c);
+void cycle_reset(struct cycle_t *c);
+void cycle_grid(struct cycle_t *c, struct grid_t *g);
+void cycle_bits(struct cycle_t *c, struct bitgrid_t *b);
+void cycle_rows(struct cycle_t *c);
+long cycle_check(struct cycle_t *c, long generation);
+long cycle_trail(struct cycle_t *c, long generation, long gens);
+
+#endif
@@ -0,0 +1,939 @@
+/**
+ * @file dist.c
+ * @brief Stepping convey's game of life across worker processes
+ * @details
+ * The matrix is split into a grid of rectangles, each owned and stepped by a
+ * worker process forked from the main one. A worker keeps its rectangle in a
+ * matrix of its own whose ghost border is the halo: the cells of the other
+ * rectangles around it. Each generation a worker hands the cells on the
+ * boundary of its rectangle to its peers, steps the middle of its rectangle
+ * with mid() while they travel, then waits for the boundary cells of its
+ * peers, fills the halo from them and steps its edge with edge().
+ *
+ * Which boundary cell fills which halo cell is worked out once, through the
+ * plane the edge type makes of the matrix (see cover()). A halo cell past the
+ * edge of a torus or klein board is filled from the worker holding the cell it
+ * wraps to, a klein wrap reading the flipped rows, so the wrap of torus() and
+ * klein() becomes links between workers. Past the edge of a hedge board the
+ * halo is dead.
+ *
+ * The boundary cells travel over a link. The shm link keeps them in POSIX
+ * shared memory, two generations deep, with a generation count per worker
+ * saying when they are ready. The tcp link sends them over a socket on the
+ * loopback between each pair of peers, standing in for workers on separate
+ * machines.
+ *
+ * No process holds the whole board. Each worker reads the patterns itself and
+ * keeps the cells that land in its rectangle, clipped and wrapped as cover()
+ * says. The main process talks to each worker over a socket pair: it orders a
+ * number of generations, and the worker answers once they are run, sending its
+ * rectangle too only when the order asks for the board.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "life.h"
+#include "dist.h"
+
+/**
+ * Head of the memory the shm link shares. It is followed by a generation count per worker and the boundary cells of
+ * every worker for two generations.
+ */
+struct shared_t {
+        size_t ready;			/* offset of the generation counts, boundary cells of generation g - 1 are ready when it is g */
+        size_t rings;			/* offset of the boundary cells, generation g of worker i at (g % 2 * workers + i) * ring_max */
+};
+
+/** A worker loading its rectangle, handed every run of live cells of the board. */
+struct clip_t {
+        struct dist_t *d;
+        struct part_t *w;
+        long outside;			/* runs past the edge of a hedge board */
+};
+
+/**
+ * @brief Boundary cells of a rectangle: its first and last row, then its first and last collum between them.
+ * @param h rows of the rectangle
+ * @param w collums of the rectangle
+ */
+static int ring_size(int h, int w){
+    return 2 * (h + w);
+}
+
+/**
+ * @brief Index among the boundary cells of the cell at row y and collum x of a rectangle.
+ * @param h rows of the rectangle
+ * @param w collums of the rectangle
+ * @param y row in the rectangle, on its boundary
+ * @param x collum in the rectangle, on its boundary
+ */
+static int ring_index(int h, int w, int y, int x){
+    if(y == 0)
+        return x;
+    if(y == h - 1)
+        return w + x;
+    if(x == 0)
+        return 2 * w + y - 1;
+    return 2 * w + h - 2 + y - 1;
+}
+
+/**
+ * @brief Copy the boundary cells of the present part of a worker into its ring.
+ * @param w the worker
+ */
+static void fill_ring(struct part_t *w){
+    struct grid_t *a = w->a;
+    int y, h = a->m_row, n = a->n_col;
+
+    memcpy(w->ring, a->row[0], n);
+    memcpy(w->ring + n, a->row[h-1], n);
+    for(y = 1; y < h - 1; y++){
+        w->ring[2 * n + y - 1] = a->row[y][0];
+        w->ring[2 * n + h - 2 + y - 1] = a->row[y][n-1];
+    }
+}
+
+/**
+ * @brief Ghost cell k of a part of h by w cells: the row above, the row below, then the collum left and right.
+ * @param k index of the ghost cell
+ * @param h rows of the part
+ * @param w collums of the part
+ * @param y set to its row, -1 to h
+ * @param x set to its collum, -1 to w
+ */
+static void ghost_at(int k, int h, int w, int *y, int *x){
+    if(k < w + 2){
+        *y = -1;
+        *x = k - 1;
+    }
+    else if(k < 2 * (w + 2)){
+        *y = h;
+        *x = k - (w + 2) - 1;
+    }
+    else if(k < 2 * (w + 2) + h){
+        *y = k - 2 * (w + 2);
+        *x = -1;
+    }
+    else{
+        *y = k - 2 * (w + 2) - h;
+        *x = w;
+    }
+}
+
+/**
+ * @brief Index of the band holding a row or collum.
+ * @param bounds first row or collum of each band, then the row or collum after the last
+ * @param v the row or collum
+ */
+static int band(const int *bounds, int v){
+    int i = 0;
+
+    while(v >= bounds[i+1])
+        i++;
+    return i;
+}
+
+/**
+ * @brief Work out the boundary cell of which peer fills each ghost cell of a worker.
+ * @param d the workers
+ * @param w the worker
+ * @return 0 if it worked, otherwise -1
+ */
+static int map_halo(struct dist_t *d, struct part_t *w){
+    int h = w->r1 - w->r0, n = w->c1 - w->c0, k, y, x, i, j, q, *slot;
+
+    w->n_ghost = 2 * (n + 2) + 2 * h;
+    w->src = malloc(w->n_ghost * sizeof(int));
+    w->peer = malloc(d->workers * sizeof(int));
+    w->from = calloc(d->workers, sizeof(unsigned char *));
+    slot = malloc(d->workers * sizeof(int));
+    if(!w->src || !w->peer || !w->from || !slot){
+        free(slot);
+        return -1;
+    }
+    for(q = 0; q < d->workers; q++)
+        slot[q] = -1;
+    w->n_peer = 0;
+
+    for(k = 0; k < w->n_ghost; k++){
+        ghost_at(k, h, n, &y, &x);
+        y += w->r0;
+        x += w->c0;
+        if(!cover(d->type, d->m_row, d->n_col, &y, &x)){
+            w->src[k] = -1;
+            continue;
+        }
+        i = band(d->rows, y);
+        j = band(d->cols, x);
+        q = i * d->across + j;
+        if(slot[q] < 0){
+            slot[q] = w->n_peer;
+            w->peer[w->n_peer++] = q;
+        }
+        w->src[k] = slot[q] * d->ring_max + ring_index(d->rows[i+1] - d->rows[i], d->cols[j+1] - d->cols[j], y - d->rows[i], x - d->cols[j]);
+    }
+    free(slot);
+    return 0;
+}
+
+/**
+ * @brief Fill the ghost border of the present part of a worker from the boundary cells of its peers.
+ * @param d the workers
+ * @param w the worker
+ */
+static void fill_halo(struct dist_t *d, struct part_t *w){
+    int k, y, x, s, h = w->a->m_row, n = w->a->n_col;
+
+    for(k = 0; k < w->n_ghost; k++){
+        ghost_at(k, h, n, &y, &x);
+        s = w->src[k];
+        w->a->row[y][x] = s < 0 ? 0 : w->from[s / d->ring_max][s % d->ring_max];
+    }
+}
+
+/**
+ * @brief Write all of a buffer to a socket.
+ * @param fd the socket
+ * @param buf the bytes
+ * @param size number of bytes
+ * @return 0 if it worked, otherwise -1
+ */
+static int write_all(int fd, const void *buf, size_t size){
+    const unsigned char *p = buf;
+    ssize_t k;
+
+    while(size){
+        k = send(fd, p, size, MSG_NOSIGNAL);
+        if(k < 0 && errno == EINTR)
+            continue;
+        if(k <= 0)
+            return -1;
+        p += k;
+        size -= k;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read all of a buffer from a socket.
+ * @param fd the socket
+ * @param buf the bytes
+ * @param size number of bytes
+ * @return 0 if it worked, -1 if the socket failed or closed first
+ */
+static int read_all(int fd, void *buf, size_t size){
+    unsigned char *p = buf;
+    ssize_t k;
+
+    while(size){
+        k = recv(fd, p, size, 0);
+        if(k < 0 && errno == EINTR)
+            continue;
+        if(k <= 0)
+            return -1;
+        p += k;
+        size -= k;
+    }
+    return 0;
+}
+
+/* shm link */
+
+/**
+ * @brief Map the shared memory: the head, the generation counts and the boundary cells.
+ * @param d the workers
+ * @return 0 if it worked, otherwise -1
+ */
+static int shm_open_link(struct dist_t *d){
+    struct shared_t *s;
+    char name[64];
+    size_t ready, rings, size;
+    int fd, i;
+
+    ready = (sizeof(struct shared_t) + 63) / 64 * 64;
+    rings = (ready + d->workers * sizeof(atomic_long) + 63) / 64 * 64;
+    size = rings + 2 * (size_t)d->workers * d->ring_max;
+
+    snprintf(name, sizeof(name), "/life-%ld", (long)getpid());
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd < 0)
+        return -1;
+    /* the workers inherit the mapping, so the name is not needed past here */
+    shm_unlink(name);
+    if(ftruncate(fd, size)){
+        close(fd);
+        return -1;
+    }
+    s = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(s == MAP_FAILED)
+        return -1;
+
+    s->ready = ready;
+    s->rings = rings;
+    for(i = 0; i < d->workers; i++)
+        atomic_init((atomic_long *)((char *)s + ready) + i, 0);
+    d->shared = s;
+    d->shared_size = size;
+    return 0;
+}
+
+/**
+ * @brief Nothing to do once a worker has started, the memory was mapped before.
+ * @param d the workers
+ * @param w the worker
+ */
+static int shm_attach(struct dist_t *d, struct part_t *w){
+    return 0;
+}
+
+/**
+ * @brief Copy the boundary cells of a worker into its slot for this generation and say they are ready.
+ * @details Slots alternate between two generations. A peer only writes a slot again two generations on, once it has
+ * the boundary cells of this worker for the generation between, so it never writes a slot still being read.
+ * @param d the workers
+ * @param w the worker
+ */
+static int shm_publish(struct dist_t *d, struct part_t *w){
+    struct shared_t *s = d->shared;
+    atomic_long *ready = (atomic_long *)((char *)s + s->ready);
+    unsigned char *rings = (unsigned char *)s + s->rings;
+
+    memcpy(rings + ((w->generation & 1) * d->workers + w->me) * (size_t)d->ring_max, w->ring, ring_size(w->r1 - w->r0, w->c1 - w->c0));
+    atomic_store_explicit(&ready[w->me], w->generation + 1, memory_order_release);
+    return 0;
+}
+
+/**
+ * @brief Wait for the boundary cells of every peer for this generation and point at their slots.
+ * @param d the workers
+ * @param w the worker
+ */
+static int shm_collect(struct dist_t *d, struct part_t *w){
+    struct shared_t *s = d->shared;
+    atomic_long *ready = (atomic_long *)((char *)s + s->ready);
+    unsigned char *rings = (unsigned char *)s + s->rings;
+    int p, q;
+
+    for(p = 0; p < w->n_peer; p++){
+        q = w->peer[p];
+        while(atomic_load_explicit(&ready[q], memory_order_acquire) <= w->generation)
+            sched_yield();
+        w->from[p] = rings + ((w->generation & 1) * d->workers + q) * (size_t)d->ring_max;
+    }
+    return 0;
+}
+
+/**
+ * @brief Unmap the shared memory.
+ * @param d the workers
+ */
+static void shm_close(struct dist_t *d){
+    if(d->shared)
+        munmap(d->shared, d->shared_size);
+}
+
+/* tcp link */
+
+/**
+ * @brief Make a socket listening on the loopback on a port of the system's choosing.
+ * @param port set to the port
+ * @return the socket, -1 if it could not be made
+ */
+static int listen_loopback(int *port){
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+    socklen_t len = sizeof(addr);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(fd < 0)
+        return -1;
+    if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(fd, 64) || getsockname(fd, (struct sockaddr *)&addr, &len)){
+        close(fd);
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+/**
+ * @brief Connect to a port on the loopback and say who is connecting.
+ * @param port the port
+ * @param me index of the worker connecting
+ * @return the socket, -1 if it could not connect
+ */
+static int connect_loopback(int port, int me){
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+    int fd = socket(AF_INET, SOCK_STREAM, 0), one = 1;
+
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if(fd < 0)
+        return -1;
+    if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) || write_all(fd, &me, sizeof(me))){
+        close(fd);
+        return -1;
+    }
+    /* the boundary cells are small and go out once a generation, so they are not held back to fill a packet */
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+/**
+ * @brief Accept a connection and read who is connecting.
+ * @param listen_fd the listening socket
+ * @param who set to the index of the worker connecting
+ * @return the socket, -1 if it failed
+ */
+static int accept_loopback(int listen_fd, int *who){
+    int fd = accept(listen_fd, NULL, NULL), one = 1;
+
+    if(fd < 0)
+        return -1;
+    if(read_all(fd, who, sizeof(*who))){
+        close(fd);
+        return -1;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+/**
+ * @brief Open a listening socket for each worker.
+ * @param d the workers
+ */
+static int tcp_open(struct dist_t *d){
+    int i;
+
+    d->listen = malloc(d->workers * sizeof(int));
+    d->port = malloc(d->workers * sizeof(int));
+    if(!d->listen || !d->port)
+        return -1;
+    for(i = 0; i < d->workers; i++)
+        if((d->listen[i] = listen_loopback(&d->port[i])) < 0){
+            while(i--)
+                close(d->listen[i]);
+            return -1;
+        }
+    return 0;
+}
+
+/**
+ * @brief Connect a worker to each of its peers.
+ * @details Of each pair of peers the one with the lower index accepts and the other connects, so every pair ends
+ * up with one socket. Peers swap halos both ways, so each side of a pair knows the other as a peer.
+ * @param d the workers
+ * @param w the worker
+ */
+static int tcp_attach(struct dist_t *d, struct part_t *w){
+    int p, q, i, j, fd, who, waiting = 0;
+
+    w->fd = malloc(w->n_peer * sizeof(int));
+    w->inbox = calloc(w->n_peer, sizeof(unsigned char *));
+    w->sent = calloc(w->n_peer, sizeof(size_t));
+    w->got = calloc(w->n_peer, sizeof(size_t));
+    if(!w->fd || !w->inbox || !w->sent || !w->got)
+        return -1;
+    for(p = 0; p < w->n_peer; p++){
+        q = w->peer[p];
+        i = q / d->across;
+        j = q % d->across;
+        w->fd[p] = -1;
+        if(q != w->me && !(w->inbox[p] = malloc(ring_size(d->rows[i+1] - d->rows[i], d->cols[j+1] - d->cols[j]))))
+            return -1;
+        if(q > w->me && (w->fd[p] = connect_loopback(d->port[q], w->me)) < 0)
+            return -1;
+        if(q < w->me)
+            waiting++;
+    }
+    while(waiting--){
+        if((fd = accept_loopback(d->listen[w->me], &who)) < 0)
+            return -1;
+        for(p = 0; p < w->n_peer && w->peer[p] != who; p++)
+            ;
+        if(p == w->n_peer)
+            return -1;
+        w->fd[p] = fd;
+    }
+    for(i = 0; i < d->workers; i++)
+        close(d->listen[i]);
+    return 0;
+}
+
+/**
+ * @brief Start sending the boundary cells of a worker to each peer, as much as the sockets take without waiting.
+ * @param d the workers
+ * @param w the worker
+ */
+static int tcp_publish(struct dist_t *d, struct part_t *w){
+    size_t size = ring_size(w->r1 - w->r0, w->c1 - w->c0);
+    ssize_t k;
+    int p;
+
+    for(p = 0; p < w->n_peer; p++){
+        w->sent[p] = 0;
+        w->got[p] = 0;
+        if(w->fd[p] < 0)
+            continue;
+        k = send(w->fd[p], w->ring, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if(k < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            return -1;
+        if(k > 0)
+            w->sent[p] = k;
+    }
+    return 0;
+}
+
+/**
+ * @brief Finish sending the boundary cells of a worker and read those of each peer.
+ * @details Sending and reading go on together, so two peers sending each other more than the sockets hold do not
+ * wait on each other.
+ * @param d the workers
+ * @param w the worker
+ */
+static int tcp_collect(struct dist_t *d, struct part_t *w){
+    struct pollfd fds[w->n_peer];
+    size_t size = ring_size(w->r1 - w->r0, w->c1 - w->c0), want[w->n_peer];
+    int p, q, n, left;
+    ssize_t k;
+
+    for(p = 0; p < w->n_peer; p++){
+        q = w->peer[p];
+        want[p] = ring_size(d->rows[q / d->across + 1] - d->rows[q / d->across], d->cols[q % d->across + 1] - d->cols[q % d->across]);
+        w->from[p] = w->fd[p] < 0 ? w->ring : w->inbox[p];
+    }
+    for(;;){
+        for(p = n = left = 0; p < w->n_peer; p++){
+            if(w->fd[p] < 0)
+                continue;
+            fds[n].fd = w->fd[p];
+            fds[n].events = (w->sent[p] < size ? POLLOUT : 0) | (w->got[p] < want[p] ? POLLIN : 0);
+            fds[n].revents = 0;
+            left |= fds[n].events;
+            n++;
+        }
+        if(!left)
+            return 0;
+        if(poll(fds, n, -1) < 0){
+            if(errno == EINTR)
+                continue;
+            return -1;
+        }
+        for(p = n = 0; p < w->n_peer; p++){
+            if(w->fd[p] < 0)
+                continue;
+            if(fds[n].revents & (POLLERR | POLLHUP | POLLNVAL) && !(fds[n].revents & POLLIN))
+                return -1;
+            if(fds[n].revents & POLLOUT){
+                k = send(w->fd[p], w->ring + w->sent[p], size - w->sent[p], MSG_DONTWAIT | MSG_NOSIGNAL);
+                if(k < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                    return -1;
+                if(k > 0)
+                    w->sent[p] += k;
+            }
+            if(fds[n].revents & POLLIN){
+                k = recv(w->fd[p], w->inbox[p] + w->got[p], want[p] - w->got[p], MSG_DONTWAIT);
+                if(k == 0 || (k < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                    return -1;
+                if(k > 0)
+                    w->got[p] += k;
+            }
+            n++;
+        }
+    }
+}
+
+/**
+ * @brief Close the listening sockets in the main process.
+ * @param d the workers
+ */
+static void tcp_close(struct dist_t *d){
+    int i;
+
+    if(d->listen)
+        for(i = 0; i < d->workers; i++)
+            close(d->listen[i]);
+}
+
+const struct link_t links[] = {
+    { "shm", shm_open_link, shm_attach, shm_publish, shm_collect, shm_close },
+    { "tcp", tcp_open, tcp_attach, tcp_publish, tcp_collect, tcp_close },
+    { NULL }
+};
+
+/**
+ * @brief Set a run of live cells in the rectangle of a loading worker, as much of it as lands there.
+ * @details The run is cut where it wraps, as run_in() does, and each piece is clipped to the rectangle. A run past
+ * the edge of a hedge board is counted and none of it set.
+ * @param ctx the struct clip_t of the worker
+ * @param x collum of the first cell, relative to the board
+ * @param y row, relative to the board
+ * @param n number of cells
+ */
+static void clip_cell(void *ctx, int x, int y, int n){
+    struct clip_t *c = ctx;
+    struct dist_t *d = c->d;
+    struct part_t *w = c->w;
+    int cx, cy, part, lo, hi;
+
+    if(d->type == 'h' && !(x >= 0 && n <= d->n_col - x && y >= 0 && y < d->m_row)){
+        c->outside++;
+        return;
+    }
+    while(n > 0){
+        cx = x;
+        cy = y;
+        cover(d->type, d->m_row, d->n_col, &cy, &cx);
+        part = d->n_col - cx < n ? d->n_col - cx : n;
+        lo = cx > w->c0 ? cx : w->c0;
+        hi = cx + part < w->c1 ? cx + part : w->c1;
+        if(cy >= w->r0 && cy < w->r1 && lo < hi)
+            memset(w->a->row[cy-w->r0] + lo - w->c0, 1, hi - lo);
+        x += part;
+        n -= part;
+    }
+}
+
+/**
+ * @brief Tell the main process a worker has run the generations it was ordered, then send it the rectangle a row
+ * at a time if it asked for the board.
+ * @param w the worker
+ * @param board nonzero if the main process wants the cells
+ * @return 0 if it worked, otherwise -1
+ */
+static int report(struct part_t *w, long board){
+    long msg[2] = { w->generation, 0 };
+    int r;
+
+    if(write_all(w->up, msg, sizeof(msg)))
+        return -1;
+    for(r = 0; board && r < w->r1 - w->r0; r++)
+        if(write_all(w->up, w->a->row[r], w->c1 - w->c0))
+            return -1;
+    return 0;
+}
+
+/**
+ * @brief Body of a worker process: load its rectangle, link up with its peers and run the generations it is ordered
+ * until told to stop.
+ * @details Once loaded and linked the worker tells the main process the cells it read and the runs past the edge of
+ * a hedge board. Each generation the middle of the rectangle is stepped while the boundary cells travel, and the
+ * edge once the halo is filled from the boundary cells of the peers.
+ * @param d the workers
+ * @param me index of the worker
+ * @param load hands every run of live cells of the board to a cell function
+ * @param arg passed to load
+ */
+static void worker(struct dist_t *d, int me, dist_load_fn load, void *arg){
+    struct part_t w = { .me = me };
+    struct clip_t clip = { d, &w, 0 };
+    struct grid_t *tmp;
+    long g, msg[2];
+    int i;
+
+    /* a worker is no use once the main process is gone, and could be left waiting on its peers */
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if(getppid() == 1)
+        _exit(EXIT_FAILURE);
+    /* the main process only sees a worker stop if no other process holds its socket */
+    for(i = 0; i < d->workers; i++){
+        close(d->fd[i]);
+        if(i != me)
+            close(d->up[i]);
+    }
+    w.up = d->up[me];
+    w.r0 = d->rows[me / d->across];
+    w.r1 = d->rows[me / d->across + 1];
+    w.c0 = d->cols[me % d->across];
+    w.c1 = d->cols[me % d->across + 1];
+    w.a = init_matrix(w.r1 - w.r0, w.c1 - w.c0);
+    w.b = init_matrix(w.r1 - w.r0, w.c1 - w.c0);
+    w.ring = malloc(d->ring_max);
+    if(!w.a || !w.b || !w.ring || map_halo(d, &w)){
+        printf("Worker %d Initialization has failed.\n", me);
+        _exit(EXIT_FAILURE);
+    }
+    msg[0] = load(arg, clip_cell, &clip);
+    msg[1] = clip.outside;
+    if(d->link->attach(d, &w)){
+        printf("Worker %d could not link to its peers.\n", me);
+        _exit(EXIT_FAILURE);
+    }
+    if(write_all(w.up, msg, sizeof(msg)))
+        _exit(EXIT_FAILURE);
+
+    while(!read_all(w.up, msg, sizeof(msg)) && msg[0] > 0){
+        for(g = 0; g < msg[0]; g++){
+            fill_ring(&w);
+            if(d->link->publish(d, &w))
+                break;
+            mid(w.a, w.b);
+            if(d->link->collect(d, &w))
+                break;
+            fill_halo(d, &w);
+            edge(w.a, w.b);
+            tmp = w.a;
+            w.a = w.b;
+            w.b = tmp;
+            w.generation++;
+        }
+        if(g < msg[0] || report(&w, msg[1])){
+            printf("Worker %d lost its link at generation %ld.\n", me, w.generation);
+            _exit(EXIT_FAILURE);
+        }
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+/**
+ * @brief Frees the workers, closing the sockets of the main process still open.
+ * @param d the workers
+ */
+static void free_dist(struct dist_t *d){
+    int i;
+
+    for(i = 0; d->fd && i < d->workers; i++){
+        if(d->fd[i] >= 0)
+            close(d->fd[i]);
+        if(d->up[i] >= 0)
+            close(d->up[i]);
+    }
+    free(d->rows);
+    free(d->cols);
+    free(d->pid);
+    free(d->listen);
+    free(d->port);
+    free(d->fd);
+    free(d->up);
+    free(d);
+}
+
+/**
+ * @brief Stop every worker still running and wait for them to end.
+ * @param d the workers
+ */
+static void kill_workers(struct dist_t *d){
+    int i;
+
+    for(i = 0; i < d->workers; i++)
+        if(d->pid[i] > 0){
+            kill(d->pid[i], SIGKILL);
+            waitpid(d->pid[i], NULL, 0);
+            d->pid[i] = -1;
+        }
+}
+
+/**
+ * @brief Send every worker an order: generations to run, 0 to stop, and whether to send back its rectangle.
+ * @param d the workers
+ * @param gens generations to run, 0 to stop
+ * @param board nonzero to have the rectangles sent back
+ * @return 0 if it worked, otherwise -1
+ */
+static int order(struct dist_t *d, long gens, long board){
+    long msg[2] = { gens, board };
+    int i;
+
+    for(i = 0; i < d->workers; i++)
+        if(write_all(d->fd[i], msg, sizeof(msg)))
+            return -1;
+    return 0;
+}
+
+/**
+ * @brief Wait for the answer of every worker, reading them as they come.
+ * @details A worker that stops closes its socket, which is noticed even while the others wait on it for good.
+ * @param d the workers
+ * @param msg set to the answer of each worker
+ * @return 0 if every worker answered, -1 if one stopped first
+ */
+static int answers(struct dist_t *d, long (*msg)[2]){
+    struct pollfd fds[d->workers];
+    int i, left = d->workers;
+
+    for(i = 0; i < d->workers; i++){
+        fds[i].fd = d->fd[i];
+        fds[i].events = POLLIN;
+    }
+    while(left){
+        if(poll(fds, d->workers, -1) < 0){
+            if(errno == EINTR)
+                continue;
+            return -1;
+        }
+        for(i = 0; i < d->workers; i++){
+            if(fds[i].fd < 0 || !fds[i].revents)
+                continue;
+            if(read_all(fds[i].fd, msg[i], sizeof(msg[i])))
+                return -1;
+            /* poll skips a negative socket */
+            fds[i].fd = -1;
+            left--;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Split a board into across by down rectangles and start a worker process on each, which loads its own
+ * rectangle. Return adress of the workers if sussesful or NULL if the link could not be made or a worker could not
+ * start.
+ * @details The cells read are kept in loaded and the runs past the edge of a hedge board in outside, for the caller
+ * to report.
+ * @param m_row number of row in the board
+ * @param n_col number of collum in the board
+ * @param type type of edge - hedge, torus, klein
+ * @param across workers across the board, at most its collums
+ * @param down workers down the board, at most its rows
+ * @param link name of the link, shm or tcp
+ * @param load called in each worker to hand every run of live cells of the board to a cell function
+ * @param arg passed to load
+ */
+struct dist_t *dist_open(int m_row, int n_col, char type, int across, int down, const char *link, dist_load_fn load, void *arg){
+    struct dist_t *d = calloc(1, sizeof(struct dist_t));
+    int i, h = 0, w = 0, sv[2];
+    long (*msg)[2];
+    pid_t pid;
+
+    if(!d)
+        return NULL;
+    for(d->link = links; d->link->name && strcmp(d->link->name, link); d->link++)
+        ;
+    d->m_row = m_row;
+    d->n_col = n_col;
+    d->type = type;
+    d->across = across;
+    d->down = down;
+    d->workers = across * down;
+    d->rows = malloc((down + 1) * sizeof(int));
+    d->cols = malloc((across + 1) * sizeof(int));
+    d->pid = malloc(d->workers * sizeof(pid_t));
+    d->fd = malloc(d->workers * sizeof(int));
+    d->up = malloc(d->workers * sizeof(int));
+    if(!d->rows || !d->cols || !d->pid || !d->fd || !d->up){
+        free(d->fd);
+        d->fd = NULL;
+        free_dist(d);
+        return NULL;
+    }
+    for(i = 0; i < d->workers; i++)
+        d->pid[i] = d->fd[i] = d->up[i] = -1;
+    if(!d->link->name || across > n_col || down > m_row){
+        free_dist(d);
+        return NULL;
+    }
+    for(i = 0; i <= down; i++)
+        d->rows[i] = (long)i * m_row / down;
+    for(i = 0; i <= across; i++)
+        d->cols[i] = (long)i * n_col / across;
+    for(i = 0; i < down; i++)
+        if(d->rows[i+1] - d->rows[i] > h)
+            h = d->rows[i+1] - d->rows[i];
+    for(i = 0; i < across; i++)
+        if(d->cols[i+1] - d->cols[i] > w)
+            w = d->cols[i+1] - d->cols[i];
+    d->ring_max = ring_size(h, w);
+    for(i = 0; i < d->workers; i++){
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv)){
+            free_dist(d);
+            return NULL;
+        }
+        d->fd[i] = sv[0];
+        d->up[i] = sv[1];
+    }
+    if(d->link->open(d)){
+        free_dist(d);
+        return NULL;
+    }
+
+    /* nothing buffered is written twice by the workers */
+    fflush(stdout);
+    for(i = 0; i < d->workers; i++){
+        pid = fork();
+        if(pid == 0)
+            worker(d, i, load, arg);
+        d->pid[i] = pid;
+        if(pid < 0){
+            kill_workers(d);
+            d->link->close(d);
+            free_dist(d);
+            return NULL;
+        }
+    }
+    for(i = 0; i < d->workers; i++){
+        close(d->up[i]);
+        d->up[i] = -1;
+    }
+    if(!(msg = malloc(d->workers * sizeof(*msg))) || answers(d, msg)){
+        free(msg);
+        kill_workers(d);
+        dist_close(d);
+        return NULL;
+    }
+    d->loaded = msg[0][0];
+    for(i = 0; i < d->workers; i++)
+        if(msg[i][1] > d->outside)
+            d->outside = msg[i][1];
+    free(msg);
+    return d;
+}
+
+/**
+ * @brief Run the workers a number of generations and, if a is given, gather their rectangles into it.
+ * @details If a worker or its link fails the others are stopped, as they would otherwise wait on it for good.
+ * @param d the workers
+ * @param a the board, set to the cells gens generations on, or NULL to only wait for the workers
+ * @param gens generations to run
+ * @return 0 if it worked, -1 if a worker or its link failed
+ */
+int dist_step(struct dist_t *d, struct grid_t *a, long gens){
+    long (*msg)[2] = malloc(d->workers * sizeof(*msg));
+    int i, j, k, r, failed = !msg || order(d, gens, a != NULL) || answers(d, msg);
+
+    for(k = 0; !failed && a && k < d->workers; k++){
+        i = k / d->across;
+        j = k % d->across;
+        for(r = d->rows[i]; !failed && r < d->rows[i+1]; r++)
+            failed = read_all(d->fd[k], a->row[r] + d->cols[j], d->cols[j+1] - d->cols[j]);
+    }
+    free(msg);
+    if(failed){
+        kill_workers(d);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Stop the workers, wait for them to end and free them.
+ * @param d the workers
+ */
+void dist_close(struct dist_t *d){
+    int i;
+
+    order(d, 0, 0);
+    for(i = 0; i < d->workers; i++)
+        if(d->pid[i] > 0)
+            waitpid(d->pid[i], NULL, 0);
+    d->link->close(d);
+    free_dist(d);
+}
@@ -0,0 +1,80 @@
+/**
+ * @file dist.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for stepping the byte matrix across worker processes that swap halos over a link
+ */
+#ifndef DIST_H_
+#define DIST_H_
+
+#include <sys/types.h>
+#include "life.h"
+
+struct grid_t;
+struct dist_t;
+struct part_t;
+
+/**
+ * A way for the workers to swap halos. Every function but the names returns 0 if it worked, otherwise -1.
+ */
+struct link_t {
+        const char *name;
+        int (*open)(struct dist_t *d);					/* main process, before the workers start */
+        int (*attach)(struct dist_t *d, struct part_t *w);		/* worker, once it has loaded its rectangle */
+        int (*publish)(struct dist_t *d, struct part_t *w);		/* worker, hand its boundary cells of this generation to its peers */
+        int (*collect)(struct dist_t *d, struct part_t *w);		/* worker, wait for the boundary cells of its peers and point from[] at them */
+        void (*close)(struct dist_t *d);				/* main process, once the workers have stopped */
+};
+
+/** Hands every run of live cells of the board to cell with ctx, returning the number of cells. Run by each worker. */
+typedef long (*dist_load_fn)(void *arg, cell_fn cell, void *ctx);
+
+/** Every link, ending with a NULL name. */
+extern const struct link_t links[];
+
+/** Board split into across by down rectangles, each loaded and stepped by a worker process. */
+struct dist_t {
+        int m_row;
+        int n_col;
+        char type;			/* type of edge - hedge, torus, klein */
+        int across;			/* workers across the matrix */
+        int down;			/* workers down the matrix */
+        int workers;
+        int *rows;			/* worker i, j has rows rows[i] to rows[i + 1] - 1 */
+        int *cols;			/* and collums cols[j] to cols[j + 1] - 1 */
+        int ring_max;			/* boundary cells of the largest rectangle */
+        const struct link_t *link;
+        pid_t *pid;			/* process of each worker, by index i * across + j */
+        void *shared;			/* memory shared by the main process and the workers, for the shm link */
+        size_t shared_size;
+        int *listen;			/* listening socket of each worker, for the tcp link */
+        int *port;			/* their ports on the loopback */
+        int *fd;			/* socket of the main process to each worker */
+        int *up;			/* the other end of each, closed in the main process once the workers start */
+        long loaded;			/* live cells the workers read */
+        long outside;			/* runs of them past the edge of a hedge board */
+};
+
+/** Part of the matrix a worker process steps, and its links to the parts around it. */
+struct part_t {
+        int me;				/* index of the worker */
+        int r0, r1, c0, c1;		/* rows r0 to r1 - 1 and collums c0 to c1 - 1 of the matrix */
+        struct grid_t *a, *b;		/* present and future part, the ghost border holding the halo */
+        long generation;		/* generations run since the workers started */
+        unsigned char *ring;		/* boundary cells: first row, last row, then first and last collum between them */
+        int n_peer;
+        int *peer;			/* workers the halo is read from, itself included if the board wraps onto it */
+        const unsigned char **from;	/* boundary cells of each peer for this generation, set by collect */
+        int n_ghost;
+        int *src;			/* for each ghost cell, peer * ring_max + boundary cell, or -1 if always dead */
+        int up;				/* socket to the main process */
+        int *fd;			/* socket to each peer, -1 for itself, for the tcp link */
+        unsigned char **inbox;		/* boundary cells read from each peer, for the tcp link */
+        size_t *sent, *got;		/* bytes sent to and read from each peer this generation, for the tcp link */
+};
+
+struct dist_t *dist_open(int m_row, int n_col, char type, int across, int down, const char *link, dist_load_fn load, void *arg);
+int dist_step(struct dist_t *d, struct grid_t *a, long gens);
+void dist_close(struct dist_t *d);
+
+#endif
@@ -0,0 +1,522 @@
+/**
+ * @file engine.c
+ * @brief Engine handle of liblife, for programs embedding convey's game of life
+ * @details
+ * An engine holds a board and the backend stepping it: byte (hedge(),
+ * torus() or klein() then mid()), packed (a bit per cell), tiled (only the
+ * tiles near a change) or blocked (several generations per tile in cache).
+ * Each backend keeps its present and future boards and swaps them itself, so
+ * a caller runs any number of generations with one call. Cells are loaded
+ * and read through the backend, so the packed backend never needs a byte
+ * copy of its board.
+ *
+ * An engine asked to record keeps the latest generations in a history (see
+ * history.h) as it steps them, one at a time, and can be set back to any of
+ * them to look at how the board formed and run on from there.
+ *
+ * Built into liblife.a and liblife.so by make, with the modules the
+ * backends use. No failure in it or those modules is printed or exits;
+ * each is returned. The first engine picks the kernel under pthread_once(), so
+ * threads may create engines at once; link with -lpthread.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include "life.h"
+#include "bitlife.h"
+#include "kernel.h"
+#include "tile.h"
+#include "block.h"
+#include "history.h"
+#include "engine.h"
+
+/** A way of stepping the board. */
+struct backend_t {
+        const char *name;
+        int (*open)(struct life_engine_t *e);				/* make the boards, all dead */
+        void (*step)(struct life_engine_t *e, long k);			/* run k generations */
+        void (*set)(struct life_engine_t *e, int r, int c, unsigned char alive);
+        unsigned char (*get)(struct life_engine_t *e, int r, int c);
+        void (*changed)(struct life_engine_t *e);			/* cells were set outside of step */
+};
+
+struct life_engine_t {
+        const struct backend_t *backend;
+        char type;			/* type of edge - hedge, torus, klein */
+        int m_row;
+        int n_col;
+        long generation;		/* generations run since the board was made or cleared */
+        struct grid_t *a, *b;		/* present and future byte matrix */
+        struct bitgrid_t *p, *q;	/* present and future packed matrix */
+        struct tiles_t *tiles;
+        struct block_t *blocks;
+        struct history_t *hist;		/* latest generations, NULL if not recording */
+};
+
+/**
+ * @brief Make the present and future byte matrix.
+ * @param e the engine
+ * @return 0 if it worked, -1 if malloc failed
+ */
+static int byte_open(struct life_engine_t *e){
+    e->a = init_matrix(e->m_row, e->n_col);
+    e->b = init_matrix(e->m_row, e->n_col);
+    return e->a && e->b ? 0 : -1;
+}
+
+/**
+ * @brief Make the byte matrices and the tiles.
+ * @param e the engine
+ */
+static int tiled_open(struct life_engine_t *e){
+    if(byte_open(e))
+        return -1;
+    e->tiles = init_tiles(e->m_row, e->n_col);
+    return e->tiles ? 0 : -1;
+}
+
+/**
+ * @brief Make the byte matrices and the scratch tiles, advancing BLOCK_DEPTH generations a sweep.
+ * @param e the engine
+ */
+static int blocked_open(struct life_engine_t *e){
+    if(byte_open(e))
+        return -1;
+    e->blocks = init_block(e->m_row, e->n_col, BLOCK_DEPTH);
+    return e->blocks ? 0 : -1;
+}
+
+/**
+ * @brief Make the present and future packed matrix.
+ * @param e the engine
+ */
+static int packed_open(struct life_engine_t *e){
+    e->p = init_bitgrid(e->m_row, e->n_col);
+    e->q = init_bitgrid(e->m_row, e->n_col);
+    return e->p && e->q ? 0 : -1;
+}
+
+/**
+ * @brief Run k generations, edge cells first, then the middle.
+ * @param e the engine
+ * @param k generations to run
+ */
+static void byte_step(struct life_engine_t *e, long k){
+    grid_run(&e->a, &e->b, e->type, k);
+}
+
+/**
+ * @brief Run k generations, updating only the tiles near a change.
+ * @param e the engine
+ * @param k generations to run
+ */
+static void tiled_step(struct life_engine_t *e, long k){
+    tile_run(e->tiles, &e->a, &e->b, e->type, k);
+}
+
+/**
+ * @brief Run k generations, up to the depth of the blocks at a time.
+ * @param e the engine
+ * @param k generations to run
+ */
+static void blocked_step(struct life_engine_t *e, long k){
+    block_run(e->blocks, &e->a, &e->b, e->type, k);
+}
+
+/**
+ * @brief Run k generations on the packed matrix.
+ * @param e the engine
+ * @param k generations to run
+ */
+static void packed_step(struct life_engine_t *e, long k){
+    bit_run(&e->p, &e->q, e->type, k);
+}
+
+/**
+ * @brief Set a cell of the present byte matrix.
+ * @param e the engine
+ * @param r row of the cell
+ * @param c collum of the cell
+ * @param alive 1 for a live cell, 0 for a dead one
+ */
+static void byte_set(struct life_engine_t *e, int r, int c, unsigned char alive){
+    e->a->row[r][c] = alive;
+}
+
+/**
+ * @brief Read a cell of the present byte matrix.
+ * @param e the engine
+ * @param r row of the cell
+ * @param c collum of the cell
+ */
+static unsigned char byte_get(struct life_engine_t *e, int r, int c){
+    return e->a->row[r][c];
+}
+
+/**
+ * @brief Set a cell of the present packed matrix.
+ * @param e the engine
+ * @param r row of the cell
+ * @param c collum of the cell
+ * @param alive 1 for a live cell, 0 for a dead one
+ */
+static void packed_set(struct life_engine_t *e, int r, int c, unsigned char alive){
+    uint64_t *w = e->p->word + (long)r * e->p->words + c / 64;
+
+    *w = (*w & ~((uint64_t)1 << (c % 64))) | (uint64_t)(alive & 1) << (c % 64);
+}
+
+/**
+ * @brief Read a cell of the present packed matrix.
+ * @param e the engine
+ * @param r row of the cell
+ * @param c collum of the cell
+ */
+static unsigned char packed_get(struct life_engine_t *e, int r, int c){
+    return (e->p->word[(long)r * e->p->words + c / 64] >> (c % 64)) & 1;
+}
+
+/**
+ * @brief Nothing to do when cells are set, every cell is stepped each generation.
+ * @param e the engine
+ */
+static void no_change(struct life_engine_t *e){
+}
+
+/**
+ * @brief Update every tile next generation, since any of them may have been set.
+ * @param e the engine
+ */
+static void tiled_change(struct life_engine_t *e){
+    tiles_all(e->tiles);
+}
+
+/** Every backend, ending with a NULL name. */
+static const struct backend_t backends[] = {
+    { "byte", byte_open, byte_step, byte_set, byte_get, no_change },
+    { "packed", packed_open, packed_step, packed_set, packed_get, no_change },
+    { "tiled", tiled_open, tiled_step, byte_set, byte_get, tiled_change },
+    { "blocked", blocked_open, blocked_step, byte_set, byte_get, no_change },
+    { NULL }
+};
+
+/** Set once the first engine has picked the kernel. */
+static pthread_once_t picked = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Pick the fastest kernel the CPU supports, done once for the first engine created.
+ */
+static void pick_kernel(void){
+    kernel_select(NULL);
+}
+
+/**
+ * @brief Name of a backend, for listing them.
+ * @param i index of the backend, from 0
+ * @return its name, NULL past the last one
+ */
+const char *life_backend(int i){
+    if(i < 0 || i >= (int)(sizeof(backends) / sizeof(backends[0])))
+        return NULL;
+    return backends[i].name;
+}
+
+/**
+ * @brief Create an engine with a dead board. Return adress of the engine if sussesful or NULL if the backend or edge
+ * type is unknown, the size is not positive or malloc failed.
+ * @param m_row number of row in matrix
+ * @param n_col number of collum in matrix
+ * @param type type of edge - 'h' hedge, 't' torus or 'k' klein
+ * @param backend name of the backend - byte, packed, tiled or blocked, NULL for byte
+ */
+struct life_engine_t *life_create(int m_row, int n_col, char type, const char *backend){
+    struct life_engine_t *e;
+    const struct backend_t *b;
+
+    for(b = backends; b->name && backend && strcmp(b->name, backend); b++)
+        ;
+    if(!b->name || m_row <= 0 || n_col <= 0 || (type != 'h' && type != 't' && type != 'k'))
+        return NULL;
+    e = calloc(1, sizeof(struct life_engine_t));
+    if(!e)
+        return NULL;
+    e->backend = b;
+    e->type = type;
+    e->m_row = m_row;
+    e->n_col = n_col;
+    if(b->open(e)){
+        life_destroy(e);
+        return NULL;
+    }
+    pthread_once(&picked, pick_kernel);
+    return e;
+}
+
+/**
+ * @brief Free an engine and its board.
+ * @param e the engine
+ */
+void life_destroy(struct life_engine_t *e){
+    if(e->a)
+        free_matrix(e->a);
+    if(e->b)
+        free_matrix(e->b);
+    if(e->p)
+        free_bitgrid(e->p);
+    if(e->q)
+        free_bitgrid(e->q);
+    if(e->tiles)
+        free_tiles(e->tiles);
+    if(e->blocks)
+        free_block(e->blocks);
+    if(e->hist)
+        free_history(e->hist);
+    free(e);
+}
+
+/**
+ * @brief Record the present board as the generation it is, the first one of the history.
+ * @param e the engine
+ * @return 0 if it was recorded, -1 if it does not fit in the budget or malloc failed
+ */
+static int record_board(struct life_engine_t *e){
+    history_reset(e->hist);
+    return e->p ? history_push_bits(e->hist, e->p, e->generation) : history_push(e->hist, e->a, e->generation);
+}
+
+/**
+ * @brief Kill every cell and start counting generations again from 0.
+ * @param e the engine
+ */
+void life_clear(struct life_engine_t *e){
+    int r;
+
+    if(e->a)
+        for(r = 0; r < e->m_row; r++)
+            memset(e->a->row[r], 0, e->n_col);
+    if(e->p)
+        memset(e->p->word, 0, (size_t)e->m_row * e->p->words * sizeof(uint64_t));
+    e->backend->changed(e);
+    e->generation = 0;
+    if(e->hist)
+        record_board(e);
+}
+
+/**
+ * Engine pattern cells are loaded into, the count of those past the edge of a hedge board and the cells that were
+ * dead before, so a load that fails can be undone.
+ */
+struct load_t {
+        struct life_engine_t *e;
+        long outside;
+        int *set;		/* row and collum of each cell brought to life */
+        long n_set;
+        long cap;
+        int failed;		/* malloc failed, no more cells are set */
+};
+
+/**
+ * @brief Set a run of live cells read by pattern_read(), wrapping them onto the board as the edge type does.
+ * @details Each dead cell is noted before it is set, and none is set once there is no room to note it.
+ * @param ctx the load
+ * @param x collum of the first cell
+ * @param y row of the cells
+ * @param n number of cells
+ */
+static void load_cells(void *ctx, int x, int y, int n){
+    struct load_t *in = ctx;
+    struct life_engine_t *e = in->e;
+    int i, r, c, *set;
+
+    for(i = 0; i < n && !in->failed; i++){
+        r = y;
+        c = x + i;
+        if(!cover(e->type, e->m_row, e->n_col, &r, &c)){
+            in->outside++;
+            continue;
+        }
+        if(e->backend->get(e, r, c))
+            continue;
+        if(in->n_set == in->cap){
+            set = realloc(in->set, (in->cap ? 2 * in->cap : 256) * 2 * sizeof(int));
+            if( !(set) ){
+                in->failed = 1;
+                break;
+            }
+            in->set = set;
+            in->cap = in->cap ? 2 * in->cap : 256;
+        }
+        in->set[2 * in->n_set] = r;
+        in->set[2 * in->n_set + 1] = c;
+        in->n_set++;
+        e->backend->set(e, r, c, 1);
+    }
+}
+
+/**
+ * @brief Add the live cells of a pattern file to the board.
+ * @details Compatible with 1.05, 1.06 and RLE, as pattern_read(). Torus and klein boards wrap cells past the edge
+ * onto the board. A load that fails leaves the board as it was, the cells it brought to life being cleared again.
+ * @param e the engine
+ * @param fp file containing the pattern, read from the current position
+ * @param x collum the pattern is placed at
+ * @param y row the pattern is placed at
+ * @return number of live cells read, -1 if the file could not be read or is of no known type, a number in it is out
+ * of range, the pattern is wider or taller than the board, a cell fell past the edge of a hedge board or malloc failed
+ */
+long life_load(struct life_engine_t *e, FILE *fp, int x, int y){
+    struct load_t in = { e, 0, NULL, 0, 0, 0 };
+    long i, cells = pattern_read(fp, x, y, e->n_col, e->m_row, load_cells, &in);
+
+    if(cells <= 0 || in.outside || in.failed){
+        for(i = 0; i < in.n_set; i++)
+            e->backend->set(e, in.set[2 * i], in.set[2 * i + 1], 0);
+        cells = -1;
+    }
+    free(in.set);
+    if(in.n_set){
+        e->backend->changed(e);
+        if(e->hist && cells > 0)
+            record_board(e);
+    }
+    return cells;
+}
+
+/**
+ * @brief Set the cells of a part of the board.
+ * @param e the engine
+ * @param r0 first row of the part
+ * @param c0 first collum of the part
+ * @param h rows of the part
+ * @param w collums of the part
+ * @param cells h rows of w cells, nonzero for a live cell
+ * @return 0 if it worked, -1 if the part is not on the board
+ */
+int life_write_region(struct life_engine_t *e, int r0, int c0, int h, int w, const unsigned char *cells){
+    int r, c;
+
+    if(r0 < 0 || c0 < 0 || h < 0 || w < 0 || h > e->m_row - r0 || w > e->n_col - c0)
+        return -1;
+    for(r = 0; r < h; r++)
+        for(c = 0; c < w; c++)
+            e->backend->set(e, r0 + r, c0 + c, cells[(long)r * w + c] != 0);
+    e->backend->changed(e);
+    if(e->hist)
+        record_board(e);
+    return 0;
+}
+
+/**
+ * @brief Read the cells of a part of the board.
+ * @param e the engine
+ * @param r0 first row of the part
+ * @param c0 first collum of the part
+ * @param h rows of the part
+ * @param w collums of the part
+ * @param cells set to h rows of w cells, 1 for a live cell and 0 for a dead one
+ * @return 0 if it worked, -1 if the part is not on the board
+ */
+int life_read_region(struct life_engine_t *e, int r0, int c0, int h, int w, unsigned char *cells){
+    int r, c;
+
+    if(r0 < 0 || c0 < 0 || h < 0 || w < 0 || h > e->m_row - r0 || w > e->n_col - c0)
+        return -1;
+    for(r = 0; r < h; r++){
+        if(e->a)
+            memcpy(cells + (long)r * w, e->a->row[r0+r] + c0, w);
+        else
+            for(c = 0; c < w; c++)
+                cells[(long)r * w + c] = e->backend->get(e, r0 + r, c0 + c);
+    }
+    return 0;
+}
+
+/**
+ * @brief Run k generations.
+ * @details While recording they are run and recorded one at a time.
+ * @param e the engine
+ * @param k generations to run
+ * @return 0 if they were run, -1 if k is negative or the count of generations would overflow, none being run
+ */
+int life_step_n(struct life_engine_t *e, long k){
+    if(k < 0 || k > LONG_MAX - e->generation)
+        return -1;
+    if(e->hist)
+        for(; k > 0; k--){
+            e->backend->step(e, 1);
+            e->generation++;
+            if(e->p)
+                history_push_bits(e->hist, e->p, e->generation);
+            else
+                history_push(e->hist, e->a, e->generation);
+        }
+    else if(k)
+        e->backend->step(e, k);
+    e->generation += k;
+    return 0;
+}
+
+/**
+ * @brief Start or stop recording the latest generations, so the board can be set back to them with life_seek().
+ * @details Recording starts from the present board. Loading, writing or clearing cells starts it over from the board
+ * they leave. The oldest generations are dropped once the history takes more than budget bytes; a generation too
+ * large for all of it leaves nothing held until one fits.
+ * @param e the engine
+ * @param budget bytes the history may take, 0 to stop recording and free it
+ * @param interval generations from one whole board to the next in the history, the rest only holding the cells that
+ * changed, 1 or more
+ * @return 0 if it worked, -1 if interval is not positive or malloc failed, the engine not recording
+ */
+int life_record(struct life_engine_t *e, size_t budget, int interval){
+    if(e->hist)
+        free_history(e->hist);
+    e->hist = NULL;
+    if(!budget)
+        return 0;
+    if(interval <= 0 || !(e->hist = init_history(e->m_row, e->n_col, budget, interval)))
+        return -1;
+    record_board(e);
+    return 0;
+}
+
+/**
+ * @brief Set the board back, or on, to a generation held in the history. The generations after it are dropped, so
+ * stepping runs on from it and is recorded again.
+ * @param e the engine
+ * @param generation generation to set the board to, from life_oldest() to life_generation()
+ * @return 0 if the board is at that generation, -1 if the engine is not recording or does not hold it
+ */
+int life_seek(struct life_engine_t *e, long generation){
+    if(!e->hist || history_truncate(e->hist, generation))
+        return -1;
+    if(e->p)
+        history_seek_bits(e->hist, generation, e->p);
+    else
+        history_seek(e->hist, generation, e->a);
+    e->backend->changed(e);
+    e->generation = generation;
+    return 0;
+}
+
+/**
+ * @brief Oldest generation life_seek() can set the board back to, -1 if the engine is not recording or holds none.
+ * @param e the engine
+ */
+long life_oldest(struct life_engine_t *e){
+    return e->hist ? history_oldest(e->hist) : -1;
+}
+
+/**
+ * @brief Generations run since the board was made or cleared.
+ * @param e the engine
+ */
+long life_generation(struct life_engine_t *e){
+    return e->generation;
+}
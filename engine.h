@@ -0,0 +1,36 @@
+/**
+ * @file engine.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the engine handle of liblife, for programs embedding the game of life
+ * @details
+ * An engine owns its board and steps it with the backend it was created with. Callers load cells, run any number of
+ * generations with life_step_n() and read back any part of the board; how a generation is stepped and which buffer
+ * holds the present one stay inside the engine. With life_record() an engine keeps its latest generations, and
+ * life_seek() sets the board back to one of them. The rule (rule_set() of rule.h) and row kernel (kernel_select() of
+ * kernel.h) are shared by every engine of the process. The first engine created picks the fastest kernel the CPU
+ * supports, once even if several threads create engines at the same time; call kernel_select() after it to pick
+ * another. No failure in liblife is printed or exits; each is returned.
+ */
+#ifndef ENGINE_H_
+#define ENGINE_H_
+
+#include <stdio.h>
+
+/** An engine and its board, only used through the functions below. */
+struct life_engine_t;
+
+const char *life_backend(int i);
+struct life_engine_t *life_create(int m_row, int n_col, char type, const char *backend);
+void life_destroy(struct life_engine_t *e);
+void life_clear(struct life_engine_t *e);
+long life_load(struct life_engine_t *e, FILE *fp, int x, int y);
+int life_write_region(struct life_engine_t *e, int r0, int c0, int h, int w, const unsigned char *cells);
+int life_read_region(struct life_engine_t *e, int r0, int c0, int h, int w, unsigned char *cells);
+int life_step_n(struct life_engine_t *e, long k);
+long life_generation(struct life_engine_t *e);
+int life_record(struct life_engine_t *e, size_t budget, int interval);
+int life_seek(struct life_engine_t *e, long generation);
+long life_oldest(struct life_engine_t *e);
+
+#endif
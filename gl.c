@@ -5,7 +5,8 @@
  * Run Convey's Game of Life
  * Accept setting for the following:
  * Screen size (widht & hight)
- * Cell color and upscale ratio (sprite size)
+ * Cell color and starting zoom (sprite size)
+ * Pan and zoom the window over boards of any size
  * Test condition if cell is alive or dead
  * Update status to next generation
  * Import patterns to matrix
@@ -19,21 +20,856 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include "sdl.h"
+#include "render.h"
 #include "life.h"
+#include "bitlife.h"
+#include "kernel.h"
+#include "rule.h"
+#include "pool.h"
+#include "hashlife.h"
+#include "tile.h"
+#include "block.h"
+#include "dist.h"
+#include "sparse.h"
+#include "triple.h"
+#include "snap.h"
+#include "cycle.h"
+#include "history.h"
+#include "stream.h"
+#include "soup.h"
+#include "prof.h"
 #include <string.h>
 #include <ctype.h>
 #include <unistd.h> /* used for getopt */
 #include <errno.h>
+#include <time.h> /* used for clock_gettime */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+
+/** Engines that can advance the board. */
+enum engine { BYTE, PACKED, HASHLIFE, TILED, BLOCKED, DIST };
+
+/** Names of the engines for -E. */
+static const char *engines[] = { [BYTE] = "byte", [PACKED] = "packed", [HASHLIFE] = "hashlife", [TILED] = "tiled", [BLOCKED] = "blocked", [DIST] = "dist" };
+
+/** Settings of a run taken from the command line. */
+struct run_t {
+	FILE *fp, *Qp, *Pp;		/* pattern files f, Q and P */
+	int x, y, q_x, q_y, p_x, p_y;	/* initial coordinates of the patterns */
+	int m_row, n_col;		/* board size in cells */
+	long gens;			/* generations to run headless */
+	int dump;			/* print the final headless generation */
+	enum engine engine;		/* engine advancing the board */
+	int threads;			/* threads stepping the board */
+	int depth;			/* generations the blocked engine advances a tile at a time */
+	int across, down;		/* worker processes across and down the board for the dist engine */
+	const char *link;		/* link the workers swap halos over */
+	size_t memory;			/* memory cap of the hashlife engine in bytes, 0 for none */
+	long loaded;			/* live cells read by the last load */
+	double load_secs;		/* seconds taken by the last load */
+	const char *save;		/* snapshot file written by checkpoints, or NULL */
+	long every;			/* generations between checkpoints, 0 for only at the end */
+	long generation;		/* generation the run starts at, from the restored snapshot */
+	struct snap_t *restore;		/* snapshot read in place of the patterns, or NULL */
+	int cycle;			/* stop headless runs once the board repeats */
+	uint64_t seed;			/* seed of the first soup of a batch */
+	long soups;			/* soups in the batch, 0 for no batch */
+	const char *results;		/* CSV file of the batch results, or NULL */
+	const char *profile;		/* file the phase timings are written to, or NULL */
+	long profile_every;		/* generations between writes of the timings, 0 for only at the end */
+	long rewind;			/* generations to step back at the end of a headless run or with backspace in the window, 0 for none */
+	size_t history;			/* memory the rewind history may take in bytes */
+	int keyframe;			/* generations from one keyframe of the history, or frames of the stream, to the next */
+	const char *stream;		/* file the frames are streamed to, or NULL */
+	long frame_every;		/* generations between frames of the stream */
+	int stats;			/* count the population, births, deaths and live box as the board steps */
+};
+
+/** Engine and boards stepped by the simulation thread of a windowed run. Only the fields of the engine in use are set. */
+struct sim_t {
+	struct run_t *run;
+	unsigned char type;		/* type of edge - hedge, torus, klein, infinite */
+	struct grid_t *a, *b;		/* present and future byte matrix */
+	struct bitgrid_t *p, *q;	/* present and future packed matrix */
+	struct pool_t *pool;
+	struct hashlife_t *hl;
+	struct tiles_t *tiles;
+	struct block_t *blocks;
+	struct sparse_t *plane;
+	struct triple_t *frames;	/* generations handed to the renderer */
+	struct view_t *view;		/* part of the board the frames show */
+	atomic_int quit;		/* set by the renderer to stop the simulation */
+	atomic_int paused;		/* set by the renderer to hold the simulation at its generation */
+	atomic_long back;		/* steps of run->rewind generations back asked for by the renderer */
+	struct history_t *hist;		/* latest generations, for stepping back with -z */
+	unsigned char *dirty;		/* rows changed since the last frame, for the grid engines */
+	struct census_t *census;	/* live cells of each tile of the present matrix, for the grid engines */
+	struct frame_t last;		/* view of the last frame, zoom above ZOOM_MAX before the first */
+	long generation;		/* generation of the present board */
+};
+
+/**
+ * @brief Seconds elapsed since a starting time on the monotonic clock.
+ * @param start time the measurement started
+ * @return elapsed seconds
+ */
+static double elapsed(struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Advance the byte matrix one generation as grid_run() does, timing the edge, middle and swap apart for -T.
+ * @details A hedge board that is counted is only stepped around its live cells, timed as the middle.
+ * @param a present matrix - current generation, set to the next
+ * @param b future matrix, set to the one before
+ * @param type type of edge - hedge, torus, klein
+ */
+static void prof_step(struct grid_t **a, struct grid_t **b, unsigned char type)
+{
+	struct grid_t *tmp;
+
+	PROF_START(t);
+	if(grid_edge(*a, *b, type))
+		PROF_STOP(PROF_MID, t);
+	else{
+		PROF_STOP(PROF_EDGE, t);
+		PROF_START(m);
+		mid(*a, *b);
+		PROF_STOP(PROF_MID, m);
+	}
+
+	PROF_START(w);
+	tmp = *a;
+	*a = *b;
+	*b = tmp;
+	PROF_STOP(PROF_SWAP, w);
+}
+
+/**
+ * @brief Read a pattern from the start of its file, leaving if a number in it is out of range. A file of no known
+ * type is reported and adds no cells.
+ * @param fp pattern file
+ * @param x initial x cordinate for pattern
+ * @param y initial y cordinate for pattern
+ * @param width collums of the board, 0 for a plane with no edge
+ * @param height rows of the board, 0 for a plane with no edge
+ * @param cell called with ctx and each run of live cells
+ * @param ctx passed to cell
+ * @return number of live cells read
+ */
+static long read_pattern(FILE *fp, int x, int y, int width, int height, cell_fn cell, void *ctx)
+{
+	long cells;
+
+	rewind(fp);
+	cells = pattern_read(fp, x, y, width, height, cell, ctx);
+	if(cells == -2){
+		printf("File version can not found.\n");
+		return 0;
+	}
+	if(cells < 0){
+		printf("Invalid pattern. A count is signed, or a number is too large or past the board.\n");
+		exit(EXIT_FAILURE);
+	}
+	return cells;
+}
+
+/**
+ * @brief Read the f, Q and P patterns. Without a P pattern a blinker is placed at row 1. A restored snapshot is read
+ * instead of all of them.
+ * @details Files are rewound first so the same patterns can be read once per edge type. The cells read and the time
+ * taken are kept in run for the stats.
+ * @param run pattern files and coordinates
+ * @param width collums of the board, 0 for a plane with no edge
+ * @param height rows of the board, 0 for a plane with no edge
+ * @param cell called with ctx and each run of live cells
+ * @param ctx passed to cell
+ */
+static void read_patterns(struct run_t *run, int width, int height, cell_fn cell, void *ctx)
+{
+	struct timespec start;
+	long cells = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (run->restore){
+		run->loaded = snap_read(run->restore, cell, ctx);
+		run->load_secs = elapsed(&start);
+		return;
+	}
+	if ((run->fp != NULL))
+		cells += read_pattern(run->fp, run->x, run->y, width, height, cell, ctx);
+	if ((run->Qp != NULL))
+		cells += read_pattern(run->Qp, run->q_x, run->q_y, width, height, cell, ctx);
+	if ((run->Pp != NULL))
+		cells += read_pattern(run->Pp, run->p_x, run->p_y, width, height, cell, ctx);
+	else{
+		cell(ctx, 0, 1, 3);
+		cells += 3;
+	}
+	run->load_secs = elapsed(&start);
+	run->loaded = cells;
+}
+
+/**
+ * @brief Load the f, Q and P patterns into the matrix with a spefic edge type, leaving if a cell is past the edge of
+ * a hedge matrix.
+ * @param a matrix to load into
+ * @param type type of edge - hedge, torus, klein
+ * @param run pattern files and coordinates
+ */
+static void load_patterns(struct grid_t *a, unsigned char type, struct run_t *run)
+{
+	struct pattern_ctx_t in = { a, type, 0 };
+	read_patterns(run, a->n_col, a->m_row, pattern_cell, &in);
+	if(in.outside){
+		printf("Cell out of bound\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * @brief Read the f, Q and P patterns in a worker of the dist engine, for it to keep the cells in its rectangle.
+ * @param arg settings of the run
+ * @param cell called with ctx and each run of live cells
+ * @param ctx passed to cell
+ * @return number of live cells read
+ */
+static long dist_load(void *arg, cell_fn cell, void *ctx)
+{
+	struct run_t *run = arg;
+
+	read_patterns(run, run->n_col, run->m_row, cell, ctx);
+	return run->loaded;
+}
+
+/**
+ * @brief Create the hashlife universe with the f, Q and P patterns on an unbounded plane.
+ * @param run settings of the run
+ * @return the universe
+ */
+static struct hashlife_t *load_hashlife(struct run_t *run)
+{
+	struct hashlife_t *hl = hl_create(run->memory);
+
+	if( !(hl) ){
+		printf("HashLife Initialization has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	read_patterns(run, 0, 0, hl_cell, hl);
+	return hl;
+}
+
+/**
+ * @brief Jump the hashlife engine a number of generations without a window and report the speed.
+ * @details There are no edges on the plane, so it runs once. The dump shows the board sized region from (0, 0).
+ * @param run settings of the run
+ */
+static void headless_hashlife(struct run_t *run)
+{
+	struct hashlife_t *hl = load_hashlife(run);
+	struct grid_t *a;
+	struct timespec start;
+	double secs;
+
+	PROF_BEGIN("hashlife plane");
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	PROF_START(t);
+	hl_jump(hl, run->gens);
+	PROF_STOP(PROF_STEP, t);
+	secs = elapsed(&start);
+	PROF_END(run->gens);
+
+	printf("hashlife plane: %ld generations in %.6f s, %.1f gen/s, population %llu, %zu nodes, %zu collections, loaded %ld cells in %.6f s\n", run->gens, secs, run->gens / secs, (unsigned long long)hl_population(hl), hl->nodes, hl->collections, run->loaded, run->load_secs);
+	if(run->dump){
+		a = init_matrix(run->m_row, run->n_col);
+		if( !(a) ){
+			printf("Matrix Initialization has failed.\n");
+			exit(EXIT_FAILURE);
+		}
+		hl_to_grid(hl, a, 0, 0);
+		print_matrix(a);
+		free_matrix(a);
+	}
+	hl_destroy(hl);
+}
+
+/**
+ * @brief Create the sparse plane with the f, Q and P patterns, none of them bounded by the board.
+ * @param run settings of the run
+ * @return the plane
+ */
+static struct sparse_t *load_sparse(struct run_t *run)
+{
+	struct sparse_t *s = init_sparse();
+
+	if( !(s) ){
+		printf("Sparse plane allocation has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	read_patterns(run, 0, 0, sparse_cell, s);
+	return s;
+}
+
+/**
+ * @brief Step the sparse plane one generation, leaving if memory runs out.
+ * @param s the plane
+ */
+static void sparse_next(struct sparse_t *s)
+{
+	if(sparse_step(s)){
+		printf("Sparse plane allocation has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * @brief Run the infinite edge a number of generations without a window and report the speed.
+ * @details Any grid engine runs the infinite edge on the sparse plane. Cell updates count the live cells stepped,
+ * as the plane has no area. The dump shows the board sized region from (0, 0).
+ * @param run settings of the run
+ */
+static void headless_sparse(struct run_t *run)
+{
+	struct sparse_t *s = load_sparse(run);
+	struct grid_t *a;
+	struct timespec start;
+	double secs, cells = 0;
+	long g;
+
+	PROF_BEGIN("sparse infinite");
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(g = 0; g < run->gens; g++){
+		cells += s->live.used;
+		PROF_START(t);
+		sparse_next(s);
+		PROF_STOP(PROF_STEP, t);
+		PROF_GENERATION(g + 1);
+	}
+	secs = elapsed(&start);
+	PROF_END(g);
+
+	printf("sparse infinite: %ld generations in %.6f s, %.1f gen/s, population %zu, %.4g live cell updates/s, loaded %ld cells in %.6f s\n", run->gens, secs, run->gens / secs, s->live.used, cells / secs, run->loaded, run->load_secs);
+	if(run->dump){
+		a = init_matrix(run->m_row, run->n_col);
+		if( !(a) ){
+			printf("Matrix Initialization has failed.\n");
+			exit(EXIT_FAILURE);
+		}
+		sparse_to_grid(a, s, 0, 0);
+		print_matrix(a);
+		free_matrix(a);
+	}
+	free_sparse(s);
+}
+
+/**
+ * @brief Write a snapshot of the board to the snapshot file. A failed write is reported and the run goes on.
+ * @param run settings of the run
+ * @param a byte matrix, saved if p is NULL
+ * @param p packed matrix, or NULL
+ * @param type type of edge - hedge, torus, klein
+ * @param generation generation of the board
+ */
+static void checkpoint(struct run_t *run, struct grid_t *a, struct bitgrid_t *p, unsigned char type, long generation)
+{
+	if(p ? snap_save_bits(run->save, p, type, generation) : snap_save(run->save, a, type, generation))
+		printf("Checkpoint to %s has failed.\n", run->save);
+}
+
+/**
+ * @brief Run a fixed number of generations without a window and report the throughput.
+ * @details Prints wall time, generations per second and cell updates per second. Optionally dumps the final generation with print_matrix().
+ * The packed engine is loaded from and dumped to the byte matrix, outside of the timing. The byte engine reports
+ * the row kernel it ran with. With more than one thread the generations run on a thread pool. The tiled engine
+ * runs on one thread and also reports how many of its tiles were updated per generation on average. The blocked
+ * engine runs on one thread and advances each tile up to run->depth generations at a time. The dist engine runs
+ * on run->across by run->down worker processes, each loading and stepping its own rectangle. The main process only
+ * holds the board with -d or -S, and only gathers it back for a checkpoint and for the dump.
+ * With a snapshot file the board is checkpointed every run->every generations, counted from the restored generation,
+ * and once more at the end. Checkpoints are part of the timing. When looking for cycles the board is hashed as it
+ * steps, one generation at a time, and the run stops at the first generation that repeats one of the latest. On a
+ * thread pool it steps up to CYCLE_RING generations at a time and stops at the end of the one the repeat is in.
+ * When rewinding every generation is recorded in the history as it is stepped, also one at a time and part of the
+ * timing, and the board run->rewind generations before the last is rebuilt from it for the dump.
+ * With a stream file a frame is queued for the writer thread every run->frame_every generations, counted from the
+ * restored generation, starting with the board loaded and ending with the last. The writer is waited for only after
+ * the timing. When counting, the steps keep the population, births, deaths and live box of each generation as they
+ * write it, and those of the last are reported.
+ * @param type type of edge - hedge, torus, klein
+ * @param run settings of the run
+ */
+static void headless(unsigned char type, struct run_t *run)
+{
+	static const char *names[] = { ['h'] = "hedge", ['t'] = "torus", ['k'] = "klein" };
+	struct grid_t *a = NULL, *b = NULL, *tmp;
+	struct bitgrid_t *p = NULL, *q = NULL;
+	struct pool_t *pool = NULL;
+	struct tiles_t *tiles = NULL;
+	struct block_t *blocks = NULL;
+	struct dist_t *dist = NULL;
+	struct cycle_t *cycle = NULL;
+	struct history_t *hist = NULL;
+	struct stream_t *stream = NULL;
+	struct stats_t sa, sb;
+	struct timespec start;
+	double secs;
+	long g, chunk, saved = 0, period = 0, lost = 0;
+
+	/* the workers of the dist engine hold the board, which is only wanted here to save or dump it */
+	if( ((run->engine != DIST || run->dump || run->save) && !(a = init_matrix(run->m_row, run->n_col)))
+	   || (run->engine != DIST && !(b = init_matrix(run->m_row, run->n_col))) ){
+		printf("Matrix Initialization has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run->threads > 1 && (run->engine == BYTE || run->engine == PACKED) && !(pool = pool_create(run->threads, a->stride, BIT_WORDS(run->n_col)))){
+		printf("Thread pool creation has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run->engine == TILED && !(tiles = init_tiles(run->m_row, run->n_col))){
+		printf("Tile Initialization has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run->engine == BLOCKED && !(blocks = init_block(run->m_row, run->n_col, run->depth))){
+		printf("Tile Initialization has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run->cycle && !(cycle = init_cycle(run->m_row, run->n_col))){
+		printf("Matrix Initialization has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run->rewind && !(hist = init_history(run->m_row, run->n_col, run->history, run->keyframe))){
+		printf("History Initialization has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if(run->engine == DIST){
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if( !(dist = dist_open(run->m_row, run->n_col, type, run->across, run->down, run->link, dist_load, run)) ){
+			printf("Worker processes could not be started.\n");
+			exit(EXIT_FAILURE);
+		}
+		if(dist->outside){
+			printf("Cell out of bound\n");
+			exit(EXIT_FAILURE);
+		}
+		run->loaded = dist->loaded;
+		run->load_secs = elapsed(&start);
+	}
+	else
+		load_patterns(a, type, run);
+	if(cycle){
+		a->hash = b->hash = &cycle->hash;
+		cycle_grid(cycle, a);
+		cycle_check(cycle, run->generation);
+	}
+	if(hist)
+		lost += history_push(hist, a, run->generation) != 0;
+	if(run->stream && !(stream = stream_open(run->stream, run->m_row, run->n_col, type, run->keyframe))){
+		fprintf(stderr, "stream file %s could not be written: %s\n", run->stream, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	if(stream && stream_frame(stream, a, run->generation)){
+		printf("Writing the stream to %s has failed.\n", run->stream);
+		exit(EXIT_FAILURE);
+	}
+
+	if(run->engine == PACKED){
+		p = init_bitgrid(run->m_row, run->n_col);
+		q = init_bitgrid(run->m_row, run->n_col);
+		if( !(p) || !(q) ){
+			printf("Matrix Initialization has failed.\n");
+			exit(EXIT_FAILURE);
+		}
+		bit_from_grid(p, a);
+		if(cycle){
+			p->hash = q->hash = &cycle->hash;
+			cycle_bits(cycle, p);
+			cycle_check(cycle, run->generation);
+		}
+	}
+	if(run->stats){
+		stats_grid(&sa, a);
+		stats_clear(&sb);
+		if(p){
+			p->stats = &sa;
+			q->stats = &sb;
+		}
+		else{
+			a->stats = &sa;
+			b->stats = &sb;
+		}
+	}
+
+	PROF_BEGIN("%s%s%s %s x%d", engines[run->engine], run->engine != PACKED ? "/" : "", run->engine != PACKED ? kernel->name : "", names[type], run->engine == DIST ? run->across * run->down : (run->engine == TILED || run->engine == BLOCKED) ? 1 : run->threads);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(g = 0; g < run->gens && !period; g += chunk){
+		chunk = run->gens - g;
+		if(run->save && run->every && run->every - (run->generation + g) % run->every < chunk)
+			chunk = run->every - (run->generation + g) % run->every;
+		if(stream && run->frame_every - (run->generation + g) % run->frame_every < chunk)
+			chunk = run->frame_every - (run->generation + g) % run->frame_every;
+		/* the timings and history are per generation, and so are cycles but on a thread pool, which leaves a trail of
+		   up to CYCLE_RING generations */
+		if(hist || run->profile || (cycle && !pool))
+			chunk = 1;
+		if(cycle && chunk > CYCLE_RING)
+			chunk = CYCLE_RING;
+		PROF_START(t);
+		if(pool && run->engine == BYTE)
+			pool_step(pool, &a, &b, type, chunk);
+		else if(pool)
+			pool_bit_step(pool, &p, &q, type, chunk);
+		else switch(run->engine){
+			case BYTE:
+				/* the timings are per generation, so chunk is 1 */
+				if(run->profile)
+					prof_step(&a, &b, type);
+				else
+					grid_run(&a, &b, type, chunk);
+				break;
+			case PACKED:
+				bit_run(&p, &q, type, chunk);
+				break;
+			case TILED:
+				tile_run(tiles, &a, &b, type, chunk);
+				break;
+			case BLOCKED:
+				block_run(blocks, &a, &b, type, chunk);
+				break;
+			case DIST:
+				/* the board is only gathered for a checkpoint or the dump */
+				tmp = (run->save && (g + chunk == run->gens || (run->every && (run->generation + g + chunk) % run->every == 0)))
+				      || (run->dump && g + chunk == run->gens) ? a : NULL;
+				if(dist_step(dist, tmp, chunk)){
+					printf("A worker process has failed.\n");
+					exit(EXIT_FAILURE);
+				}
+				break;
+			default:
+				break;
+		}
+		if(pool || run->engine != BYTE)
+			PROF_STOP(PROF_STEP, t);
+		PROF_GENERATION(run->generation + g + chunk);
+		if(cycle)
+			period = pool ? cycle_trail(cycle, run->generation + g, chunk) : cycle_check(cycle, run->generation + g + chunk);
+		if(hist)
+			lost += (p ? history_push_bits(hist, p, run->generation + g + chunk) : history_push(hist, a, run->generation + g + chunk)) != 0;
+		if(stream && (g + chunk == run->gens || period || (run->generation + g + chunk) % run->frame_every == 0)
+		   && (p ? stream_frame_bits(stream, p, run->generation + g + chunk) : stream_frame(stream, a, run->generation + g + chunk))){
+			printf("Writing the stream to %s has failed.\n", run->stream);
+			exit(EXIT_FAILURE);
+		}
+		if(run->save && (g + chunk == run->gens || period || (run->every && (run->generation + g + chunk) % run->every == 0))){
+			checkpoint(run, a, p, type, run->generation + g + chunk);
+			saved++;
+		}
+	}
+	secs = elapsed(&start);
+	PROF_END(run->generation + g);
+	if(pool)
+		pool_destroy(pool);
+	if(dist)
+		dist_close(dist);
+
+	printf("%s%s%s %s x%d: %ld generations of %dx%d in %.6f s, %.1f gen/s, %.4g cell updates/s, loaded %ld cells in %.6f s\n", engines[run->engine], run->engine != PACKED ? "/" : "", run->engine != PACKED ? kernel->name : "", names[type], run->engine == DIST ? run->across * run->down : (run->engine == TILED || run->engine == BLOCKED) ? 1 : run->threads, g, run->m_row, run->n_col, secs, g / secs, (double)g * run->m_row * run->n_col / secs, run->loaded, run->load_secs);
+	if(period)
+		printf("cycle of period %ld from generation %ld, stopped at generation %ld\n", period, cycle->found - period, run->generation + g);
+	else if(cycle)
+		printf("no cycle of period %d or less by generation %ld\n", CYCLE_RING, run->generation + g);
+	if(cycle)
+		free_cycle(cycle);
+	if(run->save)
+		printf("%ld checkpoints to %s, the last at generation %ld\n", saved, run->save, run->generation + g);
+	if(stream){
+		printf("stream of %ld frames and %zu bytes to %s, %ld left out for want of room", stream->frames, stream->bytes, run->stream, stream->dropped);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if(stream_close(stream)){
+			printf("\nWriting the stream to %s has failed.\n", run->stream);
+			exit(EXIT_FAILURE);
+		}
+		printf(", written %.6f s after the run\n", elapsed(&start));
+	}
+	if(run->stats){
+		struct stats_t *s = p ? p->stats : a->stats;
+		printf("population %ld, births %ld, deaths %ld in the last generation, ", s->population, s->births, s->deaths);
+		if(s->bottom < s->top)
+			printf("no live cells\n");
+		else
+			printf("live cells in rows %d to %d and collums %d to %d\n", s->top, s->bottom, s->left, s->right);
+	}
+	if(tiles){
+		printf("tiles %dx%d of %d cells: %.1f of %d updated per generation\n", tiles->t_row, tiles->t_col, TILE_SIZE, (double)tiles->updated / g, tiles->t_row * tiles->t_col);
+		free_tiles(tiles);
+	}
+	if(blocks){
+		printf("tiles %dx%d advanced up to %d generations at a time in cache\n", blocks->width, blocks->height, blocks->depth);
+		free_block(blocks);
+	}
+	if(run->engine == DIST)
+		printf("workers %dx%d swapping halos over %s\n", run->across, run->down, run->link);
+	if(p){
+		bit_to_grid(a, p);
+		free_bitgrid(p);
+		free_bitgrid(q);
+	}
+	if(hist){
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if(history_seek(hist, run->generation + g - run->rewind, a) == 0)
+			printf("rewound %ld generations to generation %ld in %.6f s\n", run->rewind, run->generation + g - run->rewind, elapsed(&start));
+		else
+			printf("generation %ld is no longer held, showing generation %ld\n", run->generation + g - run->rewind, run->generation + g);
+		printf("history of generations %ld to %ld in %zu bytes, %d keyframes every %d generations", history_oldest(hist), history_newest(hist), hist->bytes, hist->keys, hist->interval);
+		if(lost)
+			printf(", %ld generations too large for %zu bytes", lost, hist->budget);
+		printf("\n");
+		free_history(hist);
+	}
+	if(run->dump)
+		print_matrix(a);
+
+	free_matrix(a);
+	free_matrix(b);
+}
+
+/**
+ * @brief Run a batch of random soups across threads and report how they ended and how many soups ran per second.
+ * @details Every soup runs on the packed engine until it repeats or reaches the generation limit, SOUP_GENS unless
+ * -n is given. The results are written to the CSV file in seed order, one line per soup.
+ * @param run settings of the run
+ * @param type type of edge - hedge, torus, klein
+ */
+static void batch(struct run_t *run, unsigned char type)
+{
+	static const char *names[] = { ['h'] = "hedge", ['t'] = "torus", ['k'] = "klein" };
+	struct batch_t b = { .m_row = run->m_row, .n_col = run->n_col, .type = type, .gens = run->gens ? run->gens : SOUP_GENS, .first = run->seed, .count = run->soups, .threads = run->threads };
+	struct timespec start;
+	double secs, population = 0;
+	long i, settled = 0;
+	FILE *out;
+
+	b.result = malloc(run->soups * sizeof(struct soup_t));
+	if( !(b.result) ){
+		printf("Soup result allocation has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if(soup_batch(&b)){
+		printf("Soup search has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	secs = elapsed(&start);
+
+	for(i = 0; i < b.count; i++){
+		population += b.result[i].population;
+		settled += b.result[i].period != 0;
+	}
+	printf("soup search %s x%d: %ld soups of %dx%d in %.6f s, %.1f soups/s, %ld settled within %ld generations, mean population %.1f\n", names[type], b.threads, b.count, b.m_row, b.n_col, secs, b.count / secs, settled, b.gens, population / b.count);
+
+	if(run->results){
+		errno = 0;
+		out = fopen(run->results, "w");
+		if (out == NULL) {
+			fprintf(stderr, "results file %s could not be written: %s\n", run->results, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		fprintf(out, "seed,population,settled,period\n");
+		for(i = 0; i < b.count; i++)
+			fprintf(out, "%" PRIu64 ",%ld,%ld,%ld\n", b.result[i].seed, b.result[i].population, b.result[i].settled, b.result[i].period);
+		fclose(out);
+	}
+	free(b.result);
+}
+
+/**
+ * @brief Step the engine of the simulation a number of generations.
+ * @details Only the blocked engine is asked for more than one, advancing each tile that many generations in cache.
+ * @param sim the simulation
+ * @param gens generations to step, 1 to the depth of the blocks for the blocked engine and otherwise 1
+ */
+static void sim_step(struct sim_t *sim, int gens)
+{
+	PROF_START(t);
+	if(sim->hl)
+		hl_jump(sim->hl, 1);
+	else if(sim->plane)
+		sparse_next(sim->plane);
+	else if(sim->tiles)
+		tile_run(sim->tiles, &sim->a, &sim->b, sim->type, 1);
+	else if(sim->blocks)
+		block_run(sim->blocks, &sim->a, &sim->b, sim->type, gens);
+	else if(sim->pool && sim->p)
+		pool_bit_step(sim->pool, &sim->p, &sim->q, sim->type, 1);
+	else if(sim->pool)
+		pool_step(sim->pool, &sim->a, &sim->b, sim->type, 1);
+	else if(sim->p)
+		bit_run(&sim->p, &sim->q, sim->type, 1);
+	else if(sim->run->profile)
+		prof_step(&sim->a, &sim->b, sim->type);
+	else
+		grid_run(&sim->a, &sim->b, sim->type, 1);
+	/* the byte engine times its edge and mid in prof_step() */
+	if(sim->hl || sim->plane || sim->tiles || sim->blocks || sim->pool || sim->p)
+		PROF_STOP(PROF_STEP, t);
+}
+
+/**
+ * @brief Fill a frame with what the view shows of the current generation.
+ * @details The hashlife and sparse planes are indexed by pattern x and y, which are the board collum and row.
+ * @param sim the simulation
+ * @param frame frame of the window size
+ */
+static void sim_frame(struct sim_t *sim, struct frame_t *frame)
+{
+	long block, r;
+	int shift, i;
+
+	view_frame(sim->view, frame);
+	shift = frame->zoom < 0 ? -frame->zoom : 0;
+	block = 1L << shift;
+	/* only the strips showing rows that changed are redrawn, unless the view moved */
+	frame->full = !sim->dirty || frame->x != sim->last.x || frame->y != sim->last.y || frame->zoom != sim->last.zoom;
+	if(!frame->full){
+		for(i = 0; i < frame->w; i++){
+			frame->dirty[i] = 0;
+			for(r = frame->x + i * block; r < frame->x + (i + 1) * block && !frame->dirty[i]; r++)
+				if(r >= 0 && r < sim->run->m_row)
+					frame->dirty[i] = sim->dirty[r];
+		}
+	}
+	if(sim->dirty)
+		memset(sim->dirty, 0, sim->run->m_row);
+	sim->last = *frame;
+
+	if(sim->hl)
+		hl_density(sim->hl, frame->cells, frame->w, frame->h, frame->y, frame->x, shift);
+	else if(sim->plane){
+		if(sparse_density(frame->cells, sim->plane, frame->w, frame->h, frame->y, frame->x, shift)){
+			printf("Sparse plane allocation has failed.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	else if(sim->p)
+		frame_from_bits(frame, sim->p);
+	else
+		frame_from_grid(frame, sim->a);
+}
+
+/**
+ * @brief Set the board back a number of generations through the history, or to the oldest it holds. The
+ * generations after it are dropped, so the simulation runs on from there.
+ * @details The census is counted again and every row marked dirty, as the whole board may have changed.
+ * @param sim the simulation
+ * @param gens generations to step back
+ */
+static void sim_back(struct sim_t *sim, long gens)
+{
+	long g = sim->generation - gens;
+
+	if(g < history_oldest(sim->hist))
+		g = history_oldest(sim->hist);
+	if(g < 0 || history_truncate(sim->hist, g))
+		return;
+	if(sim->p){
+		history_seek_bits(sim->hist, g, sim->p);
+		census_bits(sim->census, sim->p);
+	}
+	else{
+		history_seek(sim->hist, g, sim->a);
+		census_grid(sim->census, sim->a);
+	}
+	if(sim->tiles)
+		tiles_all(sim->tiles);
+	memset(sim->dirty, 1, sim->run->m_row);
+	sim->generation = g;
+}
+
+/**
+ * @brief Simulation thread. Steps the generations as fast as it can and publishes a frame whenever the renderer
+ * has taken the last one. Checkpoints the board every run->every generations if asked to.
+ * @details While the renderer still has a frame to take, the blocked engine advances up to run->depth generations
+ * at a time, stopping short at a checkpoint. Otherwise every engine steps one generation. With -z every generation
+ * is recorded in the history, and the board is set back through it when the renderer asks. While paused no
+ * generation is stepped, but frames are still made for the view to move.
+ * @param arg the simulation
+ */
+static void *simulate(void *arg)
+{
+	struct sim_t *sim = arg;
+	struct run_t *run = sim->run;
+	long back;
+	int gens;
+
+	while(!atomic_load(&sim->quit)){
+		if((back = atomic_exchange(&sim->back, 0)))
+			sim_back(sim, back * run->rewind);
+		if(atomic_load(&sim->paused)){
+			if(triple_wanted(sim->frames)){
+				sim_frame(sim, triple_back(sim->frames));
+				triple_publish(sim->frames);
+			}
+			SDL_Delay(1);
+			continue;
+		}
+		gens = 1;
+		if(sim->blocks && !sim->hist && !triple_wanted(sim->frames)){
+			gens = run->depth;
+			if(run->save && run->every && run->every - sim->generation % run->every < gens)
+				gens = run->every - sim->generation % run->every;
+		}
+		sim_step(sim, gens);
+		sim->generation += gens;
+		PROF_GENERATION(sim->generation);
+		if(sim->hist && sim->p)
+			history_push_bits(sim->hist, sim->p, sim->generation);
+		else if(sim->hist)
+			history_push(sim->hist, sim->a, sim->generation);
+		if(run->save && run->every && sim->generation % run->every == 0)
+			checkpoint(run, sim->a, sim->p, sim->type, sim->generation);
+		if(triple_wanted(sim->frames)){
+			PROF_START(t);
+			sim_frame(sim, triple_back(sim->frames));
+			triple_publish(sim->frames);
+			PROF_STOP(PROF_FRAME, t);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Stop the simulation thread once it finishes its generation, then write the timings and the snapshot file if there are any.
+ * @param sim the simulation
+ * @param tid the simulation thread
+ */
+static void sim_stop(struct sim_t *sim, pthread_t tid)
+{
+	atomic_store(&sim->quit, 1);
+	pthread_join(tid, NULL);
+	PROF_END(sim->generation);
+	PROF_CLOSE();
+	if(sim->run->save)
+		checkpoint(sim->run, sim->a, sim->p, sim->type, sim->generation);
+	if(sim->pool)
+		pool_destroy(sim->pool);
+	if(sim->blocks)
+		free_block(sim->blocks);
+	if(sim->hist)
+		free_history(sim->hist);
+}
 
 /** Run Convey's Game of Life. Accept input as settings.
- * @remark Extra Crdit: Pattern 1 is store in fp. Pattern 2 is store in Qp. Pattern 3 is tore in Pp. Argument are compatable with BOTH 1.05 and 1.06.
+ * @remark Extra Crdit: Pattern 1 is store in fp. Pattern 2 is store in Qp. Pattern 3 is tore in Pp. Argument are compatable with 1.05, 1.06 and RLE.
  * @param argc Number of command line arguments
  * @param argv String or arguments.
  * @param c arument letter
  * @param width size of screen width
  * @param height size of screen height
- * @param sprite_size ratio to upscale pixles
+ * @param sprite_size ratio to upscale pixles, the starting zoom of the view
  * @param red pixle's intensity value for red
  * @param green ixle's intensity value for green
  * @param blue pixle's intensity value for blue
@@ -54,14 +890,21 @@
  * @param q_yinitial y cordinate for Q pattern
  * @param p_xinitial x cordinate for P pattern
  * @param p_y initial y cordinate for P pattern
+ * @param run settings of the run, gathered from the arguments
+ * @param edge_set set if -e was given, otherwise headless runs every edge type
+ * @param isa_set set if -I was given, otherwise the byte engine runs headless once per supported kernel
+ * @param k kernel being reported
  */
 int main(int argc, char *argv[])
 {
-	FILE *fp = NULL, *Qp = NULL, *Pp = NULL;
-	int c, width = 400, height = 400, x = 0, y = 0, q_x = 0, q_y = 0, p_x = 0, p_y = 0; /* either 2, 4, 8, or 16 */
+	struct run_t run = { .engine = BYTE, .threads = 1, .depth = BLOCK_DEPTH, .across = 2, .down = 2, .link = "shm", .memory = (size_t)1 << 30, .history = (size_t)64 << 20, .keyframe = HISTORY_KEY, .frame_every = 1 };
+	int c, width = 400, height = 400, edge_set = 0, isa_set = 0, threads_set = 0, rule_given = 0; /* either 2, 4, 8, or 16 */
+	const char *isa = NULL;
+	const struct kernel_t *k;
+	const struct link_t *l;
 	unsigned char red = 255, green = 255, blue = 255, sprite_size = 16, type = 'h';
 
-	while((c = getopt(argc, argv, "w:h:e:r:g:b:s:f:P:Q:o:p:q:H")) != -1)
+	while((c = getopt(argc, argv, "w:h:e:r:g:b:s:f:P:Q:o:p:q:n:x:y:dE:I:j:D:W:X:M:S:k:L:cB:O:R:T:u:z:A:K:F:G:aH")) != -1)
 		switch(c) {
 		case 'w':
 			width = atoi(optarg);
@@ -78,11 +921,12 @@ int main(int argc, char *argv[])
 			}
 			break;
 		case 'e':
-			if( !( !(strcmp(optarg,"hedge")) || !(strcmp(optarg,"torus")) || !(strcmp(optarg,"klein")) ) ){
-			printf("Invalid edge value. Value must be \"hedge\" \"torus\" \"klein\".\n");
+			if( !( !(strcmp(optarg,"hedge")) || !(strcmp(optarg,"torus")) || !(strcmp(optarg,"klein")) || !(strcmp(optarg,"infinite")) ) ){
+			printf("Invalid edge value. Value must be \"hedge\" \"torus\" \"klein\" \"infinite\".\n");
 			exit(EXIT_FAILURE);
 			}
 			type = optarg[0];
+			edge_set = 1;
 			break;
 		case 'r':
 			if( !(atoi(optarg) >= 0 && atoi(optarg) <=255) ){
@@ -116,8 +960,8 @@ int main(int argc, char *argv[])
 			errno = 0; /* set to 0 so can process it if an error occurs */
                         /* assume filename comes after -f */
 			/* optarg contains the argument for the option */
-			Pp = fopen(optarg, "r");
-			if (Pp == NULL) {
+			run.Pp = fopen(optarg, "r");
+			if (run.Pp == NULL) {
 				/* strerror */
 				fprintf(stderr, "%s: argument to option '-P' failed: %s\n", argv[0], strerror(errno));
 				exit(EXIT_FAILURE);
@@ -127,8 +971,8 @@ int main(int argc, char *argv[])
 			errno = 0; /* set to 0 so can process it if an error occurs */
                         /* assume filename comes after -Q */
 			/* optarg contains the argument for the option */
-			Qp = fopen(optarg, "r");
-			if (Qp == NULL) {
+			run.Qp = fopen(optarg, "r");
+			if (run.Qp == NULL) {
 				/* strerror */
 				fprintf(stderr, "%s: argument to option '-Q' failed: %s\n", argv[0], strerror(errno));
 				exit(EXIT_FAILURE);
@@ -138,8 +982,8 @@ int main(int argc, char *argv[])
 			errno = 0; /* set to 0 so can process it if an error occurs */
                         /* assume filename comes after -f */
 			/* optarg contains the argument for the option */
-			fp = fopen(optarg, "r");
-			if (fp == NULL) {
+			run.fp = fopen(optarg, "r");
+			if (run.fp == NULL) {
 				/* strerror */
 				fprintf(stderr, "%s: argument to option '-f' failed: %s\n", argv[0], strerror(errno));
 				exit(EXIT_FAILURE);
@@ -147,31 +991,218 @@ int main(int argc, char *argv[])
 
 			break;
 		case 'o':
-			sscanf(optarg,"%d,%d",&x, &y);
+			sscanf(optarg,"%d,%d",&run.x, &run.y);
 			break;
 		case 'p':
-			sscanf(optarg,"%d,%d",&p_x, &p_y);
+			sscanf(optarg,"%d,%d",&run.p_x, &run.p_y);
 			break;
 		case 'q':
-            sscanf(optarg,"%d,%d",&q_x, &q_y);
+            sscanf(optarg,"%d,%d",&run.q_x, &run.q_y);
+			break;
+		case 'n':
+			run.gens = atol(optarg);
+			if( !(run.gens>0) ){
+				printf("Invalid generation count. Value must be greater than 0.\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'x':
+			run.m_row = atoi(optarg);
+			if( !(run.m_row>2) ){
+				printf("Invalid x value. Value must be greater than 2.\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'y':
+			run.n_col = atoi(optarg);
+			if( !(run.n_col>2) ){
+				printf("Invalid y value. Value must be greater than 2.\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'd':
+			run.dump = 1;
+			break;
+		case 'E':
+			for(run.engine = BYTE; run.engine <= DIST; run.engine++)
+				if( !(strcmp(optarg, engines[run.engine])) )
+					break;
+			if( run.engine > DIST ){
+				printf("Invalid engine value. Value must be \"byte\" \"packed\" \"hashlife\" \"tiled\" \"blocked\" \"dist\".\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'I':
+			/* selected once every option is read */
+			isa = optarg;
+			isa_set = 1;
+			break;
+		case 'R':
+			if( rule_set(optarg) ){
+				printf("Invalid rule value. Value must be B then S neighbour counts 0 to 8, such as B3/S23, B36/S23 or B2/S.\n");
+				exit(EXIT_FAILURE);
+			}
+			rule_given = 1;
+			break;
+		case 'M':
+			if( !(atol(optarg) >= 0) ){
+				printf("Invalid memory value. Value must be 0 or more megabytes.\n");
+				exit(EXIT_FAILURE);
+			}
+			run.memory = (size_t)atol(optarg) << 20;
+			break;
+		case 'j':
+			run.threads = atoi(optarg);
+			if( !(run.threads>0) ){
+				printf("Invalid thread count. Value must be greater than 0.\n");
+				exit(EXIT_FAILURE);
+			}
+			threads_set = 1;
+			break;
+		case 'D':
+			run.depth = atoi(optarg);
+			if( !(run.depth>0 && run.depth<=BLOCK_DEPTH_MAX) ){
+				printf("Invalid depth value. Value must be 1 to %d generations.\n", BLOCK_DEPTH_MAX);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'W':
+			if( sscanf(optarg, "%dx%d", &run.across, &run.down) != 2 || !(run.across>0 && run.down>0) ){
+				printf("Invalid worker grid. Value must be across x down, such as 2x2, both greater than 0.\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'X':
+			for(l = links; l->name; l++)
+				if( !(strcmp(optarg, l->name)) )
+					break;
+			if( !(l->name) ){
+				printf("Invalid link value. Value must be \"shm\" or \"tcp\".\n");
+				exit(EXIT_FAILURE);
+			}
+			run.link = l->name;
+			break;
+		case 'S':
+			run.save = optarg;
+			break;
+		case 'k':
+			run.every = atol(optarg);
+			if( !(run.every>0) ){
+				printf("Invalid checkpoint interval. Value must be greater than 0.\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'c':
+			run.cycle = 1;
+			break;
+		case 'B':
+			if( sscanf(optarg, "%" SCNu64 ",%ld", &run.seed, &run.soups) != 2 || !(run.soups>0) ){
+				printf("Invalid soup range. Value must be seed,count with a count greater than 0.\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'O':
+			run.results = optarg;
+			break;
+		case 'T':
+#ifndef LIFE_PROF
+			printf("Phase timings are not built in. Build with make PROF=1 to use -T.\n");
+			exit(EXIT_FAILURE);
+#endif
+			run.profile = optarg;
+			break;
+		case 'u':
+			run.profile_every = atol(optarg);
+			if( !(run.profile_every>0) ){
+				printf("Invalid timing interval. Value must be greater than 0.\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'z':
+			run.rewind = atol(optarg);
+			if( !(run.rewind>0) ){
+				printf("Invalid rewind value. Value must be greater than 0.\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'A':
+			if( !(atol(optarg) > 0) ){
+				printf("Invalid history value. Value must be 1 or more megabytes.\n");
+				exit(EXIT_FAILURE);
+			}
+			run.history = (size_t)atol(optarg) << 20;
+			break;
+		case 'K':
+			run.keyframe = atoi(optarg);
+			if( !(run.keyframe>0) ){
+				printf("Invalid keyframe interval. Value must be greater than 0.\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'F':
+			run.stream = optarg;
+			break;
+		case 'G':
+			run.frame_every = atol(optarg);
+			if( !(run.frame_every>0) ){
+				printf("Invalid frame interval. Value must be greater than 0.\n");
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'a':
+			run.stats = 1;
+			break;
+		case 'L':
+			run.restore = snap_open(optarg);
+			if( !(run.restore) ){
+				printf("Invalid snapshot file. It could not be read or was not written by life.\n");
+				exit(EXIT_FAILURE);
+			}
 			break;
 
 		case 'H': 	/* help */
 			printf("usage: life -w -h -e -r -g -b -s -f filename pattern -o \n");
 			printf("-w width of the screen argument 640, 800, 1024, etc.\n");
 			printf("-h height of the screen argument 480, 600, 768, etc.\n");
-			printf("-e type of edge. Values are hedge, torus or klein (strings)\n");
+			printf("-e type of edge. Values are hedge, torus, klein or infinite (strings). Infinite runs on a sparse unbounded plane.\n");
 			printf("-r the red color value, an integer between [0, 255]\n");
 			printf("-g the green color value, an integer between [0, 255]\n");
 			printf("-b the blue color value, an integer between [0, 255]\n");
-			printf("-s size of the sprite. Valid values are 2, 4, 8, or 16 only. An integer.\n");
-			printf("-f filename, a life pattern in file format 1.06.\n");
+			printf("-s size of the sprite, pixels to a cell before zooming. Valid values are 2, 4, 8, or 16 only. An integer.\n");
+			printf("-f filename, a life pattern in file format 1.05, 1.06 or RLE.\n");
 			printf("-o x,y the initial x,y coordinate of the pattern found in the file. Nospace between the x and y.\n");
 			printf("help, print out usage information and a brief description of each, option.\n");
-			printf("-P filename, a life pattern in file format 1.06\n");
-			printf("-Q filename, a life pattern in file format 1.05\n");
+			printf("-P filename, a life pattern in file format 1.05, 1.06 or RLE\n");
+			printf("-Q filename, a life pattern in file format 1.05, 1.06 or RLE\n");
 			printf("-p x,y the initial coordinate of pattern P\n");
 			printf("-q x,y the initial coordinate of pattern Q\n");
+			printf("-n generations, run headless (no window) for this many generations and report the speed.\n");
+			printf("-x cells, number of cells across the board. Defaults to width / sprite size.\n");
+			printf("-y cells, number of cells down the board. Defaults to height / sprite size.\n");
+			printf("-d dump the final headless generation to the terminal.\n");
+			printf("-E engine. Values are byte (one byte per cell), packed (one bit per cell), hashlife (unbounded plane, no edge) tiled (byte, only updating tiles near a change) blocked (byte, advancing each tile several generations while it is in cache) or dist (byte, split across worker processes that each load their own rectangle, headless only, the board gathered only for -d and -S).\n");
+			printf("-I row kernel of the byte engine. Values are scalar, lut (lookup table, 4 cells per load), sse2 or avx2. Defaults to the fastest the CPU supports.\n");
+			printf("In the window the arrow keys or dragging with the left button pan, and + - or the mouse wheel zoom.\n");
+			printf("-M megabytes, memory the hashlife engine may use before it drops unused nodes. 0 for no cap. Defaults to 1024.\n");
+			printf("-j threads, number of threads stepping the board in bands of rows. Defaults to 1. Not used by the tiled, blocked and dist engines.\n");
+			printf("-D generations, how many generations the blocked engine advances each tile at a time, 1 to %d, in the window only while no frame is wanted. Defaults to %d.\n", BLOCK_DEPTH_MAX, BLOCK_DEPTH);
+			printf("-W across x down, worker processes of the dist engine, each stepping a rectangle of the board. Defaults to 2x2.\n");
+			printf("-X link, how the workers of the dist engine swap the cells around their rectangles. Values are shm (POSIX shared memory) or tcp (sockets on the loopback). Defaults to shm.\n");
+			printf("-S filename, snapshot file. The board is saved to it at the end of the run and at every checkpoint. Hedge, torus and klein only.\n");
+			printf("-k generations, checkpoint the board to the snapshot file every this many generations.\n");
+			printf("-c stop a headless run once the board repeats, reporting the period. Finds cycles of up to %d generations. Hedge, torus and klein only.\n", CYCLE_RING);
+			printf("-B seed,count, search count random soups from seed on, one per thread at a time, and report soups per second. Boards default to 64x64 torus, -j to every core and -n to %d.\n", SOUP_GENS);
+			printf("-O filename, write the population, settling generation and period of every soup of -B to a CSV file.\n");
+			printf("-L filename, restore the board, its size, edge, rule and generation from a snapshot in place of the patterns. -e and -R still set the edge and rule.\n");
+			printf("-T filename, write the time taken by each phase of the main loop (edge, mid, swap, step, frame, render, poll and the whole generation) with p50 and p99, and the hardware counters where Linux allows, to a file. CSV if it ends in .csv, otherwise one JSON object per line. Needs a build with make PROF=1.\n");
+			printf("-u generations, also write the timings every this many generations.\n");
+			printf("-z generations, at the end of a headless run step back this many generations through the history of the run and dump that board with -d. In the window backspace pauses and steps back this many generations, and space pauses or runs on. Hedge, torus and klein only.\n");
+			printf("-A megabytes, memory the history of -z may take. The oldest generations are dropped past it. Defaults to 64.\n");
+			printf("-K count, how often the history of -z (in generations) and the stream of -F (in frames) store the whole board rather than the cells that changed. Defaults to %d.\n", HISTORY_KEY);
+			printf("-F filename, stream the generations of a headless run to a file or named pipe as binary frames, the format given in stream.h. A writer thread writes them out, frames it has no room for are left out rather than waited for. Hedge, torus and klein only.\n");
+			printf("-G generations, write a frame to the stream of -F every this many generations. Defaults to 1.\n");
+			printf("-a count the population, births, deaths and box of the live cells as a headless run steps and report those of the last generation. Hedge boards are then only stepped around their live cells. Byte and packed engines only.\n");
+			printf("-R rule, as B then S neighbour counts. B3/S23 (life, the default), B36/S23 (highlife), B2/S (seeds) and B3678/S34678 (day and night) have kernels of their own, other rules use tables.\n");
 			exit(EXIT_SUCCESS);
 		case ':':
 			/* missing option argument */
@@ -190,80 +1221,268 @@ int main(int argc, char *argv[])
 		//printf("w%d h%d e%c r%d g%d b%d s%d f%p %d %d\n", width, height, type, red, green, blue, sprite_size, fp, x, y);
 
 	//return 0;
-    int m_row = width/sprite_size, n_col = height/sprite_size;
-	struct sdl_info_t sdl_info; /* this is needed to graphically display the game */
-	init_sdl_info(&sdl_info, width, height, sprite_size, red, green, blue);
-
-	unsigned char **a = init_matrix(m_row,n_col), **b = init_matrix(m_row,n_col), **tmp;
-
-	if( !(a) || !(b) ){
-		printf("Matrix Initialization has failed.\n");
+	if(run.restore && !rule_given)
+		rule_set(run.restore->head->rule);
+	if((rule.birth & 1) && (run.engine == HASHLIFE || type == 'i')){
+		printf("Rules with B0 only run on hedge, torus and klein boards.\n");
+		exit(EXIT_FAILURE);
+	}
+#ifdef LIFE_PROF
+	if(run.profile && prof_open(run.profile, run.profile_every)){
+		fprintf(stderr, "timings file %s could not be written: %s\n", run.profile, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+#endif
+	if(run.soups){
+		if(run.m_row == 0)
+			run.m_row = 64;
+		if(run.n_col == 0)
+			run.n_col = 64;
+		if(!edge_set)
+			type = 't';
+		if(!threads_set && sysconf(_SC_NPROCESSORS_ONLN) > 0)
+			run.threads = sysconf(_SC_NPROCESSORS_ONLN);
+		if(type == 'i'){
+			printf("Soups are only searched on hedge, torus and klein boards.\n");
+			exit(EXIT_FAILURE);
+		}
+		batch(&run, type);
+		return 0;
+	}
+	if(kernel_select(isa)){
+		printf("Invalid kernel value. Value must be \"scalar\" \"lut\" \"sse2\" \"avx2\" and supported by the CPU.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run.m_row == 0)
+		run.m_row = width/sprite_size;
+	if(run.n_col == 0)
+		run.n_col = height/sprite_size;
+	if(run.restore){
+		run.m_row = run.restore->head->m_row;
+		run.n_col = run.restore->head->n_col;
+		run.generation = run.restore->head->generation;
+		if(!edge_set)
+			type = run.restore->head->edge;
+		edge_set = 1;
+	}
+	if(run.every && !(run.save)){
+		printf("A checkpoint interval needs a snapshot file, set with -S.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run.cycle && (run.engine == HASHLIFE || type == 'i')){
+		printf("Cycles are only looked for on hedge, torus and klein boards.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run.engine == DIST && (run.gens <= 0 || run.cycle || run.rewind || run.stream || type == 'i')){
+		printf("The dist engine only runs headless, with -n, on hedge, torus and klein boards and without -c, -z or -F.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run.engine == DIST && (run.across > run.n_col || run.down > run.m_row)){
+		printf("Invalid worker grid. There must be no more workers across and down than cells.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run.rewind && (run.engine == HASHLIFE || type == 'i')){
+		printf("Rewinding is only done on hedge, torus and klein boards.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run.stream && (run.gens <= 0 || run.engine == HASHLIFE || type == 'i')){
+		printf("Streams are only written by headless runs, with -n, of hedge, torus and klein boards.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run.stats && (run.gens <= 0 || (run.engine != BYTE && run.engine != PACKED) || type == 'i')){
+		printf("The population is only counted by headless runs, with -n, of the byte and packed engines on hedge, torus and klein boards.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run.save && (run.engine == HASHLIFE || type == 'i')){
+		printf("Snapshots are only written of hedge, torus and klein boards.\n");
 		exit(EXIT_FAILURE);
 	}
 
-	if ((fp != NULL))
-		pattern_in(a, type, fp, x, y, m_row, n_col);
-	if ((Qp != NULL))
-		pattern_in(a, type, Qp, q_x, q_y, m_row, n_col);
-	if ((Pp != NULL))
-		pattern_in(a, type, Pp, p_x, p_y, m_row, n_col);
-	else{
-		a[1][0] = 1;
-		a[1][1] = 1;
-		a[1][2] = 1;
+	if(run.gens > 0){
+		if(run.engine == HASHLIFE)
+			headless_hashlife(&run);
+		else if(type == 'i')
+			headless_sparse(&run);
+		else if((run.engine == BYTE || run.engine == TILED || run.engine == BLOCKED) && !isa_set){
+			for(k = kernels; k->name; k++){
+				if(!k->supported())
+					continue;
+				kernel = k;
+				if(edge_set)
+					headless(type, &run);
+				else{
+					headless('h', &run);
+					headless('t', &run);
+					headless('k', &run);
+				}
+			}
+		}
+		else if(edge_set)
+			headless(type, &run);
+		else{
+			headless('h', &run);
+			headless('t', &run);
+			headless('k', &run);
+		}
+		if(run.restore)
+			snap_close(run.restore);
+		PROF_CLOSE();
+		return 0;
 	}
 
-	while (1)
-	{
-		/* your game of life code goes here  */		
+	struct render_t render; /* this is needed to graphically display the game */
+	struct view_t view;
+	int zoom;
 
-		/* change the  modulus value to slow the rendering */
-		if (SDL_GetTicks() % 1 == 0){
+	if(render_init(&render, width, height, red, green, blue)){
+		printf("SDL Initialization has failed: %s\n", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+	for(zoom = 0; (1 << zoom) < sprite_size; zoom++)
+		;
+	view_init(&view, width, height, zoom);
 
-		sdl_render_life(&sdl_info, a);
+	struct sim_t sim = { .run = &run, .type = type, .view = &view, .last.zoom = ZOOM_MAX + 1, .generation = run.generation };
+	struct frame_t *frame;
+	SDL_DisplayMode mode;
+	Uint32 period = 1000 / 60, next;
+	pthread_t tid;
 
-		switch(type){
-			case 'h':
-				hedge(a, b, m_row, n_col);
-				break;
-			case 't':
-				torus(a, b, m_row, n_col);
-				break;
-			case 'k':
-				klein(a, b, m_row, n_col);
-				break;
+	sim.a = init_matrix(run.m_row,run.n_col);
+	sim.b = init_matrix(run.m_row,run.n_col);
+	sim.frames = init_triple(width, height);
+	if( !(sim.a) || !(sim.b) || !(sim.frames) ){
+		printf("Matrix Initialization has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(type == 'i' && run.engine != HASHLIFE){	/* the sparse plane takes the place of the grid engines */
+		run.engine = BYTE;
+		run.threads = 1;
+	}
+	if(run.threads > 1 && run.engine != TILED && run.engine != BLOCKED && !(sim.pool = pool_create(run.threads, sim.a->stride, BIT_WORDS(run.n_col)))){
+		printf("Thread pool creation has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run.engine == TILED && !(sim.tiles = init_tiles(run.m_row, run.n_col))){
+		printf("Tile Initialization has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(run.engine == BLOCKED && !(sim.blocks = init_block(run.m_row, run.n_col, run.depth))){
+		printf("Tile Initialization has failed.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if(run.engine == HASHLIFE)
+		sim.hl = load_hashlife(&run);
+	else if(type == 'i')
+		sim.plane = load_sparse(&run);
+	else
+		load_patterns(sim.a, type, &run);
+
+	if(run.engine == PACKED){
+		sim.p = init_bitgrid(run.m_row, run.n_col);
+		sim.q = init_bitgrid(run.m_row, run.n_col);
+		if( !(sim.p) || !(sim.q) ){
+			printf("Matrix Initialization has failed.\n");
+			exit(EXIT_FAILURE);
+		}
+		bit_from_grid(sim.p, sim.a);
+	}
+	if( !(sim.hl) && !(sim.plane) ){
+		sim.dirty = calloc(run.m_row, 1);
+		sim.census = init_census(run.m_row, run.n_col);
+		if( !(sim.dirty) || !(sim.census) ){
+			printf("Matrix Initialization has failed.\n");
+			exit(EXIT_FAILURE);
+		}
+		sim.a->dirty = sim.b->dirty = sim.dirty;
+		sim.a->census = sim.b->census = sim.census;
+		census_grid(sim.census, sim.a);
+		if(sim.p){
+			sim.p->dirty = sim.q->dirty = sim.dirty;
+			sim.p->census = sim.q->census = sim.census;
+		}
+	}
+	if(run.rewind){
+		if( !(sim.hist = init_history(run.m_row, run.n_col, run.history, run.keyframe)) ){
+			printf("History Initialization has failed.\n");
+			exit(EXIT_FAILURE);
 		}
+		if(sim.p)
+			history_push_bits(sim.hist, sim.p, sim.generation);
+		else
+			history_push(sim.hist, sim.a, sim.generation);
+	}
 
-		mid(a, b, m_row, n_col);
+	PROF_BEGIN("window %s", type == 'h' ? "hedge" : type == 't' ? "torus" : type == 'k' ? "klein" : "infinite");
+	/* the first generation is ready before the simulation starts */
+	sim_frame(&sim, triple_back(sim.frames));
+	triple_publish(sim.frames);
+	if(pthread_create(&tid, NULL, simulate, &sim)){
+		printf("Simulation thread creation has failed.\n");
+		exit(EXIT_FAILURE);
+	}
 
-		tmp = a;
-		a = b;
-		b = tmp;
+	/* draw at the refresh rate of the display, whatever the speed of the simulation */
+	if(SDL_GetCurrentDisplayMode(0, &mode) == 0 && mode.refresh_rate > 0)
+		period = 1000 / mode.refresh_rate;
+	next = SDL_GetTicks();
+	while (1)
+	{
+		if((frame = triple_take(sim.frames))){
+			PROF_START(t);
+			render_frame(&render, frame);
+			PROF_STOP(PROF_RENDER, t);
+		}
 
 		/* Poll for events, and handle the ones we care about. 
 		* You can click the X button to close the window
 		*/
 		SDL_Event event;
 
+		PROF_START(poll);
 		while (SDL_PollEvent(&event)) 
 		{
 			switch (event.type) 
 			{
 			case SDL_KEYDOWN:
+				if(event.key.keysym.sym == SDLK_SPACE)
+					atomic_store(&sim.paused, !atomic_load(&sim.paused));
+				else if(event.key.keysym.sym == SDLK_BACKSPACE && sim.hist){
+					atomic_store(&sim.paused, 1);
+					atomic_fetch_add(&sim.back, 1);
+				}
+				else
+					view_event(&view, &event);
 				break;
 			case SDL_KEYUP:
                     /* If escape is pressed, return (and thus, quit) */
 				if (event.key.keysym.sym == SDLK_ESCAPE){
-					free_matrix(a, m_row);
-    				free_matrix(b, m_row);
-					fclose(fp);
+					sim_stop(&sim, tid);
+					render_quit(&render);
+					free_matrix(sim.a);
+    				free_matrix(sim.b);
+					if(run.fp)
+						fclose(run.fp);
 					return 0;}
 				break;
 			case SDL_QUIT:
+				sim_stop(&sim, tid);
+				render_quit(&render);
 				return(0);
+			default:
+				view_event(&view, &event);
+				break;
 			}
 		}
-		}
+
+		PROF_STOP(PROF_POLL, poll);
+
+		next += period;
+		if((Sint32)(next - SDL_GetTicks()) > 0)
+			SDL_Delay(next - SDL_GetTicks());
+		else
+			next = SDL_GetTicks();
 	}
 	return 0;
 }
@@ -0,0 +1,515 @@
+/**
+ * @file hashlife.c
+ * @brief HashLife engine for convey's game of life
+ * @details 
+ * The plane is a quadtree of nodes. Equal squares are stored once, found
+ * through a hash table of their four children. Each node remembers its
+ * center after 2^(level-2) generations, so a pattern that repeats itself in
+ * space or time is only ever computed once and huge generation counts are
+ * reached by doubling. The memory cap is kept by collecting every node not
+ * reachable from the universe and dropping the results that pointed at them.
+ * Collections also run in the middle of a step, keeping the nodes each
+ * advance() under way holds on to.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+#include "hashlife.h"
+#include "rule.h"
+
+/** Nodes in each allocation block. */
+#define HL_BLOCK 65536
+
+/** 
+ * @brief Hash of the four children of a node.
+ */
+static size_t hash(struct node_t *nw, struct node_t *ne, struct node_t *sw, struct node_t *se){
+    uint64_t h = (uintptr_t)nw;
+    h = h * 0x9E3779B97F4A7C15ull + (uintptr_t)ne;
+    h = h * 0x9E3779B97F4A7C15ull + (uintptr_t)sw;
+    h = h * 0x9E3779B97F4A7C15ull + (uintptr_t)se;
+    return (size_t)(h ^ (h >> 29));
+}
+
+/** 
+ * @brief Double the hash table and move every node over.
+ * @param hl the universe
+ */
+static void grow(struct hashlife_t *hl){
+    size_t i, buckets = hl->buckets * 2;
+    struct node_t **table = calloc(buckets, sizeof(struct node_t *)), *n, *next;
+
+    if(!table){
+        printf("HashLife table allocation has failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(i = 0; i < hl->buckets; i++)
+        for(n = hl->table[i]; n; n = next){
+            next = n->next;
+            n->next = table[hash(n->nw, n->ne, n->sw, n->se) & (buckets - 1)];
+            table[hash(n->nw, n->ne, n->sw, n->se) & (buckets - 1)] = n;
+        }
+    free(hl->table);
+    hl->table = table;
+    hl->buckets = buckets;
+}
+
+/** 
+ * @brief The canonical node with the given children, made if it does not exist yet.
+ * @param hl the universe
+ */
+static struct node_t *join(struct hashlife_t *hl, struct node_t *nw, struct node_t *ne, struct node_t *sw, struct node_t *se){
+    size_t h = hash(nw, ne, sw, se) & (hl->buckets - 1);
+    struct node_t *n, **block;
+
+    for(n = hl->table[h]; n; n = n->next)
+        if(n->nw == nw && n->ne == ne && n->sw == sw && n->se == se)
+            return n;
+
+    if(!hl->free){
+        block = realloc(hl->blocks, (hl->n_blocks + 1) * sizeof(struct node_t *));
+        if(!block || !(block[hl->n_blocks] = malloc(HL_BLOCK * sizeof(struct node_t)))){
+            printf("HashLife node allocation has failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        hl->blocks = block;
+        for(n = block[hl->n_blocks]; n < block[hl->n_blocks] + HL_BLOCK; n++){
+            n->next = hl->free;
+            hl->free = n;
+        }
+        hl->n_blocks++;
+    }
+    n = hl->free;
+    hl->free = n->next;
+
+    n->nw = nw;
+    n->ne = ne;
+    n->sw = sw;
+    n->se = se;
+    n->result = NULL;
+    n->step = NULL;
+    n->step_j = -1;
+    n->mark = 0;
+    n->level = nw->level + 1;
+    n->pop = nw->pop + ne->pop + sw->pop + se->pop;
+    n->next = hl->table[h];
+    hl->table[h] = n;
+    if(++hl->nodes > hl->buckets)
+        grow(hl);
+    return n;
+}
+
+/** 
+ * @brief The empty node of a level.
+ * @param hl the universe
+ * @param level level of the node
+ */
+static struct node_t *empty(struct hashlife_t *hl, int level){
+    struct node_t *e;
+
+    if(level > 0 && !hl->empty[level]){
+        e = empty(hl, level - 1);
+        hl->empty[level] = join(hl, e, e, e, e);
+    }
+    return hl->empty[level];
+}
+
+/** 
+ * @brief Creates an empty universe. Return adress of the universe is sussesful or NULL if malloc failed.
+ * @param max_bytes memory the nodes may use before garbage is collected, 0 for no cap
+ */
+struct hashlife_t *hl_create(size_t max_bytes){
+    struct hashlife_t *hl = calloc(1, sizeof(struct hashlife_t));
+
+    if(!hl)
+        return NULL;
+    hl->buckets = 1 << 16;
+    hl->table = calloc(hl->buckets, sizeof(struct node_t *));
+    if(!hl->table){
+        free(hl);
+        return NULL;
+    }
+    hl->max_nodes = max_bytes / (sizeof(struct node_t) + sizeof(struct node_t *));
+    hl->limit = hl->max_nodes;
+    hl->leaf[1].pop = 1;
+    hl->empty[0] = &hl->leaf[0];
+    hl->root = empty(hl, 3);
+    return hl;
+}
+
+/** 
+ * @brief Deletes the universe and all of its nodes.
+ * @param hl the universe
+ */
+void hl_destroy(struct hashlife_t *hl){
+    size_t i;
+    for(i = 0; i < hl->n_blocks; i++)
+        free(hl->blocks[i]);
+    free(hl->blocks);
+    free(hl->table);
+    free(hl);
+}
+
+/** 
+ * @brief Mark a node and everything under it as reachable.
+ */
+static void mark(struct node_t *n){
+    if(!n || n->mark || n->level == 0)
+        return;
+    n->mark = 1;
+    mark(n->nw);
+    mark(n->ne);
+    mark(n->sw);
+    mark(n->se);
+}
+
+/** 
+ * @brief Free every node that is not part of the universe and forget results that pointed at them.
+ * @details The live nodes are the root, the empty nodes and those held by the advance() calls under way.
+ * @param hl the universe
+ */
+static void collect(struct hashlife_t *hl){
+    struct node_t *n, **link;
+    size_t i;
+
+    mark(hl->root);
+    for(i = 1; i < 64 && hl->empty[i]; i++)
+        mark(hl->empty[i]);
+    for(i = 0; i < (size_t)hl->n_held; i++)
+        mark(hl->held[i]);
+
+    for(i = 0; i < hl->buckets; i++)
+        for(link = &hl->table[i]; (n = *link); ){
+            if(n->mark){
+                link = &n->next;
+                continue;
+            }
+            *link = n->next;
+            n->next = hl->free;
+            n->level = -1;
+            hl->free = n;
+            hl->nodes--;
+        }
+    for(i = 0; i < hl->buckets; i++)
+        for(n = hl->table[i]; n; n = n->next){
+            if(n->result && n->result->level < 0)
+                n->result = NULL;
+            if(n->step && n->step->level < 0)
+                n->step = NULL;
+        }
+    for(i = 0; i < hl->buckets; i++)
+        for(n = hl->table[i]; n; n = n->next)
+            n->mark = 0;
+    hl->collections++;
+}
+
+/** 
+ * @brief Collect garbage once the nodes are over the limit.
+ * @details The limit is the cap, unless the nodes kept by a collection take more than half of it. It is then twice
+ * what was kept, so a universe near the cap is not collected over and over for little.
+ * @param hl the universe
+ */
+static void keep_cap(struct hashlife_t *hl){
+    if(!hl->max_nodes || hl->nodes <= hl->limit)
+        return;
+    collect(hl);
+    hl->limit = 2 * hl->nodes > hl->max_nodes ? 2 * hl->nodes : hl->max_nodes;
+}
+
+/** 
+ * @brief Node with cell (x, y) set, counting from the top left of the node.
+ * @param hl the universe
+ * @param n node to set the cell in
+ */
+static struct node_t *set(struct hashlife_t *hl, struct node_t *n, int64_t x, int64_t y){
+    int64_t half;
+
+    if(n->level == 0)
+        return &hl->leaf[1];
+    half = (int64_t)1 << (n->level - 1);
+    if(y < half){
+        if(x < half)
+            return join(hl, set(hl, n->nw, x, y), n->ne, n->sw, n->se);
+        return join(hl, n->nw, set(hl, n->ne, x - half, y), n->sw, n->se);
+    }
+    if(x < half)
+        return join(hl, n->nw, n->ne, set(hl, n->sw, x, y - half), n->se);
+    return join(hl, n->nw, n->ne, n->sw, set(hl, n->se, x - half, y - half));
+}
+
+/** 
+ * @brief Node one level up with n in its center.
+ * @param hl the universe
+ * @param n node to center
+ */
+static struct node_t *expand(struct hashlife_t *hl, struct node_t *n){
+    struct node_t *e = empty(hl, n->level - 1);
+    return join(hl, join(hl, e, e, e, n->nw), join(hl, e, e, n->ne, e), join(hl, e, n->sw, e, e), join(hl, n->se, e, e, e));
+}
+
+/** 
+ * @brief Set cell (x, y) of the plane alive, growing the universe until it holds the cell.
+ * @param hl the universe
+ * @param x collum of the cell
+ * @param y row of the cell
+ */
+void hl_set_cell(struct hashlife_t *hl, int64_t x, int64_t y){
+    int64_t half = (int64_t)1 << (hl->root->level - 1);
+
+    while(x < -half || x >= half || y < -half || y >= half){
+        hl->root = expand(hl, hl->root);
+        half = (int64_t)1 << (hl->root->level - 1);
+    }
+    hl->root = set(hl, hl->root, x + half, y + half);
+}
+
+/** 
+ * @brief Set a run of cells read by pattern_read() alive.
+ * @param hl the universe
+ * @param x collum of the first cell
+ * @param y row of the cells
+ * @param n number of cells
+ */
+void hl_cell(void *hl, int x, int y, int n){
+    int i;
+
+    for(i = 0; i < n; i++)
+        hl_set_cell(hl, (int64_t)x + i, y);
+}
+
+/** 
+ * @brief Next generation of the center 2x2 cells of a 4x4 node.
+ * @param hl the universe
+ * @param n level 2 node
+ */
+static struct node_t *base(struct hashlife_t *hl, struct node_t *n){
+    unsigned char c[4][4], s;
+    struct node_t *q[2][2] = { { n->nw, n->ne }, { n->sw, n->se } }, *out[2][2];
+    int r, k, i, j;
+
+    for(r = 0; r < 2; r++)
+        for(k = 0; k < 2; k++){
+            c[2*r][2*k] = q[r][k]->nw->pop;
+            c[2*r][2*k+1] = q[r][k]->ne->pop;
+            c[2*r+1][2*k] = q[r][k]->sw->pop;
+            c[2*r+1][2*k+1] = q[r][k]->se->pop;
+        }
+    for(r = 1; r < 3; r++)
+        for(k = 1; k < 3; k++){
+            s = 0;
+            for(i = -1; i <= 1; i++)
+                for(j = -1; j <= 1; j++)
+                    s += c[r+i][k+j];
+            s -= c[r][k];
+            out[r-1][k-1] = &hl->leaf[rule.next[c[r][k]][s]];
+        }
+    return join(hl, out[0][0], out[0][1], out[1][0], out[1][1]);
+}
+
+/** 
+ * @brief Center of a node, one level down, after 2^j generations.
+ * @details j is at most level - 2. The node is cut into nine overlapping squares one level down, each is
+ * advanced, and the results are put together into four squares that are advanced again for the full step,
+ * or only recentered for a shorter one. The node, the nine squares and the four advanced quarters are held in a
+ * frame of hl->held while it runs, so garbage can be collected before any of them is computed.
+ * @param hl the universe
+ * @param n node of level 2 or more
+ * @param j log2 of the generations
+ */
+static struct node_t *advance(struct hashlife_t *hl, struct node_t *n, int j){
+    struct node_t **c, *r;
+    int full = j >= n->level - 2;
+
+    if(full && n->result)
+        return n->result;
+    if(!full && n->step && n->step_j == j)
+        return n->step;
+
+    if(n->pop == 0)
+        r = empty(hl, n->level - 1);
+    else if(n->level == 2)
+        r = base(hl, n);
+    else{
+        if(full)
+            j = n->level - 2;
+        c = hl->held + hl->n_held;
+        memset(c, 0, HL_FRAME * sizeof(struct node_t *));
+        *c++ = n;
+        hl->n_held += HL_FRAME;
+        keep_cap(hl);
+        c[0] = advance(hl, n->nw, j);
+        c[1] = advance(hl, join(hl, n->nw->ne, n->ne->nw, n->nw->se, n->ne->sw), j);
+        c[2] = advance(hl, n->ne, j);
+        c[3] = advance(hl, join(hl, n->nw->sw, n->nw->se, n->sw->nw, n->sw->ne), j);
+        c[4] = advance(hl, join(hl, n->nw->se, n->ne->sw, n->sw->ne, n->se->nw), j);
+        c[5] = advance(hl, join(hl, n->ne->sw, n->ne->se, n->se->nw, n->se->ne), j);
+        c[6] = advance(hl, n->sw, j);
+        c[7] = advance(hl, join(hl, n->sw->ne, n->se->nw, n->sw->se, n->se->sw), j);
+        c[8] = advance(hl, n->se, j);
+        if(full){
+            c[9] = advance(hl, join(hl, c[0], c[1], c[3], c[4]), j);
+            c[10] = advance(hl, join(hl, c[1], c[2], c[4], c[5]), j);
+            c[11] = advance(hl, join(hl, c[3], c[4], c[6], c[7]), j);
+            c[12] = advance(hl, join(hl, c[4], c[5], c[7], c[8]), j);
+            r = join(hl, c[9], c[10], c[11], c[12]);
+        }
+        else
+            r = join(hl,
+                     join(hl, c[0]->se, c[1]->sw, c[3]->ne, c[4]->nw),
+                     join(hl, c[1]->se, c[2]->sw, c[4]->ne, c[5]->nw),
+                     join(hl, c[3]->se, c[4]->sw, c[6]->ne, c[7]->nw),
+                     join(hl, c[4]->se, c[5]->sw, c[7]->ne, c[8]->nw));
+        hl->n_held -= HL_FRAME;
+    }
+
+    if(full)
+        n->result = r;
+    else{
+        n->step = r;
+        n->step_j = j;
+    }
+    return r;
+}
+
+/** 
+ * @brief True if all live cells of a node are in its center quarter.
+ */
+static int centered(struct node_t *n){
+    return n->nw->pop == n->nw->se->pop && n->ne->pop == n->ne->sw->pop &&
+           n->sw->pop == n->sw->ne->pop && n->se->pop == n->se->nw->pop;
+}
+
+/** 
+ * @brief Advance the universe by 2^j generations.
+ * @details The root is grown until it is big enough for the step and the pattern sits in its center quarter,
+ * so nothing can move past the root's own square in 2^j generations.
+ * @param hl the universe
+ * @param j log2 of the generations
+ */
+static void step_pow2(struct hashlife_t *hl, int j){
+    while(hl->root->level < j + 2 || !centered(hl->root))
+        hl->root = expand(hl, hl->root);
+    hl->root = advance(hl, expand(hl, hl->root), j);
+    hl->generation += (uint64_t)1 << j;
+}
+
+/** 
+ * @brief Jump the universe ahead gens generations.
+ * @details gens is split into powers of two, largest first. Garbage is collected before a step and within it,
+ * each time advance() starts on a node, once the node count is over the limit of keep_cap().
+ * @param hl the universe
+ * @param gens number of generations
+ */
+void hl_jump(struct hashlife_t *hl, uint64_t gens){
+    int j;
+
+    for(j = 63; j >= 0; j--){
+        if(!(gens >> j & 1))
+            continue;
+        keep_cap(hl);
+        step_pow2(hl, j);
+    }
+}
+
+/** 
+ * @brief Number of live cells in the universe.
+ * @param hl the universe
+ */
+uint64_t hl_population(struct hashlife_t *hl){
+    return hl->root->pop;
+}
+
+/** 
+ * @brief Copy the cells of a node that fall inside the matrix.
+ * @param n node to copy
+ * @param g matrix to fill, row is y and collum is x
+ * @param x plane collum of the top left of n, minus the collum of the matrix's first cell
+ * @param y plane row of the top left of n, minus the row of the matrix's first cell
+ */
+static void copy(struct node_t *n, struct grid_t *g, int64_t x, int64_t y){
+    int64_t size = (int64_t)1 << n->level, half = size / 2;
+
+    if(n->pop == 0 || x >= g->n_col || y >= g->m_row || x + size <= 0 || y + size <= 0)
+        return;
+    if(n->level == 0){
+        g->row[y][x] = 1;
+        return;
+    }
+    copy(n->nw, g, x, y);
+    copy(n->ne, g, x + half, y);
+    copy(n->sw, g, x, y + half);
+    copy(n->se, g, x + half, y + half);
+}
+
+/** 
+ * @brief Copy the region of the plane starting at cell (x, y) into a matrix, row is y and collum is x.
+ * @param hl the universe
+ * @param g matrix to fill, cleared first
+ * @param x plane collum of the matrix's first cell
+ * @param y plane row of the matrix's first cell
+ */
+void hl_to_grid(struct hashlife_t *hl, struct grid_t *g, int64_t x, int64_t y){
+    int64_t half = (int64_t)1 << (hl->root->level - 1);
+    int r;
+
+    for(r = 0; r < g->m_row; r++)
+        memset(g->row[r], 0, g->n_col);
+    copy(hl->root, g, -half - x, -half - y);
+}
+
+/** 
+ * @brief Add the density of a node to the samples it falls in.
+ * @details A node no bigger than a sample adds its population scaled to 0 - 255, and at least 1 so a lone
+ * live cell still shows. Bigger nodes are split, so the work follows the samples and not the cells.
+ * @param n node to add
+ * @param g samples, row is y and collum is x
+ * @param rows samples in use down g
+ * @param cols samples in use across g
+ * @param x plane collum of the top left of n, minus the collum of the first sample
+ * @param y plane row of the top left of n, minus the row of the first sample
+ * @param shift a sample is 2^shift cells square
+ */
+static void density(struct node_t *n, struct grid_t *g, int rows, int cols, int64_t x, int64_t y, int shift){
+    int64_t size = (int64_t)1 << n->level, half = size / 2;
+    unsigned char *d;
+    uint64_t v;
+
+    if(n->pop == 0 || x >= (int64_t)cols << shift || y >= (int64_t)rows << shift || x + size <= 0 || y + size <= 0)
+        return;
+    if(n->level <= shift){
+        d = &g->row[y >> shift][x >> shift];
+        v = (n->pop * 255) >> (2 * shift);
+        v = *d + (v ? v : 1);
+        *d = v > 255 ? 255 : v;
+        return;
+    }
+    density(n->nw, g, rows, cols, x, y, shift);
+    density(n->ne, g, rows, cols, x + half, y, shift);
+    density(n->sw, g, rows, cols, x, y + half, shift);
+    density(n->se, g, rows, cols, x + half, y + half, shift);
+}
+
+/** 
+ * @brief Fill samples of 2^shift by 2^shift cells with the density, 0 to 255, of the plane under them.
+ * @param hl the universe
+ * @param g samples, row is y and collum is x
+ * @param rows samples to fill down g
+ * @param cols samples to fill across g
+ * @param x plane collum of the first sample, a multiple of 2^shift
+ * @param y plane row of the first sample, a multiple of 2^shift
+ * @param shift a sample is 2^shift cells square
+ */
+void hl_density(struct hashlife_t *hl, struct grid_t *g, int rows, int cols, int64_t x, int64_t y, int shift){
+    int64_t half = (int64_t)1 << (hl->root->level - 1);
+    int r;
+
+    for(r = 0; r < rows; r++)
+        memset(g->row[r], 0, cols);
+    density(hl->root, g, rows, cols, -half - x, -half - y, shift);
+}
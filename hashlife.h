@@ -0,0 +1,65 @@
+/**
+ * @file hashlife.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the HashLife engine
+ */
+#ifndef HASHLIFE_H_
+#define HASHLIFE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct grid_t;
+
+/** Nodes an advance() being run holds on to: the node, its nine parts and the four quarters of a full step. */
+#define HL_FRAME 14
+
+/** Most advance() calls under way at once, one per level. */
+#define HL_DEPTH 64
+
+/**
+ * Square of 2^level by 2^level cells made of four squares one level down.
+ * Nodes are unique: two nodes with the same children are the same node.
+ * Level 0 nodes are single cells.
+ */
+struct node_t {
+        struct node_t *nw, *ne, *sw, *se;
+        struct node_t *next;	/* hash chain, or free list */
+        struct node_t *result;	/* center after 2^(level-2) generations */
+        struct node_t *step;	/* center after 2^step_j generations */
+        uint64_t pop;		/* live cells */
+        int level;
+        int step_j;
+        int mark;
+};
+
+/** HashLife universe on an unbounded plane, centered on cell (0, 0). */
+struct hashlife_t {
+        struct node_t *root;
+        struct node_t **table;	/* canonical nodes by children */
+        size_t buckets;
+        size_t nodes;		/* nodes in the table */
+        size_t max_nodes;	/* collect garbage above this, 0 for no cap */
+        size_t limit;		/* nodes the next collection waits for, the cap unless more than half of it was kept */
+        struct node_t *free;	/* free list */
+        struct node_t **blocks;	/* node allocations */
+        size_t n_blocks;
+        struct node_t *empty[64];	/* empty node of each level */
+        struct node_t leaf[2];	/* dead and alive cell */
+        uint64_t generation;
+        size_t collections;
+        struct node_t *held[HL_DEPTH * HL_FRAME];	/* nodes of the advance() calls under way, kept by a collection */
+        int n_held;
+};
+
+struct hashlife_t *hl_create(size_t max_bytes);
+void hl_destroy(struct hashlife_t *hl);
+void hl_set_cell(struct hashlife_t *hl, int64_t x, int64_t y);
+void hl_cell(void *hl, int x, int y, int n);
+void hl_jump(struct hashlife_t *hl, uint64_t gens);
+uint64_t hl_population(struct hashlife_t *hl);
+void hl_to_grid(struct hashlife_t *hl, struct grid_t *g, int64_t x, int64_t y);
+void hl_density(struct hashlife_t *hl, struct grid_t *g, int rows, int cols, int64_t x, int64_t y, int shift);
+
+#endif
@@ -0,0 +1,380 @@
+/**
+ * @file history.c
+ * @brief Rewind history of convey's game of life, to step back and see how a board formed
+ * @details
+ * Each generation recorded is stored as the XOR of its packed board with the generation before, so only the words
+ * holding a cell that flipped take any room. Every interval generations a keyframe is stored instead, the board
+ * itself against an empty one. A record is the changed words in order, each as the count of unchanged words
+ * skipped before it (7 bits to a byte, the top bit set on every byte but the last), a byte with bit j set if byte j
+ * of the word is not 0, then those bytes from the lowest.
+ *
+ * The records sit in a ring, oldest first. Once they take more than the budget the oldest keyframe is dropped with
+ * every delta after it up to the next keyframe, so the oldest generation held can always be rebuilt. A seek rebuilds
+ * a generation from the keyframe before it going forward or, as XOR undoes itself, from the newest generation going
+ * back, whichever applies fewer records. Truncating drops the generations after one held, so a board stepped back
+ * to can run on from there and be recorded again.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+#include "bitlife.h"
+#include "history.h"
+
+/**
+ * @brief Creates an empty history of a board. Return adress of the history is sussesful or NULL if malloc failed.
+ * @param m_row number of rows of the board
+ * @param n_col number of collums of the board
+ * @param budget bytes the records may take
+ * @param interval generations from one keyframe to the next, 1 or more
+ */
+struct history_t *init_history(int m_row, int n_col, size_t budget, int interval){
+    struct history_t *h = malloc(sizeof(struct history_t));
+
+    if(!h)
+        return NULL;
+    h->m_row = m_row;
+    h->n_col = n_col;
+    h->budget = budget;
+    h->interval = interval;
+    h->rec = NULL;
+    h->cap = 0;
+    h->used = 0;
+    h->last = init_bitgrid(m_row, n_col);
+    h->now = init_bitgrid(m_row, n_col);
+    h->work = init_bitgrid(m_row, n_col);
+    if(!h->last || !h->now || !h->work){
+        if(h->last)
+            free_bitgrid(h->last);
+        if(h->now)
+            free_bitgrid(h->now);
+        if(h->work)
+            free_bitgrid(h->work);
+        free(h);
+        return NULL;
+    }
+    history_reset(h);
+    return h;
+}
+
+/**
+ * @brief Record k of the ring, 0 being the oldest.
+ * @param h the history
+ * @param k index from the oldest
+ */
+static struct record_t *record(struct history_t *h, int k){
+    return &h->rec[(h->first + k) % h->cap];
+}
+
+/**
+ * @brief Drop the oldest record.
+ * @param h the history
+ */
+static void drop_oldest(struct history_t *h){
+    struct record_t *r = record(h, 0);
+
+    h->bytes -= r->size + sizeof(struct record_t);
+    h->keys -= r->key;
+    free(r->data);
+    h->first = (h->first + 1) % h->cap;
+    h->used--;
+    if(h->used < h->since)
+        h->since = h->used;
+}
+
+/**
+ * @brief Drop the oldest keyframe and the deltas after it, up to the next keyframe.
+ * @param h the history
+ */
+static void drop_group(struct history_t *h){
+    do
+        drop_oldest(h);
+    while(h->used && !record(h, 0)->key);
+}
+
+/**
+ * @brief Drop every record, for a new board. The history keeps its budget and interval.
+ * @param h the history
+ */
+void history_reset(struct history_t *h){
+    while(h->used)
+        drop_oldest(h);
+    h->first = 0;
+    h->bytes = 0;
+    h->keys = 0;
+    h->since = 0;
+}
+
+/**
+ * @brief Free the records, the boards and the struct.
+ * @param h the history
+ */
+void free_history(struct history_t *h){
+    history_reset(h);
+    free(h->rec);
+    free_bitgrid(h->last);
+    free_bitgrid(h->now);
+    free_bitgrid(h->work);
+    free(h);
+}
+
+/**
+ * @brief Encode the words of cur that differ from prev, or all of them that are not 0 if prev is NULL.
+ * @param prev board before, or NULL for a keyframe
+ * @param cur board to record
+ * @param n words of each board
+ * @param out record written to, or NULL to only count its bytes
+ * @return bytes of the record
+ */
+static size_t encode(const uint64_t *prev, const uint64_t *cur, size_t n, unsigned char *out){
+    size_t i, gap = 0, size = 0;
+    unsigned mask;
+    uint64_t x;
+    int j;
+
+    for(i = 0; i < n; i++){
+        x = prev ? cur[i] ^ prev[i] : cur[i];
+        if(!x){
+            gap++;
+            continue;
+        }
+        for(; gap >= 128; gap >>= 7, size++)
+            if(out)
+                out[size] = (gap & 127) | 128;
+        if(out)
+            out[size] = gap;
+        size++;
+        gap = 0;
+
+        mask = 0;
+        for(j = 0; j < 8; j++)
+            if(x >> 8 * j & 255)
+                mask |= 1u << j;
+        if(out){
+            out[size] = mask;
+            for(j = 0; j < 8; j++)
+                if(mask >> j & 1)
+                    out[++size] = x >> 8 * j;
+            size++;
+        }
+        else
+            size += 1 + __builtin_popcount(mask);
+    }
+    return size;
+}
+
+/**
+ * @brief XOR a record into a board.
+ * @param r the record
+ * @param board packed board
+ */
+static void apply(const struct record_t *r, uint64_t *board){
+    const unsigned char *in = r->data;
+    size_t at = 0, i = 0, gap;
+    unsigned mask;
+    uint64_t x;
+    int shift, j;
+
+    while(at < r->size){
+        gap = 0;
+        for(shift = 0; in[at] & 128; shift += 7)
+            gap |= (size_t)(in[at++] & 127) << shift;
+        gap |= (size_t)in[at++] << shift;
+        i += gap;
+
+        mask = in[at++];
+        x = 0;
+        for(j = 0; j < 8; j++)
+            if(mask >> j & 1)
+                x |= (uint64_t)in[at++] << 8 * j;
+        board[i++] ^= x;
+    }
+}
+
+/**
+ * @brief Record the next generation from its packed words.
+ * @details A generation that does not follow the newest held starts the history over. Older groups are dropped to
+ * make room for a delta. If the newest group alone is too large for the budget the generation becomes a keyframe,
+ * which lets it go too.
+ * @param h the history
+ * @param cur packed words of the board, laid out as in struct bitgrid_t
+ * @param generation generation of the board
+ * @return 0 if the generation was recorded, -1 if it does not fit in the budget or malloc failed
+ */
+static int push(struct history_t *h, const uint64_t *cur, long generation){
+    size_t n = (size_t)h->m_row * h->last->words, size, cost = sizeof(struct record_t);
+    struct record_t *r, *ring;
+    int key, k;
+
+    if(h->used && generation != history_newest(h) + 1)
+        history_reset(h);
+    key = !h->used || h->since >= h->interval;
+    size = encode(key ? NULL : h->last->word, cur, n, NULL);
+    if(!key){
+        while(h->bytes + size + cost > h->budget && h->keys > 1)
+            drop_group(h);
+        if(h->bytes + size + cost > h->budget){
+            key = 1;
+            size = encode(NULL, cur, n, NULL);
+        }
+    }
+    while(key && h->used && h->bytes + size + cost > h->budget)
+        drop_group(h);
+    if(size + cost > h->budget){
+        history_reset(h);
+        return -1;
+    }
+
+    if(h->used == h->cap){
+        ring = malloc((h->cap ? 2 * h->cap : 64) * sizeof(struct record_t));
+        if(!ring)
+            return -1;
+        for(k = 0; k < h->used; k++)
+            ring[k] = *record(h, k);
+        free(h->rec);
+        h->rec = ring;
+        h->first = 0;
+        h->cap = h->cap ? 2 * h->cap : 64;
+    }
+    r = &h->rec[(h->first + h->used) % h->cap];
+    r->data = NULL;
+    if(size && !(r->data = malloc(size)))
+        return -1;
+    encode(key ? NULL : h->last->word, cur, n, r->data);
+    r->generation = generation;
+    r->size = size;
+    r->key = key;
+
+    h->used++;
+    h->bytes += size + cost;
+    h->keys += key;
+    h->since = key ? 1 : h->since + 1;
+    memcpy(h->last->word, cur, n * sizeof(uint64_t));
+    return 0;
+}
+
+/**
+ * @brief Record the next generation of a byte matrix.
+ * @param h the history
+ * @param g the matrix
+ * @param generation generation of the board
+ * @return 0 if the generation was recorded, -1 if it does not fit in the budget or malloc failed
+ */
+int history_push(struct history_t *h, struct grid_t *g, long generation){
+    bit_from_grid(h->now, g);
+    return push(h, h->now->word, generation);
+}
+
+/**
+ * @brief Record the next generation of a packed matrix.
+ * @param h the history
+ * @param b the matrix
+ * @param generation generation of the board
+ * @return 0 if the generation was recorded, -1 if it does not fit in the budget or malloc failed
+ */
+int history_push_bits(struct history_t *h, struct bitgrid_t *b, long generation){
+    return push(h, b->word, generation);
+}
+
+/**
+ * @brief Rebuild a generation held in the history into h->work.
+ * @param h the history
+ * @param generation generation to rebuild
+ * @return 0 if the generation was rebuilt, -1 if it is not held
+ */
+static int rebuild(struct history_t *h, long generation){
+    size_t n = (size_t)h->m_row * h->work->words;
+    int i, k;
+
+    if(!h->used || generation < history_oldest(h) || generation > history_newest(h))
+        return -1;
+    i = generation - history_oldest(h);
+    for(k = i; !record(h, k)->key; k--)
+        ;
+    if(k == h->used - h->since && h->used - 1 - i < i - k){
+        memcpy(h->work->word, h->last->word, n * sizeof(uint64_t));
+        for(k = h->used - 1; k > i; k--)
+            apply(record(h, k), h->work->word);
+    }
+    else{
+        memset(h->work->word, 0, n * sizeof(uint64_t));
+        for(; k <= i; k++)
+            apply(record(h, k), h->work->word);
+    }
+    return 0;
+}
+
+/**
+ * @brief Rebuild a generation held in the history into a byte matrix.
+ * @details Only the cells of g are written, its dirty rows and row hashes are left as they were.
+ * @param h the history
+ * @param generation generation to rebuild
+ * @param g matrix of the board size to write it into
+ * @return 0 if the generation was rebuilt, -1 if it is not held
+ */
+int history_seek(struct history_t *h, long generation, struct grid_t *g){
+    if(rebuild(h, generation))
+        return -1;
+    bit_to_grid(g, h->work);
+    return 0;
+}
+
+/**
+ * @brief Rebuild a generation held in the history into a packed matrix.
+ * @details Only the words of b are written, its dirty rows, row hashes and census are left as they were.
+ * @param h the history
+ * @param generation generation to rebuild
+ * @param b matrix of the board size to write it into
+ * @return 0 if the generation was rebuilt, -1 if it is not held
+ */
+int history_seek_bits(struct history_t *h, long generation, struct bitgrid_t *b){
+    if(rebuild(h, generation))
+        return -1;
+    memcpy(b->word, h->work->word, (size_t)h->m_row * h->work->words * sizeof(uint64_t));
+    return 0;
+}
+
+/**
+ * @brief Drop the generations after one held, so the board can step on from it and be recorded again.
+ * @param h the history
+ * @param generation generation to make the newest
+ * @return 0 if it is the newest now, -1 if it is not held
+ */
+int history_truncate(struct history_t *h, long generation){
+    struct record_t *r;
+
+    if(rebuild(h, generation))
+        return -1;
+    while(history_newest(h) > generation){
+        r = record(h, h->used - 1);
+        h->bytes -= r->size + sizeof(struct record_t);
+        h->keys -= r->key;
+        free(r->data);
+        h->used--;
+    }
+    for(h->since = 1; !record(h, h->used - h->since)->key; h->since++)
+        ;
+    memcpy(h->last->word, h->work->word, (size_t)h->m_row * h->work->words * sizeof(uint64_t));
+    return 0;
+}
+
+/**
+ * @brief Oldest generation held, -1 if there is none.
+ * @param h the history
+ */
+long history_oldest(struct history_t *h){
+    return h->used ? record(h, 0)->generation : -1;
+}
+
+/**
+ * @brief Newest generation held, -1 if there is none.
+ * @param h the history
+ */
+long history_newest(struct history_t *h){
+    return h->used ? record(h, h->used - 1)->generation : -1;
+}
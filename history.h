@@ -0,0 +1,59 @@
+/**
+ * @file history.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the rewind history, a journal of the changes from one generation to the next
+ */
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct grid_t;
+struct bitgrid_t;
+
+/** Generations from one keyframe to the next unless told otherwise. */
+#define HISTORY_KEY 64
+
+/** One generation in the journal. */
+struct record_t {
+        long generation;
+        unsigned char *data;		/* changed words of the packed board, NULL if none changed */
+        size_t size;			/* bytes of data */
+        int key;			/* set if data is the whole board, otherwise the XOR with the generation before */
+};
+
+/**
+ * Journal of the latest generations of a board, oldest dropped first once it holds more than budget bytes.
+ * The generations held follow on from one another and the oldest is always a keyframe.
+ */
+struct history_t {
+        int m_row;
+        int n_col;
+        size_t budget;			/* bytes the records may take, their data and bookkeeping */
+        int interval;			/* generations from one keyframe to the next */
+        struct record_t *rec;		/* ring of records, oldest at first */
+        int first;
+        int used;
+        int cap;
+        size_t bytes;			/* bytes the records take */
+        int keys;			/* keyframes held */
+        int since;			/* records from the newest keyframe on, itself included */
+        struct bitgrid_t *last;		/* newest generation held */
+        struct bitgrid_t *now;		/* generation being recorded, packed from a byte matrix */
+        struct bitgrid_t *work;		/* generation being rebuilt by a seek */
+};
+
+struct history_t *init_history(int m_row, int n_col, size_t budget, int interval);
+void free_history(struct history_t *h);
+void history_reset(struct history_t *h);
+int history_push(struct history_t *h, struct grid_t *g, long generation);
+int history_push_bits(struct history_t *h, struct bitgrid_t *b, long generation);
+int history_seek(struct history_t *h, long generation, struct grid_t *g);
+int history_seek_bits(struct history_t *h, long generation, struct bitgrid_t *b);
+int history_truncate(struct history_t *h, long generation);
+long history_oldest(struct history_t *h);
+long history_newest(struct history_t *h);
+
+#endif
@@ -0,0 +1,409 @@
+/**
+ * @file kernel.c
+ * @brief Row kernels of convey's game of life
+ * @details 
+ * A row kernel updates a run of cells in one row from the rows above and below.
+ * There is one kernel per instruction set (scalar, SSE2, AVX2), plus a table
+ * driven scalar kernel for hosts without SIMD. Each instruction set has a
+ * kernel per rule of RULE_LIST, made at build time from one inline function
+ * with the rule as constants, and a table driven kernel for any other rule. The table is checked once at
+ * startup and the fastest kernel the CPU supports is used, so one binary runs
+ * on every host.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "kernel.h"
+#include "rule.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNEL_X86
+#endif
+
+/** 
+ * @brief Scalar kernel - sums the eight neighbors of each cell and applies the rule one cell at a time.
+ * @details Inlined into a kernel per rule of RULE_LIST, where the rule is a constant and the next state is a shift
+ * of it by the sum.
+ * @param up row above, at the first cell
+ * @param cur row of the cells, at the first cell
+ * @param down row below, at the first cell
+ * @param out row of the next generation, at the first cell
+ * @param n number of cells to update
+ * @param birth sums a dead cell is born with, bit k for a sum of k
+ * @param survive sums a live cell stays alive with
+ */
+static inline __attribute__((always_inline)) void row_scalar_rule(const unsigned char *up, const unsigned char *cur, const unsigned char *down, unsigned char *restrict out, int n, unsigned birth, unsigned survive){
+    int col;
+    unsigned char s;
+    for(col = 0; col < n; col++){
+        s = up[col-1] + up[col] + up[col+1] + cur[col-1] + cur[col+1] + down[col-1] + down[col] + down[col+1];
+        out[col] = ((birth | survive << 9) >> (s + 9 * cur[col])) & 1;
+    }
+}
+
+/** Scalar kernel of a rule of RULE_LIST, kept free of auto vectorization so it is a true scalar baseline. */
+#define SCALAR_KERNEL(id, name, birth, survive) \
+__attribute__((optimize("no-tree-vectorize"))) \
+static void row_scalar_##id(const unsigned char *up, const unsigned char *cur, const unsigned char *down, unsigned char *restrict out, int n){ \
+    row_scalar_rule(up, cur, down, out, n, birth, survive); \
+}
+RULE_LIST(SCALAR_KERNEL)
+
+/** 
+ * @brief Scalar kernel of any rule - the next state is looked up in the table of the rule by alive and sum.
+ * @param up row above, at the first cell
+ * @param cur row of the cells, at the first cell
+ * @param down row below, at the first cell
+ * @param out row of the next generation, at the first cell
+ * @param n number of cells to update
+ */
+__attribute__((optimize("no-tree-vectorize")))
+static void row_scalar_any(const unsigned char *up, const unsigned char *cur, const unsigned char *down, unsigned char *restrict out, int n){
+    const unsigned char (*next)[9] = rule.next;
+    int col;
+    unsigned char s;
+    for(col = 0; col < n; col++){
+        s = up[col-1] + up[col] + up[col+1] + cur[col-1] + cur[col+1] + down[col-1] + down[col] + down[col+1];
+        out[col] = next[cur[col]][s];
+    }
+}
+
+/** 
+ * @brief Always available.
+ */
+static int has_scalar(void){
+    return 1;
+}
+
+/** Next state of 4 cells in a row, bit k for cell k, indexed by the 3x6 cells around them. */
+static unsigned char lut[1 << 18];
+
+/** 
+ * @brief Four cells of a row as bits 0 to 3.
+ * @details On little endian hosts the four bytes are read as one word and a multiply gathers bit 0 of each.
+ * @param p first of the cells
+ */
+static inline unsigned row4(const unsigned char *p){
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint32_t w;
+
+    memcpy(&w, p, 4);
+    return (w * 0x10204080u) >> 28;
+#else
+    return p[0] | p[1] << 1 | p[2] << 2 | p[3] << 3;
+#endif
+}
+
+/** 
+ * @brief Lookup table kernel - updates 4 cells per load from a table of every 3x6 neighborhood, for any rule.
+ * @details Bits 0 to 5 of the index are the row above, 6 to 11 the row of the cells and 12 to 17 the row below.
+ * Moving 4 cells on keeps the last 2 collums of each row and adds 4 new ones.
+ * @param up row above, at the first cell
+ * @param cur row of the cells, at the first cell
+ * @param down row below, at the first cell
+ * @param out row of the next generation, at the first cell
+ * @param n number of cells to update
+ */
+static void row_lut(const unsigned char *up, const unsigned char *cur, const unsigned char *down, unsigned char *restrict out, int n){
+    unsigned idx = up[-1] | up[0] << 1 | (cur[-1] | cur[0] << 1) << 6 | (down[-1] | down[0] << 1) << 12;
+    uint32_t v;
+    int col;
+
+    for(col = 0; col + 4 <= n; col += 4){
+        idx |= row4(up + col + 1) << 2 | row4(cur + col + 1) << 8 | row4(down + col + 1) << 14;
+        v = (lut[idx] * 0x00204081u) & 0x01010101u;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy(out + col, &v, 4);
+#else
+        out[col] = v & 1;
+        out[col+1] = v >> 8 & 1;
+        out[col+2] = v >> 16 & 1;
+        out[col+3] = v >> 24;
+#endif
+        idx = idx >> 4 & 0x30c3;
+    }
+    row_scalar_any(up + col, cur + col, down + col, out + col, n - col);
+}
+
+/** 
+ * @brief The lookup table kernel runs on every CPU.
+ */
+static int has_lut(void){
+    return 1;
+}
+
+/** 
+ * @brief Build the tables of the kernels for the rule, the lut kernel's being the only one. Called by rule_set()
+ * whenever the rule changes and by kernel_select() for the rule a program starts with. Nothing is done if the table
+ * is already that of the rule.
+ */
+void kernel_rule(void){
+    static int built;
+    static unsigned birth, survive;
+    unsigned idx, k, r, c, s, alive;
+
+    if(built && birth == rule.birth && survive == rule.survive)
+        return;
+    for(idx = 0; idx < (1 << 18); idx++){
+        lut[idx] = 0;
+        for(k = 0; k < 4; k++){
+            /* cell k is collum k + 1 of the window */
+            s = 0;
+            for(r = 0; r < 3; r++)
+                for(c = k; c <= k + 2; c++)
+                    s += idx >> (6 * r + c) & 1;
+            alive = idx >> (6 + k + 1) & 1;
+            s -= alive;
+            lut[idx] |= rule.next[alive][s] << k;
+        }
+    }
+    birth = rule.birth;
+    survive = rule.survive;
+    built = 1;
+}
+
+#ifdef KERNEL_X86
+/** 
+ * @brief Next state of 16 cells from their sums under a rule, by comparing the sums to each count of the rule.
+ * @details Counts a cell lives with whether dead or alive need no test of the cell. With the rule a constant
+ * the loop unrolls into the compares of the rule alone, which for B3/S23 are 3 neighbors, or 2 and alive.
+ * @param s sums of the neighbors
+ * @param c the cells, 0 or 1
+ * @param birth sums a dead cell is born with, bit k for a sum of k
+ * @param survive sums a live cell stays alive with
+ */
+__attribute__((target("sse2")))
+static inline __attribute__((always_inline)) __m128i rule_sse2(__m128i s, __m128i c, unsigned birth, unsigned survive){
+    const __m128i one = _mm_set1_epi8(1);
+    unsigned both = birth & survive, born = birth & ~survive, kept = survive & ~birth;
+    __m128i any = _mm_setzero_si128(), b = _mm_setzero_si128(), k = _mm_setzero_si128(), eq, out;
+    int i;
+
+    for(i = 0; i <= 8; i++){
+        if(!((birth | survive) >> i & 1))
+            continue;
+        eq = _mm_cmpeq_epi8(s, _mm_set1_epi8(i));
+        if(both >> i & 1)
+            any = _mm_or_si128(any, eq);
+        else if(born >> i & 1)
+            b = _mm_or_si128(b, eq);
+        else
+            k = _mm_or_si128(k, eq);
+    }
+    out = _mm_and_si128(any, one);
+    if(kept)
+        out = _mm_or_si128(out, _mm_and_si128(k, c));
+    if(born)
+        out = _mm_or_si128(out, _mm_andnot_si128(c, _mm_and_si128(b, one)));
+    return out;
+}
+
+/** 
+ * @brief SSE2 kernel - 16 cells per instruction. The neighbors are added as bytes and compared to the counts of the rule.
+ * @param up row above, at the first cell
+ * @param cur row of the cells, at the first cell
+ * @param down row below, at the first cell
+ * @param out row of the next generation, at the first cell
+ * @param n number of cells to update
+ * @param birth sums a dead cell is born with, bit k for a sum of k
+ * @param survive sums a live cell stays alive with
+ */
+__attribute__((target("sse2")))
+static inline __attribute__((always_inline)) void row_sse2_rule(const unsigned char *up, const unsigned char *cur, const unsigned char *down, unsigned char *restrict out, int n, unsigned birth, unsigned survive){
+    __m128i s, c;
+    int col;
+
+    for(col = 0; col + 16 <= n; col += 16){
+        s = _mm_add_epi8(_mm_loadu_si128((const __m128i *)(up + col - 1)), _mm_loadu_si128((const __m128i *)(up + col)));
+        s = _mm_add_epi8(s, _mm_loadu_si128((const __m128i *)(up + col + 1)));
+        s = _mm_add_epi8(s, _mm_loadu_si128((const __m128i *)(cur + col - 1)));
+        s = _mm_add_epi8(s, _mm_loadu_si128((const __m128i *)(cur + col + 1)));
+        s = _mm_add_epi8(s, _mm_loadu_si128((const __m128i *)(down + col - 1)));
+        s = _mm_add_epi8(s, _mm_loadu_si128((const __m128i *)(down + col)));
+        s = _mm_add_epi8(s, _mm_loadu_si128((const __m128i *)(down + col + 1)));
+        c = _mm_loadu_si128((const __m128i *)(cur + col));
+        _mm_storeu_si128((__m128i *)(out + col), rule_sse2(s, c, birth, survive));
+    }
+    row_scalar_rule(up + col, cur + col, down + col, out + col, n - col, birth, survive);
+}
+
+/** SSE2 kernel of a rule of RULE_LIST. */
+#define SSE2_KERNEL(id, name, birth, survive) \
+__attribute__((target("sse2"))) \
+static void row_sse2_##id(const unsigned char *up, const unsigned char *cur, const unsigned char *down, unsigned char *restrict out, int n){ \
+    row_sse2_rule(up, cur, down, out, n, birth, survive); \
+}
+RULE_LIST(SSE2_KERNEL)
+
+/** 
+ * @brief SSE2 kernel of any rule - the counts of the rule are read once per row and compared in a loop.
+ * @details SSE2 has no byte shuffle to look the sums up in a table with, so this is the one kernel for other rules
+ * that tests the rule as it goes.
+ * @param up row above, at the first cell
+ * @param cur row of the cells, at the first cell
+ * @param down row below, at the first cell
+ * @param out row of the next generation, at the first cell
+ * @param n number of cells to update
+ */
+__attribute__((target("sse2")))
+static void row_sse2_any(const unsigned char *up, const unsigned char *cur, const unsigned char *down, unsigned char *restrict out, int n){
+    int col = n - n % 16;
+
+    row_sse2_rule(up, cur, down, out, col, rule.birth, rule.survive);
+    row_scalar_any(up + col, cur + col, down + col, out + col, n - col);
+}
+
+/** 
+ * @brief SSE2 is part of every x86-64 CPU, but check anyway for 32 bit builds.
+ */
+static int has_sse2(void){
+    return __builtin_cpu_supports("sse2");
+}
+
+/** 
+ * @brief Next state of 32 cells from their sums under a rule. Same steps as rule_sse2() on 256 bit registers.
+ * @param s sums of the neighbors
+ * @param c the cells, 0 or 1
+ * @param birth sums a dead cell is born with, bit k for a sum of k
+ * @param survive sums a live cell stays alive with
+ */
+__attribute__((target("avx2")))
+static inline __attribute__((always_inline)) __m256i rule_avx2(__m256i s, __m256i c, unsigned birth, unsigned survive){
+    const __m256i one = _mm256_set1_epi8(1);
+    unsigned both = birth & survive, born = birth & ~survive, kept = survive & ~birth;
+    __m256i any = _mm256_setzero_si256(), b = _mm256_setzero_si256(), k = _mm256_setzero_si256(), eq, out;
+    int i;
+
+    for(i = 0; i <= 8; i++){
+        if(!((birth | survive) >> i & 1))
+            continue;
+        eq = _mm256_cmpeq_epi8(s, _mm256_set1_epi8(i));
+        if(both >> i & 1)
+            any = _mm256_or_si256(any, eq);
+        else if(born >> i & 1)
+            b = _mm256_or_si256(b, eq);
+        else
+            k = _mm256_or_si256(k, eq);
+    }
+    out = _mm256_and_si256(any, one);
+    if(kept)
+        out = _mm256_or_si256(out, _mm256_and_si256(k, c));
+    if(born)
+        out = _mm256_or_si256(out, _mm256_andnot_si256(c, _mm256_and_si256(b, one)));
+    return out;
+}
+
+/** 
+ * @brief Sums of the neighbors of 32 cells.
+ * @param up row above, at the first cell
+ * @param cur row of the cells, at the first cell
+ * @param down row below, at the first cell
+ */
+__attribute__((target("avx2")))
+static inline __attribute__((always_inline)) __m256i sum_avx2(const unsigned char *up, const unsigned char *cur, const unsigned char *down){
+    __m256i s;
+
+    s = _mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(up - 1)), _mm256_loadu_si256((const __m256i *)up));
+    s = _mm256_add_epi8(s, _mm256_loadu_si256((const __m256i *)(up + 1)));
+    s = _mm256_add_epi8(s, _mm256_loadu_si256((const __m256i *)(cur - 1)));
+    s = _mm256_add_epi8(s, _mm256_loadu_si256((const __m256i *)(cur + 1)));
+    s = _mm256_add_epi8(s, _mm256_loadu_si256((const __m256i *)(down - 1)));
+    s = _mm256_add_epi8(s, _mm256_loadu_si256((const __m256i *)down));
+    return _mm256_add_epi8(s, _mm256_loadu_si256((const __m256i *)(down + 1)));
+}
+
+/** AVX2 kernel of a rule of RULE_LIST - 32 cells per instruction, clearing the upper halves before the SSE2 tail. */
+#define AVX2_KERNEL(id, name, birth, survive) \
+__attribute__((target("avx2"))) \
+static void row_avx2_##id(const unsigned char *up, const unsigned char *cur, const unsigned char *down, unsigned char *restrict out, int n){ \
+    int col; \
+    for(col = 0; col + 32 <= n; col += 32) \
+        _mm256_storeu_si256((__m256i *)(out + col), rule_avx2(sum_avx2(up + col, cur + col, down + col), _mm256_loadu_si256((const __m256i *)(cur + col)), birth, survive)); \
+    _mm256_zeroupper(); \
+    row_sse2_##id(up + col, cur + col, down + col, out + col, n - col); \
+}
+RULE_LIST(AVX2_KERNEL)
+
+/** 
+ * @brief AVX2 kernel of any rule - 32 cells per instruction, the next state of each looked up by its sum with a byte
+ * shuffle from a table of the rule for dead cells and one for live cells.
+ * @param up row above, at the first cell
+ * @param cur row of the cells, at the first cell
+ * @param down row below, at the first cell
+ * @param out row of the next generation, at the first cell
+ * @param n number of cells to update
+ */
+__attribute__((target("avx2")))
+static void row_avx2_any(const unsigned char *up, const unsigned char *cur, const unsigned char *down, unsigned char *restrict out, int n){
+    unsigned char table[2][16] = { { 0 } };
+    __m256i dead, live, s, c;
+    int col;
+
+    memcpy(table[0], rule.next[0], 9);
+    memcpy(table[1], rule.next[1], 9);
+    dead = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)table[0]));
+    live = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)table[1]));
+    for(col = 0; col + 32 <= n; col += 32){
+        s = sum_avx2(up + col, cur + col, down + col);
+        c = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(cur + col)), _mm256_set1_epi8(1));
+        _mm256_storeu_si256((__m256i *)(out + col), _mm256_blendv_epi8(_mm256_shuffle_epi8(dead, s), _mm256_shuffle_epi8(live, s), c));
+    }
+    /* clear the upper halves before running the SSE2 tail */
+    _mm256_zeroupper();
+    row_sse2_any(up + col, cur + col, down + col, out + col, n - col);
+}
+
+/** 
+ * @brief Check the CPU for AVX2.
+ */
+static int has_avx2(void){
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+/** Kernel of each rule of RULE_LIST for one instruction set, in the order of enum rule_id. */
+#define SCALAR_ROW(id, name, birth, survive) row_scalar_##id,
+#define LUT_ROW(id, name, birth, survive) row_lut,
+#define SSE2_ROW(id, name, birth, survive) row_sse2_##id,
+#define AVX2_ROW(id, name, birth, survive) row_avx2_##id,
+
+const struct kernel_t kernels[] = {
+    { "scalar", has_scalar, { RULE_LIST(SCALAR_ROW) row_scalar_any } },
+    { "lut", has_lut, { RULE_LIST(LUT_ROW) row_lut } },
+#ifdef KERNEL_X86
+    { "sse2", has_sse2, { RULE_LIST(SSE2_ROW) row_sse2_any } },
+    { "avx2", has_avx2, { RULE_LIST(AVX2_ROW) row_avx2_any } },
+#endif
+    { NULL, NULL, { NULL } }
+};
+
+const struct kernel_t *kernel = &kernels[0];
+
+/** 
+ * @brief Pick the kernel used by mid() and the edge functions. The rule may be set before or after.
+ * @param name name of the kernel, or NULL for the fastest one the CPU supports
+ * @return 0 if the kernel was set, -1 if it is unknown or the CPU does not support it
+ */
+int kernel_select(const char *name){
+    const struct kernel_t *k;
+
+    kernel_rule();
+
+    for(k = kernels; k->name; k++){
+        if(!k->supported())
+            continue;
+        if(name == NULL)
+            kernel = k;
+        else if(!strcmp(name, k->name)){
+            kernel = k;
+            return 0;
+        }
+    }
+    return name == NULL ? 0 : -1;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file kernel.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the row kernels of the byte matrix
+ */
+#ifndef KERNEL_H_
+#define KERNEL_H_
+
+#include "rule.h"
+
+/** Update n cells of a row. The cells before the first and after the last are read. */
+typedef void (*row_fn)(const unsigned char *up, const unsigned char *cur, const unsigned char *down, unsigned char *out, int n);
+
+/** The row kernels of an instruction set and the instruction set they need. */
+struct kernel_t {
+        const char *name;
+        int (*supported)(void);
+        row_fn row[RULE_ANY + 1];	/* row[rule.id], the kernel of the rule */
+};
+
+/** Every kernel, slowest first, ending with a NULL name. */
+extern const struct kernel_t kernels[];
+
+/** Kernel used by mid() and the edge functions. */
+extern const struct kernel_t *kernel;
+
+int kernel_select(const char *name);
+void kernel_rule(void);
+
+#endif
@@ -8,7 +8,7 @@
  * Update a cell's life status to next generatoin.
  * Simulate cells on the edge (hedge, torus, klein)
  * Simulate cells in the middle
- * Import patterns to matrix
+ * Import patterns to matrix (Life 1.05, 1.06 and RLE)
  * Clear array from memoary
  * @author Tommy Pham
  * @date Fall 2020
@@ -18,168 +18,431 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "life.h"
+#include "kernel.h"
 
 /** 
  * @brief Deletes the matrix space in memory
  * @param m the matrix to be freed
- * @param row the number of rows to be freed
- * @param i index of rows.
  */
-void free_matrix(unsigned char **m, int m_row){
-    int i;
-    for (i = 0; i < m_row; i++)
-        free(m[i]);
+void free_matrix(struct grid_t *m){
     free(m);
 }
 
 /** 
  * @brief Creates the matrix and initializes all values to 0. Return adress of Matrix is sussesful or NULL if malloc failed.
- * @details Shift x and y coordinites normal range. Flips Y if klevin.
+ * @details The header, the row table and the cells share one GRID_ALIGN aligned allocation. Every row starts on
+ * an aligned boundary with its ghost cell, so cell (r, c) is at cell[r * stride + c] and the ghost border is
+ * at rows -1 and rows, collums -1 and cols.
  * @param rows The number of rows
  * @param cols The number of columns
- * @param return M is success. NULL is calloc fail.
+ * @param return M is success. NULL is malloc fail.
  * @param i index or row
- * @param j index of collum
- * @param m The array of rows in the matrix
+ * @param head bytes used by the header and row table
+ * @param stride bytes from one row to the next
  */
-unsigned char **init_matrix(int rows, int cols)
+struct grid_t *init_matrix(int rows, int cols)
 {
-    unsigned char **m;
-    int i, j;
-    /* allocate rows */
-    m = malloc(rows * sizeof(int *));
+    struct grid_t *m;
+    size_t head, stride, size;
+    unsigned char *block;
+    int i;
+
+    head = (sizeof(struct grid_t) + (rows + 2) * sizeof(unsigned char *) + GRID_ALIGN - 1) / GRID_ALIGN * GRID_ALIGN;
+    stride = (cols + 2 + GRID_ALIGN - 1) / GRID_ALIGN * GRID_ALIGN;
+    size = head + (rows + 2) * stride;
+
+    m = aligned_alloc(GRID_ALIGN, size);
     if(!m)
         return NULL;
-    for(i = 0; i < rows; i++) {
-        /* allocate cols for each row */
-        m[i] = calloc(cols, sizeof(int));
-        if (!m[i]) {
-            for (j = 0; j < i; j++)
-                free(m[j]);
-            free(m);
-            return NULL;
-        }
+    block = (unsigned char *)m + head;
+    memset(block, 0, (rows + 2) * stride);
 
-    }
+    m->m_row = rows;
+    m->n_col = cols;
+    m->stride = stride;
+    m->dirty = NULL;
+    m->hash = NULL;
+    m->stats = NULL;
+    m->census = NULL;
+    m->cell = block + stride + 1;
+    /* row[-1] and row[rows] are the ghost rows */
+    m->row = (unsigned char **)(m + 1) + 1;
+    for(i = -1; i <= rows; i++)
+        m->row[i] = m->cell + (long)i * stride;
     return m;
 }
 
+/** 
+ * @brief Wrap a cell onto the matrix for torus and klein in constant time.
+ * @details Klein flips the row for every pass across the collums, so x wraps over twice the width.
+ * @param p Present Matrix - Current Generation
+ * @param type type of edge - torus, klein
+ * @param x relative x cordinate, set to the collum in the matrix
+ * @param y relative y cordinate, set to the row in the matrix
+ */
+static void wrap(struct grid_t *p, char type, int *x, int *y){
+    long m_row = p->m_row, n_col = p->n_col, w = type == 'k' ? 2 * n_col : n_col;
+    long cx = ((*x % w) + w) % w, cy = ((*y % m_row) + m_row) % m_row;
+
+    if(cx >= n_col){
+        cy = m_row - cy - 1;
+        cx -= n_col;
+    }
+    *x = cx;
+    *y = cy;
+}
+
 /** 
  * @brief Adjust the relitive pattern coordinates to the matrix with a spefic edge type.
  * @param p Present Matrix - Current Generation
- * @param m_row numbers of rows in matrix
- * @param n_col numbers of collums in matrix
  * @param type type of edge - hedge, torus, klein
  * @param x relative x cordinate for pattern
  * @param y relative y cordinate for pattern
+ * @return 0 if the cell was set, -1 if it is past the edge of a hedge matrix
  */
-void cell_in(unsigned char **p, int m_row, int n_col, char type, int x, int y){
+int cell_in(struct grid_t *p, char type, int x, int y){
+    return run_in(p, type, x, y, 1);
+}
 
-    switch(type){
-        case 'h':
-            if( x >= 0 && x < n_col && y >= 0 && y < m_row )
-                p[y][x] = 1;
-            else{
-                printf("Cell out of bound\n");
-                exit(EXIT_FAILURE);
+/** 
+ * @brief Set a run of n live cells along a row, starting at x, y, with a spefic edge type.
+ * @details Each piece of the run that stays inside the matrix is set at once, so wrapping costs the same
+ * however far out the run starts.
+ * @param p Present Matrix - Current Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param x relative x cordinate of the first cell
+ * @param y relative y cordinate of the row
+ * @param n number of cells
+ * @return 0 if the run was set, -1 if it is past the edge of a hedge matrix, none of it being set
+ */
+int run_in(struct grid_t *p, char type, int x, int y, int n){
+    int cx, cy, part;
+
+    if(type == 'h'){
+        if( !(x >= 0 && n <= p->n_col - x && y >= 0 && y < p->m_row) )
+            return -1;
+        memset(p->row[y] + x, 1, n);
+        return 0;
+    }
+    while(n > 0){
+        cx = x;
+        cy = y;
+        wrap(p, type, &cx, &cy);
+        part = p->n_col - cx < n ? p->n_col - cx : n;
+        memset(p->row[cy] + cx, 1, part);
+        x += part;
+        n -= part;
+    }
+    return 0;
+}
+
+/** 
+ * @brief Read a decimal number, skipping blanks before it.
+ * @param s position in the text, moved past the number
+ * @param end end of the text
+ * @param sign set if the number may have a sign
+ * @param v set to the number
+ * @return 1 if a number was read, 0 if there is none, -1 if it has a sign it may not have or does not fit an int
+ */
+static int scan_int(const char **s, const char *end, int sign, int *v){
+    const char *c = *s;
+    int neg = 0;
+    long n = 0;
+
+    while(c < end && (*c == ' ' || *c == '\t'))
+        c++;
+    if(c < end && (*c == '-' || *c == '+')){
+        if(!sign)
+            return -1;
+        neg = *c++ == '-';
+    }
+    if(c >= end || *c < '0' || *c > '9')
+        return 0;
+    while(c < end && *c >= '0' && *c <= '9'){
+        n = n * 10 + *c++ - '0';
+        if(n > INT_MAX)
+            return -1;
+    }
+    *v = neg ? -n : n;
+    *s = c;
+    return 1;
+}
+
+/** 
+ * @brief Check that a coordinate of a pattern, its offset added, still fits an int.
+ * @param v the coordinate
+ */
+static int fits(long v){
+    return v >= INT_MIN && v <= INT_MAX;
+}
+
+/** 
+ * @brief Position after the end of the line at s, for \n, \r\n or \r line endings.
+ * @param s position in the text
+ * @param end end of the text
+ */
+static const char *next_line(const char *s, const char *end){
+    while(s < end && *s != '\n' && *s != '\r')
+        s++;
+    if(s < end && *s == '\r')
+        s++;
+    if(s < end && *s == '\n')
+        s++;
+    return s;
+}
+
+/** 
+ * @brief Life 1.05 - rows of . and *, with #P x y starting each block at an offset from the pattern's position.
+ * @param s text after the header line
+ * @param end end of the text
+ * @param x initial x cordinate for pattern
+ * @param y initial y cordinate for pattern
+ * @param cell called with ctx and each run of live cells
+ * @param ctx passed to cell
+ * @return number of live cells, -1 if a cordinate does not fit an int
+ */
+static long scan_105(const char *s, const char *end, int x, int y, cell_fn cell, void *ctx){
+    const char *c;
+    int b_x = x, b_y = y, p_x, p_y, row = 0, got;
+    long cells = 0;
+
+    for(; s < end; s = next_line(s, end)){
+        if(*s == '#'){
+            c = s + 2;
+            if(s + 1 >= end || s[1] != 'P')
+                continue;
+            if((got = scan_int(&c, end, 1, &p_x)) > 0)
+                got = scan_int(&c, end, 1, &p_y);
+            if(got < 0 || (got && (!fits((long)x + p_x) || !fits((long)y + p_y))))
+                return -1;
+            if(got){
+                b_x = x + p_x;
+                b_y = y + p_y;
+                row = 0;
             }
-            break;
-        case 't':
-            while(y < 0)
-                y += m_row;
-            while(y >= m_row)
-                y -= m_row;
-            while(x < 0)
-                x += n_col;
-            while(y >= n_col)
-                x -= n_col;
-            p[y][x] = 1;
-            break;
-        case 'k':
-            while(y < 0)
-                y += m_row;
-            while(y >= m_row)
-                y -= m_row;
-            n_col*=2;
-            while(x < 0)
-                x += n_col;
-            while(x >= n_col)
-                x -= n_col;
-            if(x >= 3){
-                y = m_row - y - 1;
-                x -= n_col/2;
+            continue;
+        }
+        if(*s != '.' && *s != '*')
+            continue;
+        for(c = s; c < end && (*c == '.' || *c == '*'); ){
+            const char *run = c;
+            if(*c == '.'){
+                c++;
+                continue;
             }
-            p[y][x] = 1;
-            break;
+            while(c < end && *c == '*')
+                c++;
+            if(!fits((long)b_x + (c - s)) || !fits((long)b_y + row))
+                return -1;
+            cell(ctx, b_x + (run - s), b_y + row, c - run);
+            cells += c - run;
+        }
+        row++;
     }
+    return cells;
 }
 
 /** 
- * @brief Inport a parttern from a file.
- * @details Compatible with 1.05 (Type 5) and 1.06 (Type 6). Find coordinates of the live cells in pattern and sent it to cell_in().
- * @param p Present Matrix - Current Generation
- * @param type type of edge - hedge, torus, klein
- * @param fp file containing pattern
- * @param r Row of cell to update
+ * @brief Life 1.06 - one x y pair per line. Cells next to each other along a row are passed on as one run.
+ * @param s text after the header line
+ * @param end end of the text
  * @param x initial x cordinate for pattern
  * @param y initial y cordinate for pattern
- * @param m_row numbers of rows in matrix
- * @param n_col numbers of collums in matrix
- * @param m_x x coordinate of the pattern
- * @param m_y t coordinate of the pattern
- * @param chunk buffer for to input each lines of the file
+ * @param cell called with ctx and each run of live cells
+ * @param ctx passed to cell
+ * @return number of live cells, -1 if a cordinate does not fit an int
  */
-void pattern_in(unsigned char **p, unsigned char type, FILE *fp, int x, int y, int m_row, int n_col){
+static long scan_106(const char *s, const char *end, int x, int y, cell_fn cell, void *ctx){
+    const char *c;
+    int m_x, m_y, r_x = 0, r_y = 0, n = 0, got;
+    long cells = 0;
 
-    char chunk[128]; int m_x, m_y;
+    for(; s < end; s = next_line(s, end)){
+        c = s;
+        if(*s == '#')
+            continue;
+        if((got = scan_int(&c, end, 1, &m_x)) > 0)
+            got = scan_int(&c, end, 1, &m_y);
+        if(got < 0 || (got && (!fits((long)x + m_x) || !fits((long)y + m_y))))
+            return -1;
+        if(!got)
+            continue;
+        if(n && m_y == r_y && m_x == r_x + n){
+            n++;
+            continue;
+        }
+        if(n)
+            cell(ctx, x + r_x, y + r_y, n);
+        cells += n;
+        r_x = m_x;
+        r_y = m_y;
+        n = 1;
+    }
+    if(n)
+        cell(ctx, x + r_x, y + r_y, n);
+    return cells + n;
+}
 
-    fgets(chunk, sizeof(chunk), fp);
+/** 
+ * @brief RLE - # lines, an x = , y = header line, then runs of b (dead), o (alive) and $ (end of row) up to !.
+ * @details A number before a tag repeats it. Any letter other than b is taken as alive. A count with a sign, or a
+ * pattern going past width collums or height rows, is an error rather than something to wrap around.
+ * @param s text from the start of the file
+ * @param end end of the text
+ * @param x initial x cordinate for pattern
+ * @param y initial y cordinate for pattern
+ * @param width collums a row may hold, INT_MAX for no edge
+ * @param height rows the pattern may have, INT_MAX for no edge
+ * @param cell called with ctx and each run of live cells
+ * @param ctx passed to cell
+ * @return number of live cells, -1 if a count is signed or the pattern does not fit
+ */
+static long scan_rle(const char *s, const char *end, int x, int y, int width, int height, cell_fn cell, void *ctx){
+    long col = 0, row = 0, cells = 0;
+    int count, got;
 
-    switch(chunk[9]){
-        case '5':
-            while(fgets(chunk, sizeof(chunk), fp) != NULL){
-                if(chunk[1] == 'P'){
-                    if(x == 0 || y == 0)
-                        sscanf(chunk,"#P%d %d",&x, &y);
-                    m_x = 0; m_y = 0;
-                }
-                else if(chunk[0] == '.' || chunk[0] == '*'){
-                    while(chunk[m_x] != '\r'){
-                        if(chunk[m_x] == '*'){
-                            cell_in(p, m_row, n_col, type, m_x+x, m_y+y);
-                        }
-                        m_x++;
-                    }
-                    m_x = 0;
-                    m_y++;
-                }
-            }
-            break;
-        case '6':
-            while(fgets(chunk, sizeof(chunk), fp) != NULL){
-                sscanf(chunk,"%d %d",&m_x, &m_y);
-                cell_in(p, m_row, n_col, type, m_x+x, m_y+y);
-            }
+    while(s < end && (*s == '#' || *s == 'x' || *s == '\r' || *s == '\n'))
+        s = next_line(s, end);
+    while(s < end && *s != '!'){
+        if((got = scan_int(&s, end, 0, &count)) < 0)
+            return -1;
+        if(!got)
+            count = 1;
+        if(s >= end)
             break;
-        default:
-            printf("File version can not found.\n");
+        if(*s == '$'){
+            row += count;
+            col = 0;
+            if(row > height)
+                return -1;
+        }
+        else if(*s == 'b' || *s == '.')
+            col += count;
+        else if((*s >= 'a' && *s <= 'z') || (*s >= 'A' && *s <= 'Z')){
+            if(col + count > width || row >= height || !fits(x + col + count) || !fits(y + row))
+                return -1;
+            cell(ctx, x + col, y + row, count);
+            cells += count;
+            col += count;
+        }
+        s++;
+    }
+    return cells;
+}
 
+/** 
+ * @brief Inport a parttern from a file.
+ * @details Compatible with 1.05 (Type 5), 1.06 (Type 6) and RLE. The file is mapped into memory and scanned in
+ * place, falling back to reading it in when it can not be mapped, such as a pipe. Any line ending is accepted.
+ * Runs of live cells along a row are sent to cell. An RLE pattern may be no wider or taller than the board.
+ * @param fp file containing pattern, read from the current position
+ * @param x initial x cordinate for pattern
+ * @param y initial y cordinate for pattern
+ * @param width collums of the board, 0 for a plane with no edge
+ * @param height rows of the board, 0 for a plane with no edge
+ * @param cell called with ctx and each run of live cells
+ * @param ctx passed to cell
+ * @return number of live cells read, 0 if the file could not be read, -1 if a number in it is out of range, cells
+ * before it having been sent to cell, -2 if its type was not found
+ */
+long pattern_read(FILE *fp, int x, int y, int width, int height, cell_fn cell, void *ctx){
+    struct stat st;
+    char *text = NULL, *mapped = NULL;
+    const char *s, *end;
+    size_t size = 0, cap = 0, got;
+    long cells = 0;
+
+    if(fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > ftell(fp)){
+        size = st.st_size;
+        mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+        if(mapped == MAP_FAILED)
+            mapped = NULL;
+    }
+    if(mapped){
+        s = mapped + ftell(fp);
+        end = mapped + size;
+    }
+    else{
+        size = 0;
+        do{
+            if(size == cap){
+                cap = cap ? 2 * cap : 1 << 16;
+                if(!(s = realloc(text, cap))){
+                    free(text);
+                    return 0;
+                }
+                text = (char *)s;
+            }
+            got = fread(text + size, 1, cap - size, fp);
+            size += got;
+        }while(got);
+        s = text;
+        end = text + size;
     }
 
+    while(s < end && (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n'))
+        s++;
+    if(end - s >= 10 && !strncmp(s, "#Life 1.05", 10))
+        cells = scan_105(next_line(s, end), end, x, y, cell, ctx);
+    else if(end - s >= 10 && !strncmp(s, "#Life 1.06", 10))
+        cells = scan_106(next_line(s, end), end, x, y, cell, ctx);
+    else if(s < end && (*s == '#' || *s == 'x'))
+        cells = scan_rle(s, end, x, y, width ? width : INT_MAX, height ? height : INT_MAX, cell, ctx);
+    else
+        cells = -2;
+
+    if(mapped)
+        munmap(mapped, size);
+    free(text);
+    return cells;
+}
+
+/** 
+ * @brief Pass a run of cells from pattern_read() on to run_in().
+ * @param ctx the struct pattern_ctx_t with the matrix and edge type, counting the runs past the edge of a hedge matrix
+ * @param x relative x cordinate of the first cell
+ * @param y relative y cordinate for pattern
+ * @param n number of cells
+ */
+void pattern_cell(void *ctx, int x, int y, int n){
+    struct pattern_ctx_t *in = ctx;
+    if(run_in(in->p, in->type, x, y, n))
+        in->outside++;
+}
+
+/** 
+ * @brief Inport a parttern from a file into the matrix with a spefic edge type.
+ * @param p Present Matrix - Current Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param fp file containing pattern
+ * @param x initial x cordinate for pattern
+ * @param y initial y cordinate for pattern
+ * @return number of live cells read, as pattern_read(), or -1 if a cell fell past the edge of a hedge matrix
+ */
+long pattern_in(struct grid_t *p, unsigned char type, FILE *fp, int x, int y){
+    struct pattern_ctx_t in = { p, type, 0 };
+    long cells = pattern_read(fp, x, y, p->n_col, p->m_row, pattern_cell, &in);
+
+    return in.outside ? -1 : cells;
 }
 
 /**
  * @brief Prints the contents of the given matrix to the terminal.
  * @param matrix The matrix
- * @param m_row The number of rows
- * @param n_col The number of columns
  */
-void print_matrix(unsigned char **matrix, int m_row, int n_col){
-    for (int i = 0; i < m_row; i++) {
-        for (int j = 0; j < n_col; j++) {
-            if(matrix[i][j] == 0)
+void print_matrix(struct grid_t *matrix){
+    for (int i = 0; i < matrix->m_row; i++) {
+        for (int j = 0; j < matrix->n_col; j++) {
+            if(matrix->row[i][j] == 0)
                 printf("⬜");
             else
                 printf("⬛");
@@ -190,174 +453,654 @@ void print_matrix(unsigned char **matrix, int m_row, int n_col){
 }
 
 /** 
- * @brief Evalute a cell life status and update it on the next generation.
+ * @brief Sixteen cells of a byte row as a number, a bit per cell.
+ * @param row the first of the cells
+ */
+static inline unsigned group_bits(const unsigned char *row){
+#ifdef __SSE2__
+    /* cells are 0 or 1, so shifting the low bit of each byte to the top lets movemask gather them */
+    return _mm_movemask_epi8(_mm_slli_epi16(_mm_loadu_si128((const __m128i *)row), 7));
+#else
+    uint64_t a, b;
+    memcpy(&a, row, 8);
+    memcpy(&b, row + 8, 8);
+    return (a * 0x0102040810204080ULL) >> 56 | ((b * 0x0102040810204080ULL) >> 48 & 0xff00);
+#endif
+}
+
+/** 
+ * @brief Change to the hash of a row from the cells that differ between two rows in collums c to c + n - 1.
+ * @details The rows are read sixteen cells at a time from a multiple of sixteen, each group turned into a bit per
+ * cell, and the difference of the groups times the key of the group is added up, with no branch on how many cells
+ * changed.
+ * @param p present row
+ * @param f future row
+ * @param c first collum
+ * @param n number of collums
+ * @param key keys of the groups of the row hashes
+ */
+uint64_t flip_hash(const unsigned char *p, const unsigned char *f, int c, int n, const uint64_t *key){
+    uint64_t h = 0;
+    int g, g0 = c >> 4, g1 = (c + n - 1) >> 4;
+    unsigned m, first = 0xffffu << (c & 15) & 0xffff, last = 0xffffu >> (15 - ((c + n - 1) & 15));
+
+    for(g = g0; g <= g1; g++){
+        /* leave out the cells outside the collums */
+        m = (g == g0 ? first : 0xffff) & (g == g1 ? last : 0xffff);
+        h += ((uint64_t)(group_bits(f + 16 * g) & m) - (group_bits(p + 16 * g) & m)) * key[g];
+    }
+    return h;
+}
+
+/** 
+ * @brief Empty the counts, for a generation about to be stepped.
+ * @param s the counts
+ */
+void stats_clear(struct stats_t *s){
+    s->population = 0;
+    s->births = 0;
+    s->deaths = 0;
+    s->top = INT_MAX;
+    s->bottom = -1;
+    s->left = INT_MAX;
+    s->right = -1;
+}
+
+/** 
+ * @brief Add the counts of another part of the same generation.
+ * @param s the counts
+ * @param t counts to add in
+ */
+void stats_merge(struct stats_t *s, const struct stats_t *t){
+    s->population += t->population;
+    s->births += t->births;
+    s->deaths += t->deaths;
+    if(t->top < s->top)
+        s->top = t->top;
+    if(t->bottom > s->bottom)
+        s->bottom = t->bottom;
+    if(t->left < s->left)
+        s->left = t->left;
+    if(t->right > s->right)
+        s->right = t->right;
+}
+
+/** 
+ * @brief Sum of the eight bytes of a word, each at most 255.
+ * @param x the word
+ */
+static inline long byte_sum(uint64_t x){
+    x = (x & 0x00ff00ff00ff00ffULL) + (x >> 8 & 0x00ff00ff00ff00ffULL);
+    return (x * 0x0001000100010001ULL) >> 48;
+}
+
+/** 
+ * @brief Add the cells of row r in collums c to c + n - 1 to the counts: the live cells of f and those born or
+ * died since p.
+ * @details Cells are 0 or 1, so eight are added at a time as the bytes of a word, the byte sums taken before any
+ * could pass 255. Only the first and last word holding a live cell are kept on the way, without a branch, and the
+ * first and last live cell found in them after.
+ * @param s the counts
+ * @param p present row
+ * @param f future row
+ * @param r row
+ * @param c first collum
+ * @param n number of collums
+ */
+static void row_stats(struct stats_t *s, const unsigned char *p, const unsigned char *f, int r, int c, int n){
+    uint64_t a, b, live, born, died;
+    int i = c, k, end = c + n, first = -1, last = -1, hi = -1;
+
+    while(i + 8 <= end){
+        live = born = died = 0;
+        for(k = 0; k < 255 && i + 8 <= end; k++, i += 8){
+            memcpy(&a, p + i, 8);
+            memcpy(&b, f + i, 8);
+            live += b;
+            born += b & ~a;
+            died += a & ~b;
+            hi = b ? i : hi;
+        }
+        s->population += byte_sum(live);
+        s->births += byte_sum(born);
+        s->deaths += byte_sum(died);
+    }
+    if(hi >= 0){
+        for(first = c, b = 0; !b; first += 8)
+            memcpy(&b, f + first, 8);
+        first += __builtin_ctzll(b) / 8 - 8;
+        memcpy(&b, f + hi, 8);
+        last = hi + 7 - __builtin_clzll(b) / 8;
+    }
+    for(; i < end; i++){
+        s->population += f[i];
+        s->births += f[i] & ~p[i];
+        s->deaths += p[i] & ~f[i];
+        if(f[i]){
+            if(first < 0)
+                first = i;
+            last = i;
+        }
+    }
+    if(first < 0)
+        return;
+    if(r < s->top)
+        s->top = r;
+    if(r > s->bottom)
+        s->bottom = r;
+    if(first < s->left)
+        s->left = first;
+    if(last > s->right)
+        s->right = last;
+}
+
+/** 
+ * @brief Count a matrix from scratch, for a board just loaded. Every live cell counts as neither born nor died.
+ * @param s the counts
+ * @param g the matrix
+ */
+void stats_grid(struct stats_t *s, struct grid_t *g){
+    int r;
+
+    stats_clear(s);
+    for(r = 0; r < g->m_row; r++)
+        row_stats(s, g->row[r], g->row[r], r, 0, g->n_col);
+}
+
+/** 
+ * @brief Creates the census of a board with every tile empty. Return adress of the struct is sussesful or NULL if
+ * malloc failed.
+ * @param m_row number of rows of the board
+ * @param n_col number of collums of the board
+ */
+struct census_t *init_census(int m_row, int n_col){
+    struct census_t *s = calloc(1, sizeof(struct census_t));
+    int k, side;
+
+    if(!s)
+        return NULL;
+    for(k = 0; k < CENSUS_LEVELS; k++){
+        side = 64 << 3 * k;
+        s->rows[k] = (m_row + side - 1) / side;
+        s->cols[k] = (n_col + side - 1) / side;
+        if(!(s->count[k] = calloc((size_t)s->rows[k] * s->cols[k], sizeof(int)))){
+            free_census(s);
+            return NULL;
+        }
+    }
+    return s;
+}
+
+/** 
+ * @brief Deletes the census space in memory
+ * @param s the census to be freed
+ */
+void free_census(struct census_t *s){
+    int k;
+
+    for(k = 0; k < CENSUS_LEVELS; k++)
+        free(s->count[k]);
+    free(s);
+}
+
+/** 
+ * @brief Add the change of the spans of 64 cells w to w + spans - 1 of row r, or of the rows of its tile, to every
+ * tile they are in.
+ * @details The spans in one tile of a level are added up first, so a level costs an atomic add per tile that
+ * changed rather than one per span.
+ * @param s the census
+ * @param r the row
+ * @param w first span, cells 64w to 64w + 63
+ * @param d change of the live cells of each span
+ * @param spans number of spans
+ */
+void census_add(struct census_t *s, int r, int w, const int *d, int spans){
+    int *tile = s->count[0] + (long)(r >> 6) * s->cols[0], i, k, sum = 0, total = 0;
+
+    for(i = w; i < w + spans; i++){
+        if(d[i - w]){
+            __atomic_fetch_add(&tile[i], d[i - w], __ATOMIC_RELAXED);
+            sum += d[i - w];
+        }
+        if(i + 1 < w + spans && (i + 1) % 8)
+            continue;
+        /* the end of a tile of 512 cells, and maybe of the larger ones */
+        if(sum)
+            __atomic_fetch_add(&s->count[1][(long)(r >> 9) * s->cols[1] + (i >> 3)], sum, __ATOMIC_RELAXED);
+        total += sum;
+        sum = 0;
+        if(i + 1 < w + spans && (i + 1) % 64)
+            continue;
+        for(k = 2; k < CENSUS_LEVELS && total; k++)
+            __atomic_fetch_add(&s->count[k][(long)(r >> (6 + 3 * k)) * s->cols[k] + (i >> 3 * k)], total, __ATOMIC_RELAXED);
+        total = 0;
+    }
+}
+
+/** 
+ * @brief Add the change of row r in collums c to c + n - 1 to the census.
+ * @details Cells are 0 or 1, so the eight words of a span are added up as bytes and their bytes summed once. The
+ * spans are handed over in runs of up to 64, lined up on 64.
+ * @param s the census
+ * @param p present row, or NULL if every cell was dead
+ * @param f future row
+ * @param r the row
+ * @param c first collum
+ * @param n number of collums
+ */
+void census_row(struct census_t *s, const unsigned char *p, const unsigned char *f, int r, int c, int n){
+    int d[64], w, w1 = (c + n - 1) >> 6, k, g, g0 = c >> 3, g1 = (c + n - 1) >> 3;
+    uint64_t a = 0, b, m, was, now, first = ~(uint64_t)0 << 8 * (c & 7), last = ~(uint64_t)0 >> 8 * (7 - ((c + n - 1) & 7));
+
+    for(w = c >> 6; w <= w1; w += k){
+        k = w1 - w + 1 < 64 - w % 64 ? w1 - w + 1 : 64 - w % 64;
+        for(was = now = 0, g = 8 * w > g0 ? 8 * w : g0; g <= g1 && g < 8 * (w + k); g++){
+            /* leave out the cells outside the collums */
+            m = (g == g0 ? first : ~(uint64_t)0) & (g == g1 ? last : ~(uint64_t)0);
+            if(p)
+                memcpy(&a, p + 8 * g, 8);
+            memcpy(&b, f + 8 * g, 8);
+            was += a & m;
+            now += b & m;
+            if(g % 8 == 7 || g == g1){
+                /* each byte holds at most 8, so the bytes add up by a multiply */
+                d[(g >> 3) - w] = (int)((now * 0x0101010101010101ULL) >> 56) - (int)((was * 0x0101010101010101ULL) >> 56);
+                was = now = 0;
+            }
+        }
+        census_add(s, r, w, d, k);
+    }
+}
+
+/** 
+ * @brief Count the live cells of every tile of a byte matrix.
+ * @param s the census
+ * @param g the matrix
+ */
+void census_grid(struct census_t *s, struct grid_t *g){
+    int k, r;
+
+    for(k = 0; k < CENSUS_LEVELS; k++)
+        memset(s->count[k], 0, (size_t)s->rows[k] * s->cols[k] * sizeof(int));
+    for(r = 0; r < g->m_row; r++)
+        census_row(s, NULL, g->row[r], r, 0, g->n_col);
+}
+
+/** 
+ * @brief Run the kernel over n cells of row r from collum c, mark the row dirty in f and add it to the census if any
+ * of them changed, hash the cells that flipped and add them to the counts.
  * @param p Present Matrix - Current Generation
  * @param f Future Matrix - Next Generation
- * @param r Row of cell to update
- * @param c Collum of cell to update
- * @param n Number of neighbors
- */
-void update(unsigned char **p, unsigned char **f, int r, int c, char n){
-
-    if(p[r][c] == 1){
-        if( n == 2 || n == 3 ){
-            //printf("1");
-            f[r][c] = 1;}
-        else{
-            //printf("2");
-            f[r][c] = 0;}
-        }
-    else{
-        if( n == 3 )
-            f[r][c] = 1;
-        else
-            f[r][c] = 0;
+ * @param up row above, at collum c
+ * @param down row below, at collum c
+ * @param r row to update
+ * @param c first collum to update
+ * @param n number of cells to update
+ * @param stats counts of the generation in f, or NULL
+ */
+static inline void run_row(struct grid_t *p, struct grid_t *f, const unsigned char *up, const unsigned char *down, int r, int c, int n, struct stats_t *stats){
+    kernel->row[rule.id](up, p->row[r] + c, down, f->row[r] + c, n);
+    if((f->dirty || f->census) && memcmp(p->row[r] + c, f->row[r] + c, n)){
+        if(f->dirty)
+            f->dirty[r] = 1;
+        if(f->census)
+            census_row(f->census, p->row[r], f->row[r], r, c, n);
     }
+    if(f->hash)
+        rowhash_add(f->hash, f, r, flip_hash(p->row[r], f->row[r], c, n, f->hash->key));
+    if(stats)
+        row_stats(stats, p->row[r], f->row[r], r, c, n);
 }
 
 /** 
  * @brief Check and update life status of cell in the middle and note edge of a given matrix.
- * @details First for loop check for left and right collum. Secound for loop check for top and bottom row.
+ * @details Each row is a stride apart in one block so the kernel runs straight over three rows.
  * @param p Present Matrix - Current Generation
  * @param f Future Matrix - Next Generation
- * @param r Max row of matrix
- * @param c Max collum of matrix
  */
-void mid(unsigned char **p, unsigned char **f, int r, int c){
-    r--; c--;
-    int row, col, n;
-    for(row = 1; row < r; row++){
-        for(col = 1; col < c; col++){
-            n = ( p[(row-1)][(col-1)] + p[(row-1)][col] + p[(row-1)][(col+1)] + p[row][(col+1)] + p[(row+1)][(col+1)] + p[(row+1)][(col)] + p[(row+1)][(col-1)] + p[row][(col-1)]);
-            update(p, f, row, col, n);
-        }
-    }
+void mid(struct grid_t *p, struct grid_t *f){
+    int row, r = p->m_row - 1, c = p->n_col - 1;
+    for(row = 1; row < r; row++)
+        run_row(p, f, p->row[row-1] + 1, p->row[row+1] + 1, row, 1, c - 1, f->stats);
 }
 
 /** 
- * @brief Hedge Edge - Check and update life status of cell on the all edge with hedge properties.
+ * @brief Update the cells on the edge of the matrix once the ghost border is filled.
+ * @details Top and bottom row are updated whole, then the first and last collum of the rows in between. The edge
+ * is stepped before mid(), so the counts of f start over here.
  * @param p Present Matrix - Current Generation
  * @param f Future Matrix - Next Generation
  * @param r Max row of matrix
  * @param c Max collum of matrix
  * @param i_r Index of row
- * @param i_c Index of collums
- * @param n number of cell's neighbors
  */
-void hedge(unsigned char **p, unsigned char **f, int r, int c){
-    
-    r--;c--;
-    int i_r, i_c, n;
+void edge(struct grid_t *p, struct grid_t *f){
+    int i_r, r = p->m_row - 1, c = p->n_col - 1;
 
+    if(f->stats)
+        stats_clear(f->stats);
+    run_row(p, f, p->row[-1], p->row[1], 0, 0, c + 1, f->stats);
+    run_row(p, f, p->row[r-1], p->row[r+1], r, 0, c + 1, f->stats);
     for(i_r = 1; i_r < r; i_r++){
-        n = (p[(i_r-1)][0] + p[(i_r-1)][1] + p[i_r][1] + p[(i_r+1)][1] + p[(i_r+1)][0]);
-        update(p, f, i_r, 0, n);
-        n = (p[(i_r-1)][c] + p[(i_r-1)][c-1] + p[i_r][c-1] + p[(i_r+1)][c-1] + p[(i_r+1)][c]);
-        update(p, f, i_r, c, n);
-    }    
+        run_row(p, f, p->row[i_r-1], p->row[i_r+1], i_r, 0, 1, f->stats);
+        run_row(p, f, p->row[i_r-1] + c, p->row[i_r+1] + c, i_r, c, 1, f->stats);
+    }
+}
 
-    for(i_c = 1; i_c < c; i_c++){
-        n = ( p[0][(i_c+1)] + p[1][(i_c+1)] + p[1][i_c] + p[1][(i_c-1)] + p[0][(i_c-1)] );
-        update(p, f, 0, i_c, n);
-        n = ( p[r][(i_c-1)] + p[(r-1)][(i_c-1)] + p[(r-1)][i_c] + p[(r-1)][(i_c+1)] + p[r][(i_c+1)] );
-        update(p, f, r, i_c, n);
-    } 
+/** 
+ * @brief Hedge Edge - Check and update life status of cell on the all edge with hedge properties.
+ * @details Cells past the edge are dead, so the ghost border is cleared.
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param i_r Index of row
+ */
+void hedge(struct grid_t *p, struct grid_t *f){
+    int i_r, r = p->m_row - 1, c = p->n_col - 1;
+
+    for(i_r = 0; i_r <= r; i_r++){
+        p->row[i_r][-1] = 0;
+        p->row[i_r][c+1] = 0;
+    }
+    memset(p->row[-1] - 1, 0, c + 3);
+    memset(p->row[r+1] - 1, 0, c + 3);
 
-    n = ( p[0][1] + p[1][1] + p[1][0] );
-    update(p, f, 0, 0, n);
+    edge(p, f);
+}
 
-    n = ( p[1][c] + p[1][(c-1)] + p[0][(c-1)] );
-    update(p, f, 0, c, n);
+/** 
+ * @brief Hedge Edge stepped only around the live cells, edges and middle at once. Both matrices need counts.
+ * @details A cell more than one cell away from every live cell of p has no live neighbour and stays dead, as long
+ * as the rule has no B0. Past that margin f may still hold live cells of the generation before p, but only inside
+ * the box of its own counts. The rows and collums covering both boxes are stepped and the rest of f is left dead.
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ */
+void hedge_box(struct grid_t *p, struct grid_t *f){
+    struct stats_t *now = p->stats, *old = f->stats;
+    int r, m = p->m_row, n = p->n_col, r0 = m, r1 = 0, c0 = n, c1 = 0;
 
-    n = ( p[r][(c-1)] + p[(r-1)][(c-1)] + p[(r-1)][c] );
-    update(p, f, r, c, n);
+    if(now->bottom >= now->top){
+        r0 = now->top - 1;
+        r1 = now->bottom + 2;
+        c0 = now->left - 1;
+        c1 = now->right + 2;
+    }
+    if(old->bottom >= old->top){
+        r0 = old->top < r0 ? old->top : r0;
+        r1 = old->bottom + 1 > r1 ? old->bottom + 1 : r1;
+        c0 = old->left < c0 ? old->left : c0;
+        c1 = old->right + 1 > c1 ? old->right + 1 : c1;
+    }
+    r0 = r0 < 0 ? 0 : r0;
+    r1 = r1 > m ? m : r1;
+    c0 = c0 < 0 ? 0 : c0;
+    c1 = c1 > n ? n : c1;
 
-    n = ( p[r-1][0] + p[(r-1)][1] + p[r][1] );
-    update(p, f, r, 0, n);
+    stats_clear(old);
+    if(r0 >= r1 || c0 >= c1)
+        return;
+    for(r = r0 > 0 ? r0 - 1 : 0; r <= r1 && r < m; r++){
+        p->row[r][-1] = 0;
+        p->row[r][n] = 0;
+    }
+    if(r0 == 0)
+        memset(p->row[-1] + c0 - 1, 0, c1 - c0 + 2);
+    if(r1 == m)
+        memset(p->row[m] + c0 - 1, 0, c1 - c0 + 2);
+    for(r = r0; r < r1; r++)
+        run_row(p, f, p->row[r-1] + c0, p->row[r+1] + c0, r, c0, c1 - c0, old);
 }
 
 /** 
  * @brief Torus - Check and update life status of cell on the all sides with torus property.
- * @details First for loop check for left and right collum. Secound for loop check for top and bottom row.
+ * @details The ghost collums are copied from the opposite collum of the same row, then the ghost rows from the
+ * opposite row including its ghost cells.
  * @param p Present Matrix - Current Generation
  * @param f Future Matrix - Next Generation
- * @param r Max row of matrix
- * @param c Max collum of matrix
  * @param i_r Index of row
- * @param i_c Index of collums
- * @param n number of cell's neighbors
  */
-void torus(unsigned char **p, unsigned char **f, int r, int c){
-    
-    r--; c--;
-    int i_r, i_c, n;
+void torus(struct grid_t *p, struct grid_t *f){
+    int i_r, r = p->m_row - 1, c = p->n_col - 1;
 
-    for(i_r = 1; i_r < r; i_r++){
-        n = ( p[(i_r-1)][0] + p[(i_r-1)][1] + p[i_r][1] + p[(i_r+1)][1] + p[(i_r+1)][0] + p[(i_r+1)][c] + p[i_r][c] + p[(i_r-1)][c] );
-        update(p, f, i_r, 0, n);
-        n = ( p[(i_r-1)][c] + p[(i_r-1)][c-1] + p[i_r][c-1] + p[(i_r+1)][c-1] + p[(i_r+1)][c] + p[(i_r+1)][0] + p[i_r][0] + p[(i_r-1)][0] );
-        update(p, f, i_r, c, n);       
-        }    
+    for(i_r = 0; i_r <= r; i_r++){
+        p->row[i_r][-1] = p->row[i_r][c];
+        p->row[i_r][c+1] = p->row[i_r][0];
+    }
+    memcpy(p->row[-1] - 1, p->row[r] - 1, c + 3);
+    memcpy(p->row[r+1] - 1, p->row[0] - 1, c + 3);
 
-    for(i_c = 1; i_c < c; i_c++){
-        n =( p[r][(i_c-1)] + p[r][i_c] + p[r][(i_c+1)] + p[0][(i_c+1)] + p[1][(i_c+1)] + p[1][i_c] + p[1][(i_c-1)] + p[0][(i_c-1)] );
-        update(p, f, 0, i_c, n);
-        n = ( p[r][(i_c-1)] + p[(r-1)][(i_c-1)] + p[(r-1)][i_c] + p[(r-1)][(i_c+1)] + p[r][(i_c+1)] + p[0][(i_c+1)] + p[0][(i_c)] + p[0][(i_c-1)] );
-        update(p, f, r, i_c, n);
-    } 
-    n = ( p[0][1] + p[1][1] + p[1][0] + p[1][c] + p[0][c] + p[r][c] + p[r][0] + p[r][1] );
-    update(p, f, 0, 0, n); 
+    edge(p, f);
+}
 
-    n = ( p[1][c] + p[1][(c-1)] + p[0][(c-1)] + p[r][(c-1)] + p[r][c] + p[r][0] + p[0][0] + p[1][0] );
-    update(p, f, 0, c, n);
+/** 
+ * @brief Klein Bottle - Check and update life status of cell on the all sides with kelin properties.
+ * @details The ghost collums are copied from the opposite collum of the flipped row (r - i_r), then the ghost
+ * rows from the opposite row including its ghost cells.
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param i_r Index of row
+ */
+void klein(struct grid_t *p, struct grid_t *f){
+    int i_r, r = p->m_row - 1, c = p->n_col - 1;
 
-    n = ( p[r][(c-1)] + p[(r-1)][(c-1)] + p[(r-1)][c] + p[(r-1)][0] + p[r][0] + p[0][0] + p[0][c] + p[0][(c-1)]);
-    update(p, f, r, c, n);
+    for(i_r = 0; i_r <= r; i_r++){
+        p->row[i_r][-1] = p->row[r-i_r][c];
+        p->row[i_r][c+1] = p->row[r-i_r][0];
+    }
+    memcpy(p->row[-1] - 1, p->row[r] - 1, c + 3);
+    memcpy(p->row[r+1] - 1, p->row[0] - 1, c + 3);
 
-    n = ( p[r-1][0] + p[(r-1)][1] + p[r][1] + p[0][1] + p[0][0] + p[0][c] + p[r][c] + p[r-1][c] );
-    update(p, f, r, 0, n);
+    edge(p, f);
 }
 
 /** 
- * @brief Klein Bottle - Check and update life status of cell on the all sides with kelin properties.
- * @details First for loop check for left and right collum. Secound for loop check for top and bottom row.
+ * @brief Update the edge cells of a matrix as its edge type does. A hedge board that is counted is stepped whole
+ * around its live cells instead, unless the rule gives birth with no neighbours.
  * @param p Present Matrix - Current Generation
  * @param f Future Matrix - Next Generation
- * @param r Max row of matrix
- * @param c Max collum of matrix
- * @param i_r Index of row
- * @param i_c Index of collums
- * @param n number of cell's neighbors
+ * @param type type of edge - hedge, torus, klein
+ * @return 1 if the whole board was stepped, 0 if the middle is still to be stepped with mid()
+ */
+int grid_edge(struct grid_t *p, struct grid_t *f, char type){
+    if(type == 'h' && f->stats && !(rule.birth & 1)){
+        hedge_box(p, f);
+        return 1;
+    }
+    switch(type){
+        case 'h':
+            hedge(p, f);
+            break;
+        case 't':
+            torus(p, f);
+            break;
+        case 'k':
+            klein(p, f);
+            break;
+    }
+    return 0;
+}
+
+/** 
+ * @brief Advance the matrix gens generations, edge cells first, then the middle.
+ * @details p and f are swapped once per generation, so on return *p is the last generation.
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param gens number of generations
  */
-void klein(unsigned char **p, unsigned char **f, int r, int c){
-    
-    r--; c--;
-    int i_r, i_c, n;
+void grid_run(struct grid_t **p, struct grid_t **f, char type, long gens){
+    struct grid_t *tmp;
 
-    // Check Left and Right Collum
-    for(i_r = 1; i_r < r; i_r++){
-        n = ( p[(i_r-1)][0] + p[(i_r-1)][1] + p[i_r][1] + p[(i_r+1)][1] + p[(i_r+1)][0] + p[(r-i_r-1)][c] + p[(r-i_r)][c] + p[(r-i_r+1)][c] );
-        update(p, f, i_r, 0, n);
-        n = ( p[(i_r-1)][c] + p[(i_r-1)][c-1] + p[i_r][c-1] + p[(i_r+1)][c-1] + p[(i_r+1)][c] + p[(r-i_r-1)][0] + p[(r-i_r)][0] + p[(r-i_r+1)][0] );
-        update(p, f, i_r, c, n);      
-        }    
-
-    // Check Top and Bottom Row
-    for(i_c = 1; i_c < c; i_c++){
-        n =( p[r][(i_c-1)] + p[r][i_c] + p[r][(i_c+1)] + p[0][(i_c+1)] + p[1][(i_c+1)] + p[1][i_c] + p[1][(i_c-1)] + p[0][(i_c-1)] );
-        update(p, f, 0, i_c, n);
-        n = ( p[r][(i_c-1)] + p[(r-1)][(i_c-1)] + p[(r-1)][i_c] + p[(r-1)][(i_c+1)] + p[r][(i_c+1)] + p[0][(i_c+1)] + p[0][(i_c)] + p[0][(i_c-1)] );
-        update(p, f, r, i_c, n);
-    } 
-    n = ( p[0][1] + p[1][1] + p[1][0] + p[(r-1)][c] + p[r][c] + p[0][c] + p[r][0] + p[r][1] );
-    update(p, f, 0, 0, n);
-
-    n = ( p[1][c] + p[1][(c-1)] + p[0][(c-1)] + p[r][(c-1)] + p[r][c] + p[0][0] + p[r][0] + p[(r-1)][0] );
-    update(p, f, 0, c, n);
-    
-    n = ( p[r][(c-1)] + p[(r-1)][(c-1)] + p[(r-1)][c] + p[1][0] + p[0][0] + p[r][0] + p[0][c] + p[0][(c-1)]);
-    update(p, f, r, c, n);
-
-    n = ( p[r-1][0] + p[(r-1)][1] + p[r][1] + p[0][1] + p[0][0] + p[r][c] + p[0][c] + p[1][c] );
-    update(p, f, r, 0, n);
-}
\ No newline at end of file
+    for(; gens > 0; gens--){
+        if(!grid_edge(*p, *f, type))
+            mid(*p, *f);
+        tmp = *p;
+        *p = *f;
+        *f = tmp;
+    }
+}
+
+/** 
+ * @brief Ghost cells either side of row j for an edge type, read from the cells of the matrix only.
+ * @param p Present Matrix - Current Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param j row inside the matrix
+ * @param left set to the ghost cell left of the row
+ * @param right set to the ghost cell right of the row
+ */
+static void ghost_cells(struct grid_t *p, char type, int j, unsigned char *left, unsigned char *right){
+    int c = p->n_col - 1;
+
+    switch(type){
+        case 't':
+            *left = p->row[j][c];
+            *right = p->row[j][0];
+            break;
+        case 'k':
+            *left = p->row[p->m_row-1-j][c];
+            *right = p->row[p->m_row-1-j][0];
+            break;
+        default:
+            *left = 0;
+            *right = 0;
+    }
+}
+
+/** 
+ * @brief Map row y and collum x of the plane the edge type makes of the matrix to the cell it is a copy of.
+ * @details Rows wrap across the top and bottom for torus and klein. Collums wrap across the left and right, and for
+ * klein each wrap flips the row, row y being row m_row - 1 - y on the other side. Every cell of the plane then has the
+ * neighbours of the cell it is a copy of, so a part of the plane steps as the cells it was copied from do.
+ * @param type type of edge - hedge, torus, klein
+ * @param m_row number of row in matrix
+ * @param n_col number of collum in matrix
+ * @param y row, any, set to the row of the matrix
+ * @param x collum, any, set to the collum of the matrix
+ * @return 1 if the cell is in the matrix, 0 if it is past the edge of a hedge board and so always dead
+ */
+int cover(char type, int m_row, int n_col, int *y, int *x){
+    if(type == 'h')
+        return *y >= 0 && *y < m_row && *x >= 0 && *x < n_col;
+    for(; *x < 0; *x += n_col)
+        if(type == 'k')
+            *y = m_row - 1 - *y;
+    for(; *x >= n_col; *x -= n_col)
+        if(type == 'k')
+            *y = m_row - 1 - *y;
+    *y %= m_row;
+    if(*y < 0)
+        *y += m_row;
+    return 1;
+}
+
+/** 
+ * @brief Copy cells c0 - 1 to c1 of row j, as seen from the edge type, into a private row.
+ * @details Rows past the top and bottom wrap for torus and klein and are dead for hedge. Cells -1 and n_col
+ * are the ghost cells of the row.
+ * @param p Present Matrix - Current Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param j row to copy, -1 to m_row
+ * @param c0 first collum of the span
+ * @param c1 collum after the span
+ * @param buf private row of c1 - c0 + 2 cells, starting with cell c0 - 1
+ */
+static void copy_span(struct grid_t *p, char type, int j, int c0, int c1, unsigned char *buf){
+    int m = p->m_row, n = p->n_col;
+    unsigned char left, right;
+
+    if(j < 0 || j >= m){
+        if(type == 'h'){
+            memset(buf, 0, c1 - c0 + 2);
+            return;
+        }
+        j = (j + m) % m;
+    }
+    ghost_cells(p, type, j, &left, &right);
+    buf[0] = c0 == 0 ? left : p->row[j][c0-1];
+    memcpy(buf + 1, p->row[j] + c0, c1 - c0);
+    buf[c1-c0+1] = c1 == n ? right : p->row[j][c1];
+}
+
+/** 
+ * @brief Copy row j, as seen from the edge type, with its ghost cells into a private row.
+ * @param p Present Matrix - Current Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param j row to copy, -1 to m_row
+ * @param buf private row of n_col + 2 cells, starting with the left ghost cell
+ */
+static void copy_row(struct grid_t *p, char type, int j, unsigned char *buf){
+    copy_span(p, type, j, 0, p->n_col, buf);
+}
+
+/** 
+ * @brief Update the band of rows r0 to r1 - 1, edges included, so bands can run on separate threads.
+ * @details Only the ghost cells of the band's own rows are written. The rows just outside the band are copied
+ * into work with their ghost cells instead of being read from the matrix, since another band may be setting
+ * their ghost cells at the same time. Every cell read from the matrix is one no band writes this generation.
+ * The band is counted into stats of its own, as the counts of f are shared by every band.
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param r0 first row of the band
+ * @param r1 row after the band
+ * @param work two private rows of stride cells
+ * @param stats counts of the band, started over here, or NULL
+ */
+void step_band(struct grid_t *p, struct grid_t *f, char type, int r0, int r1, unsigned char *work, struct stats_t *stats){
+    unsigned char *above = work + 1, *below = work + p->stride + 1;
+    const unsigned char *up, *down;
+    int r, n = p->n_col;
+
+    for(r = r0; r < r1; r++)
+        ghost_cells(p, type, r, &p->row[r][-1], &p->row[r][n]);
+    copy_row(p, type, r0 - 1, above - 1);
+    copy_row(p, type, r1, below - 1);
+
+    if(stats)
+        stats_clear(stats);
+    for(r = r0; r < r1; r++){
+        up = r == r0 ? above : p->row[r-1];
+        down = r == r1 - 1 ? below : p->row[r+1];
+        run_row(p, f, up, down, r, 0, n, stats);
+    }
+}
+
+/** 
+ * @brief Update the tile of rows r0 to r1 - 1 and collums c0 to c1 - 1 and tell if any of its cells changed.
+ * @details Only the ghost cells the tile reads are filled: those of its own rows and the row either side when
+ * it touches the first or last collum, and the span of a ghost row when it touches the first or last row.
+ * Cells outside the tile are left as they are in f.
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param r0 first row of the tile
+ * @param r1 row after the tile
+ * @param c0 first collum of the tile
+ * @param c1 collum after the tile
+ * @return 1 if a cell of the tile differs between p and f, otherwise 0
+ */
+int step_tile(struct grid_t *p, struct grid_t *f, char type, int r0, int r1, int c0, int c1){
+    int r, m = p->m_row, n = p->n_col, w = c1 - c0, changed = 0;
+
+    if(c0 == 0 || c1 == n)
+        for(r = r0 > 0 ? r0 - 1 : 0; r <= r1 && r < m; r++)
+            ghost_cells(p, type, r, &p->row[r][-1], &p->row[r][n]);
+    if(r0 == 0)
+        copy_span(p, type, -1, c0, c1, p->row[-1] + c0 - 1);
+    if(r1 == m)
+        copy_span(p, type, m, c0, c1, p->row[m] + c0 - 1);
+
+    for(r = r0; r < r1; r++){
+        kernel->row[rule.id](p->row[r-1] + c0, p->row[r] + c0, p->row[r+1] + c0, f->row[r] + c0, w);
+        if(memcmp(p->row[r] + c0, f->row[r] + c0, w)){
+            changed = 1;
+            if(f->dirty)
+                f->dirty[r] = 1;
+            if(f->census)
+                census_row(f->census, p->row[r], f->row[r], r, c0, w);
+            if(f->hash)
+                rowhash_add(f->hash, f, r, flip_hash(p->row[r], f->row[r], c0, w, f->hash->key));
+        }
+    }
+    return changed;
+}
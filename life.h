@@ -7,16 +7,159 @@
 #ifndef LIFE_H_
 #define LIFE_H_
 
-void free_matrix(unsigned char **matrix, int m_row);
+#include <stdint.h>
+
+/** Alignment of the matrix block and of every row in it. */
+#define GRID_ALIGN 64
+
+/**
+ * Hash of every row of a board, and of the board, the XOR of the row hashes each mixed with its row number.
+ * A row hash is the sum of each group of its cells as a number, a bit per cell, times the key of the group: groups
+ * of 16 cells in a byte row, the words of a packed row. So the steps update a row from the groups that change in it
+ * alone, by the difference of each times its key, and the board from the rows that changed alone. The changes to
+ * the board hash a step makes go to the slot of the matrix it writes, so a thread pool can add up one generation
+ * while its bands already write the next. A byte and a packed board hash differently.
+ */
+struct rowhash_t {
+        uint64_t *row;			/* row[r] is the hash of row r */
+        uint64_t *key;			/* key[g] multiplies group g of a row, odd */
+        uint64_t board;			/* hash of the board, as of the last rowhash_fold() */
+        uint64_t moved[2];		/* changes to board not yet folded in, made writing even and the other matrix */
+        const void *even;		/* the matrix whose changes go to moved[0] */
+        uint64_t *trail;		/* if set, a thread pool sets trail[g] to board after generation g of each job */
+};
+
+/**
+ * Counts of a generation, kept by the steps as they write it. A step starts the counts of the matrix it writes over
+ * and adds in each row as the kernel leaves it, so there is no second pass over the board.
+ */
+struct stats_t {
+        long population;		/* live cells */
+        long births;			/* cells alive that were dead the generation before */
+        long deaths;			/* cells dead that were alive the generation before */
+        int top, bottom;		/* first and last row with a live cell, bottom < top if there are none */
+        int left, right;		/* first and last collum with a live cell */
+};
+
+/** Levels of tiles a census keeps, of 64, 512, 4096 and 32768 cells a side. */
+#define CENSUS_LEVELS 4
+
+/**
+ * Live cells of every tile of a board, for tiles of 64 by 64 cells and of each size eight times larger, so a square
+ * block of 2^k cells a side, k at least 6, lined up on its size is the sum of at most 16 counts. The steps keep it
+ * up to date by adding the change of each span of 64 cells, a word of a packed row, of a row that changed. Bands of
+ * a thread pool share the tiles across their edges, so the counts are added atomically.
+ */
+struct census_t {
+        int rows[CENSUS_LEVELS];	/* tiles down the board at each level */
+        int cols[CENSUS_LEVELS];	/* tiles across the board at each level */
+        int *count[CENSUS_LEVELS];	/* count[k][i * cols[k] + j] is the live cells of tile j of tile row i of level k */
+};
+
+/**
+ * Matrix of cells in one allocation with a one cell ghost border.
+ * row[r][c] is valid for -1 <= r <= m_row and -1 <= c <= n_col.
+ */
+struct grid_t {
+        unsigned char **row;
+        unsigned char *cell;
+        int m_row;
+        int n_col;
+        int stride;
+        unsigned char *dirty;		/* if set, the step sets dirty[r] when row r of this matrix changes */
+        struct rowhash_t *hash;		/* if set, the step keeps the hashes of the rows up to date */
+        struct stats_t *stats;		/* if set, the step counts the generation it writes into this matrix */
+        struct census_t *census;	/* if set, the step keeps the live cells of each tile of this matrix */
+};
+
+/**
+ * @brief Splitmix64 mix of a number, the key of collum x in the row hashes.
+ * @param x number to mix
+ */
+static inline uint64_t hash_key(uint64_t x){
+    uint64_t z = (x + 1) * 0x9e3779b97f4a7c15ULL;
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Hash of row r of the board mixed with r, so the same row in two places does not cancel out.
+ * @param hash hash of the row
+ * @param r the row
+ */
+static inline uint64_t row_mix(uint64_t hash, int r){
+    return hash_key(hash + (uint64_t)r * 0xd6e8feb86659fd93ULL);
+}
+
+/**
+ * @brief Add the change to row r writing matrix f to the row hash, and the change to the board hash to the slot
+ * of f. Bands of a thread pool call it at once for their own rows.
+ * @param h the hashes
+ * @param f matrix being written
+ * @param r the row
+ * @param delta change to the row hash
+ */
+static inline void rowhash_add(struct rowhash_t *h, const void *f, int r, uint64_t delta){
+    uint64_t old = h->row[r];
+
+    if(!delta)
+        return;
+    h->row[r] = old + delta;
+    __atomic_fetch_xor(&h->moved[f != h->even], row_mix(old, r) ^ row_mix(old + delta, r), __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Fold the changes made writing one matrix into the board hash, once the generation it holds is complete.
+ * @param h the hashes
+ * @param f the matrix
+ * @return the board hash
+ */
+static inline uint64_t rowhash_fold(struct rowhash_t *h, const void *f){
+    h->board ^= h->moved[f != h->even];
+    h->moved[f != h->even] = 0;
+    return h->board;
+}
+
+/** Receives each run of n live cells read by pattern_read(), starting at x, y and going along x. */
+typedef void (*cell_fn)(void *ctx, int x, int y, int n);
+
+/** Matrix and edge type pattern_cell() sets cells in. */
+struct pattern_ctx_t {
+        struct grid_t *p;
+        unsigned char type;
+        long outside;			/* runs past the edge of a hedge matrix, not set */
+};
+
+void free_matrix(struct grid_t *matrix);
 void malloc_failed(unsigned char **a, int size);
-unsigned char **init_matrix(int m_row, int n_col);
-void cell_in(unsigned char **p, int m_row, int n_col, char type, int x, int y);
-void pattern_in(unsigned char **p, unsigned char type, FILE *fp, int x, int y, int m_row, int n_col);
-void print_matrix(unsigned char **matrix, int m_row, int n_col);
-void update(unsigned char **p, unsigned char **f, int r, int c, char n);
-void mid(unsigned char **p, unsigned char **f, int r, int c);
-void hedge(unsigned char **p, unsigned char **f, int r, int c);
-void torus(unsigned char **p, unsigned char **f, int r, int c);
-void klein(unsigned char **p, unsigned char **f, int r, int c);
+struct grid_t *init_matrix(int m_row, int n_col);
+int cell_in(struct grid_t *p, char type, int x, int y);
+int run_in(struct grid_t *p, char type, int x, int y, int n);
+long pattern_read(FILE *fp, int x, int y, int width, int height, cell_fn cell, void *ctx);
+void pattern_cell(void *ctx, int x, int y, int n);
+long pattern_in(struct grid_t *p, unsigned char type, FILE *fp, int x, int y);
+void print_matrix(struct grid_t *matrix);
+uint64_t flip_hash(const unsigned char *p, const unsigned char *f, int c, int n, const uint64_t *key);
+void mid(struct grid_t *p, struct grid_t *f);
+void edge(struct grid_t *p, struct grid_t *f);
+void hedge(struct grid_t *p, struct grid_t *f);
+void torus(struct grid_t *p, struct grid_t *f);
+void klein(struct grid_t *p, struct grid_t *f);
+void hedge_box(struct grid_t *p, struct grid_t *f);
+int grid_edge(struct grid_t *p, struct grid_t *f, char type);
+void grid_run(struct grid_t **p, struct grid_t **f, char type, long gens);
+void stats_clear(struct stats_t *s);
+void stats_merge(struct stats_t *s, const struct stats_t *t);
+void stats_grid(struct stats_t *s, struct grid_t *g);
+struct census_t *init_census(int m_row, int n_col);
+void free_census(struct census_t *s);
+void census_add(struct census_t *s, int r, int w, const int *d, int spans);
+void census_row(struct census_t *s, const unsigned char *p, const unsigned char *f, int r, int c, int n);
+void census_grid(struct census_t *s, struct grid_t *g);
+int cover(char type, int m_row, int n_col, int *y, int *x);
+void step_band(struct grid_t *p, struct grid_t *f, char type, int r0, int r1, unsigned char *work, struct stats_t *stats);
+int step_tile(struct grid_t *p, struct grid_t *f, char type, int r0, int r1, int c0, int c1);
 
 #endif
@@ -0,0 +1,242 @@
+/**
+ * @file pool.c
+ * @brief Thread pool for convey's game of life
+ * @details 
+ * The rows of the matrix are split into one band per thread. The threads are
+ * started once and each generation every thread updates its band, edges
+ * included, then waits on one barrier before the matrices are swapped.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "life.h"
+#include "bitlife.h"
+#include "pool.h"
+
+/** 
+ * @brief Run the current job on thread t's band for every generation of the job.
+ * @details Each thread swaps its own copy of the matrix pointers, so the only shared step is the barrier. The job
+ * is copied before the first generation, since the caller may set the next job as soon as the last barrier is passed.
+ * When the rows are hashed with a trail, thread 0 folds each generation into the board hash once the barrier shows
+ * it complete and leaves it in the trail; the other bands' changes to the next generation go to the other slot.
+ * @param pool the pool
+ * @param t index of the thread
+ */
+static void run_band(struct pool_t *pool, int t){
+    long g, gens = pool->gens;
+    char type = pool->type;
+
+    if(pool->p){
+        struct grid_t *p = pool->p, *f = pool->f, *tmp;
+        int r0 = (long)p->m_row * t / pool->threads, r1 = (long)p->m_row * (t + 1) / pool->threads;
+        unsigned char *work = pool->work + (long)t * 2 * p->stride;
+        for(g = 0; g < gens; g++){
+            step_band(p, f, type, r0, r1, work, f->stats ? &pool->stats[t] : NULL);
+            pthread_barrier_wait(&pool->barrier);
+            if(t == 0 && f->hash && f->hash->trail)
+                f->hash->trail[g] = rowhash_fold(f->hash, f);
+            tmp = p;
+            p = f;
+            f = tmp;
+        }
+    }
+    else{
+        struct bitgrid_t *p = pool->bp, *f = pool->bf, *tmp;
+        int r0 = (long)p->m_row * t / pool->threads, r1 = (long)p->m_row * (t + 1) / pool->threads;
+        uint64_t *work = pool->bits + (long)t * pool->bit_work;
+        for(g = 0; g < gens; g++){
+            bit_step_band(p, f, type, r0, r1, work, f->stats ? &pool->stats[t] : NULL);
+            pthread_barrier_wait(&pool->barrier);
+            if(t == 0 && f->hash && f->hash->trail)
+                f->hash->trail[g] = rowhash_fold(f->hash, f);
+            tmp = p;
+            p = f;
+            f = tmp;
+        }
+    }
+}
+
+/** 
+ * @brief Body of worker threads 1 to threads - 1. Wait for every worker to be started, then wait for a job, run
+ * it, repeat until told to quit.
+ * @param arg the thread's struct worker_t
+ */
+static void *worker(void *arg){
+    struct worker_t *w = arg;
+
+    pthread_mutex_lock(&w->pool->lock);
+    while(!w->pool->started)
+        pthread_cond_wait(&w->pool->go, &w->pool->lock);
+    pthread_mutex_unlock(&w->pool->lock);
+    if(w->pool->quit)
+        return NULL;
+
+    while(1){
+        pthread_barrier_wait(&w->pool->barrier);
+        if(w->pool->quit)
+            return NULL;
+        run_band(w->pool, w->t);
+    }
+}
+
+/** 
+ * @brief Free the pool and what it holds. Its workers must have ended.
+ * @param pool the pool
+ */
+static void free_pool(struct pool_t *pool){
+    pthread_barrier_destroy(&pool->barrier);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->go);
+    free(pool->tid);
+    free(pool->worker);
+    free(pool->work);
+    free(pool->bits);
+    free(pool->stats);
+    free(pool);
+}
+
+/** 
+ * @brief Start the worker threads. Return adress of the pool is sussesful or NULL if malloc failed or a thread could
+ * not be started.
+ * @details The workers wait at a start gate until all of them are started, since the barrier needs every thread.
+ * If one can not be started, those that were are let through the gate told to quit and joined.
+ * @param threads number of threads stepping, the caller included
+ * @param stride stride of the byte matrices that will be stepped, or 0 for bit matrices only
+ * @param words words per row of the bit matrices that will be stepped, or 0 for byte matrices only
+ */
+struct pool_t *pool_create(int threads, int stride, int words){
+    struct pool_t *pool;
+    int t, made;
+
+    pool = calloc(1, sizeof(struct pool_t));
+    if(!pool)
+        return NULL;
+    pool->threads = threads;
+    pool->tid = calloc(threads, sizeof(pthread_t));
+    pool->worker = calloc(threads, sizeof(struct worker_t));
+    pool->work = malloc((size_t)threads * 2 * stride + 1);
+    pool->bit_work = BIT_WORK(words);
+    pool->bits = malloc((size_t)threads * pool->bit_work * sizeof(uint64_t));
+    pool->stats = calloc(threads, sizeof(struct stats_t));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->go, NULL);
+    if(!pool->tid || !pool->worker || !pool->work || !pool->bits || !pool->stats
+       || pthread_barrier_init(&pool->barrier, NULL, threads)){
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->go);
+        free(pool->tid);
+        free(pool->worker);
+        free(pool->work);
+        free(pool->bits);
+        free(pool->stats);
+        free(pool);
+        return NULL;
+    }
+    for(made = 1; made < threads; made++){
+        pool->worker[made].pool = pool;
+        pool->worker[made].t = made;
+        if(pthread_create(&pool->tid[made], NULL, worker, &pool->worker[made]))
+            break;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = made < threads;
+    pool->started = 1;
+    pthread_cond_broadcast(&pool->go);
+    pthread_mutex_unlock(&pool->lock);
+    if(made == threads)
+        return pool;
+    for(t = 1; t < made; t++)
+        pthread_join(pool->tid[t], NULL);
+    free_pool(pool);
+    return NULL;
+}
+
+/** 
+ * @brief Stop the worker threads and free the pool.
+ * @param pool the pool
+ */
+void pool_destroy(struct pool_t *pool){
+    int t;
+
+    pool->quit = 1;
+    pthread_barrier_wait(&pool->barrier);
+    for(t = 1; t < pool->threads; t++)
+        pthread_join(pool->tid[t], NULL);
+    free_pool(pool);
+}
+
+/** 
+ * @brief Add up the counts of every band into the counts of the last generation.
+ * @param pool the pool
+ * @param stats counts of the last generation
+ */
+static void merge_stats(struct pool_t *pool, struct stats_t *stats){
+    int t;
+
+    stats_clear(stats);
+    for(t = 0; t < pool->threads; t++)
+        stats_merge(stats, &pool->stats[t]);
+}
+
+/** 
+ * @brief Advance the byte matrix gens generations on all threads of the pool.
+ * @details One barrier starts the job, then there is one barrier per generation. p and f are swapped once
+ * per generation, so on return *p is the last generation.
+ * @param pool the pool
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param gens number of generations
+ */
+void pool_step(struct pool_t *pool, struct grid_t **p, struct grid_t **f, char type, long gens){
+    struct grid_t *tmp;
+
+    pool->p = *p;
+    pool->f = *f;
+    pool->bp = NULL;
+    pool->bf = NULL;
+    pool->type = type;
+    pool->gens = gens;
+    pthread_barrier_wait(&pool->barrier);
+    run_band(pool, 0);
+    if(gens % 2){
+        tmp = *p;
+        *p = *f;
+        *f = tmp;
+    }
+    if((*p)->stats && gens > 0)
+        merge_stats(pool, (*p)->stats);
+}
+
+/** 
+ * @brief Advance the bit matrix gens generations on all threads of the pool.
+ * @param pool the pool
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param gens number of generations
+ */
+void pool_bit_step(struct pool_t *pool, struct bitgrid_t **p, struct bitgrid_t **f, char type, long gens){
+    struct bitgrid_t *tmp;
+
+    pool->p = NULL;
+    pool->f = NULL;
+    pool->bp = *p;
+    pool->bf = *f;
+    pool->type = type;
+    pool->gens = gens;
+    pthread_barrier_wait(&pool->barrier);
+    run_band(pool, 0);
+    if(gens % 2){
+        tmp = *p;
+        *p = *f;
+        *f = tmp;
+    }
+    if((*p)->stats && gens > 0)
+        merge_stats(pool, (*p)->stats);
+}
@@ -0,0 +1,51 @@
+/**
+ * @file pool.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the thread pool stepping the matrix in bands of rows
+ */
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <stdint.h>
+#include <pthread.h>
+
+struct grid_t;
+struct bitgrid_t;
+struct stats_t;
+
+/** Argument of a worker thread. */
+struct worker_t {
+        struct pool_t *pool;
+        int t;
+};
+
+/**
+ * Threads that step bands of rows. Thread 0 is the caller of pool_step() or pool_bit_step().
+ * The job fields are set by the caller before the start barrier and only read by the workers.
+ */
+struct pool_t {
+        int threads;
+        pthread_t *tid;
+        struct worker_t *worker;
+        pthread_barrier_t barrier;
+        unsigned char *work;		/* two private rows per thread for step_band() */
+        uint64_t *bits;			/* work rows per thread for bit_step_band(), bit_work words each */
+        int bit_work;
+        struct stats_t *stats;		/* counts of each thread's band, added up once a job is done */
+        int quit;
+        pthread_mutex_t lock;
+        pthread_cond_t go;		/* signalled once every worker is started, or one could not be */
+        int started;			/* set under lock when the workers may pass the start gate */
+        struct grid_t *p, *f;		/* byte job, or NULL */
+        struct bitgrid_t *bp, *bf;	/* bit job, or NULL */
+        char type;
+        long gens;
+};
+
+struct pool_t *pool_create(int threads, int stride, int words);
+void pool_destroy(struct pool_t *pool);
+void pool_step(struct pool_t *pool, struct grid_t **p, struct grid_t **f, char type, long gens);
+void pool_bit_step(struct pool_t *pool, struct bitgrid_t **p, struct bitgrid_t **f, char type, long gens);
+
+#endif
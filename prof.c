@@ -0,0 +1,323 @@
+/**
+ * @file prof.c
+ * @brief Phase timings of the main loop of convey's game of life
+ * @details
+ * Built in only with make PROF=1, which defines LIFE_PROF. Otherwise the
+ * PROF_ macros of prof.h are empty and this file compiles to nothing.
+ * Each phase keeps a count, total, maximum and a histogram of its times with
+ * eight buckets per power of two, so p50 and p99 are found to within an eighth
+ * without keeping every sample. Times are taken from the time stamp counter and
+ * turned into nanoseconds against the monotonic clock when written. Every phase
+ * is timed by one thread only, so a sample is a plain add with no lock.
+ * On Linux the cycles, instructions, cache references and cache misses of the
+ * run are counted with perf_event_open() when the kernel allows it. Counters
+ * follow the threads created after prof_open(), whose counts are added in as
+ * they are joined.
+ * The timings are written as one JSON object per line, or as CSV rows when the
+ * file name ends in .csv, at the end of each run and every few generations.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#ifdef LIFE_PROF
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <time.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "prof.h"
+
+/** Buckets per power of two of the histograms. */
+#define PROF_SUB 8
+
+/** Buckets of a histogram, enough for any 64 bit time. */
+#define PROF_BUCKETS ((64 - 2) * PROF_SUB)
+
+/** Hardware counters read with perf_event_open(). */
+#define PROF_COUNTERS 4
+
+/** Timings of one phase. Written by the one thread timing the phase, read by the thread writing them out. */
+struct phase_t {
+        _Atomic uint64_t count;
+        _Atomic uint64_t total;
+        _Atomic uint64_t max;
+        _Atomic uint64_t bucket[PROF_BUCKETS];
+};
+
+static const char *phases[PROF_PHASES] = {
+    [PROF_EDGE] = "edge", [PROF_MID] = "mid", [PROF_SWAP] = "swap", [PROF_STEP] = "step",
+    [PROF_FRAME] = "frame", [PROF_RENDER] = "render", [PROF_POLL] = "poll", [PROF_GEN] = "generation"
+};
+
+static const char *counters[PROF_COUNTERS] = { "cycles", "instructions", "cache_references", "cache_misses" };
+
+static struct phase_t phase[PROF_PHASES];
+
+/** Output file and the run being timed. */
+static struct {
+        FILE *out;
+        int csv;			/* CSV rows, otherwise JSON lines */
+        long every;			/* generations between writes, 0 for only at the end */
+        char run[96];			/* name of the run */
+        struct timespec start;		/* start of the run on the monotonic clock */
+        uint64_t tick;			/* start of the run in ticks */
+        uint64_t last;			/* end of the last generation in ticks */
+        long written;			/* generation last written, -1 for none */
+        int fd[PROF_COUNTERS];		/* perf_event_open() counters, -1 if not available */
+} prof = { .fd = { -1, -1, -1, -1 } };
+
+/**
+ * @brief Add one to a value only this thread writes.
+ * @param a the value
+ * @param v amount to add
+ */
+static inline void bump(_Atomic uint64_t *a, uint64_t v){
+    atomic_store_explicit(a, atomic_load_explicit(a, memory_order_relaxed) + v, memory_order_relaxed);
+}
+
+/**
+ * @brief Histogram bucket of a time: itself below PROF_SUB, then PROF_SUB buckets per power of two.
+ * @param v time in ticks
+ */
+static int bucket(uint64_t v){
+    int e;
+
+    if(v < PROF_SUB)
+        return v;
+    e = 63 - __builtin_clzll(v);
+    return (e - 2) * PROF_SUB + (v >> (e - 3) & (PROF_SUB - 1));
+}
+
+/**
+ * @brief Middle of the times of a bucket.
+ * @param b the bucket
+ */
+static double bucket_mid(int b){
+    int e = b / PROF_SUB + 2;
+
+    if(b < PROF_SUB)
+        return b;
+    return (double)((uint64_t)(PROF_SUB + b % PROF_SUB) << (e - 3)) + (double)((uint64_t)1 << (e - 3)) / 2;
+}
+
+/**
+ * @brief Time below which a share of the samples of a phase fall, from its histogram, at most the slowest sample.
+ * @param p the phase
+ * @param q share of the samples, 0 to 1
+ */
+static double percentile(struct phase_t *p, double q){
+    uint64_t count = atomic_load_explicit(&p->count, memory_order_relaxed), want = q * count + 0.5, sum = 0;
+    double max = atomic_load_explicit(&p->max, memory_order_relaxed);
+    int b;
+
+    if(want == 0)
+        want = 1;
+    for(b = 0; b < PROF_BUCKETS; b++){
+        sum += atomic_load_explicit(&p->bucket[b], memory_order_relaxed);
+        if(sum >= want)
+            /* the middle of the last bucket can be past the slowest sample */
+            return bucket_mid(b) < max ? bucket_mid(b) : max;
+    }
+    return max;
+}
+
+/**
+ * @brief Open the hardware counters, following every thread created from now on.
+ */
+static void counters_open(void){
+#ifdef __linux__
+    static const uint64_t config[PROF_COUNTERS] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES };
+    struct perf_event_attr attr;
+    int i;
+
+    for(i = 0; i < PROF_COUNTERS; i++){
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config[i];
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        prof.fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+}
+
+/**
+ * @brief Read a hardware counter.
+ * @param i the counter
+ * @param v set to its count
+ * @return 0 if it was read, -1 if the counter is not available
+ */
+static int counter_read(int i, uint64_t *v){
+#ifdef __linux__
+    if(prof.fd[i] >= 0 && read(prof.fd[i], v, sizeof(*v)) == sizeof(*v))
+        return 0;
+#endif
+    return -1;
+}
+
+/**
+ * @brief Write the timings of the run so far.
+ * @param generation generation the run is at
+ */
+static void prof_write(long generation){
+    struct timespec now;
+    double secs, ns, n;
+    uint64_t ticks, v[PROF_COUNTERS];
+    int i, first = 1, have[PROF_COUNTERS];
+    struct phase_t *p;
+
+    prof.written = generation;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ticks = prof_now() - prof.tick;
+    secs = (now.tv_sec - prof.start.tv_sec) + (now.tv_nsec - prof.start.tv_nsec) / 1e9;
+    /* nanoseconds per tick, measured over the run */
+    ns = ticks ? secs * 1e9 / ticks : 1;
+    for(i = 0; i < PROF_COUNTERS; i++)
+        have[i] = !counter_read(i, &v[i]);
+
+    if(!prof.csv)
+        fprintf(prof.out, "{\"run\":\"%s\",\"generation\":%ld,\"seconds\":%.6f,\"phases\":{", prof.run, generation, secs);
+    for(i = 0; i < PROF_PHASES; i++){
+        p = &phase[i];
+        n = atomic_load_explicit(&p->count, memory_order_relaxed);
+        if(n == 0)
+            continue;
+        if(prof.csv)
+            fprintf(prof.out, "%s,%ld,%.6f,%s,%.0f,%.0f,%.1f,%.1f,%.1f,%.0f\n", prof.run, generation, secs, phases[i], n,
+                    atomic_load_explicit(&p->total, memory_order_relaxed) * ns, atomic_load_explicit(&p->total, memory_order_relaxed) * ns / n,
+                    percentile(p, 0.5) * ns, percentile(p, 0.99) * ns, atomic_load_explicit(&p->max, memory_order_relaxed) * ns);
+        else
+            fprintf(prof.out, "%s\"%s\":{\"count\":%.0f,\"total_ns\":%.0f,\"mean_ns\":%.1f,\"p50_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.0f}", first ? "" : ",", phases[i], n,
+                    atomic_load_explicit(&p->total, memory_order_relaxed) * ns, atomic_load_explicit(&p->total, memory_order_relaxed) * ns / n,
+                    percentile(p, 0.5) * ns, percentile(p, 0.99) * ns, atomic_load_explicit(&p->max, memory_order_relaxed) * ns);
+        first = 0;
+    }
+    if(prof.csv){
+        for(i = 0; i < PROF_COUNTERS; i++)
+            if(have[i])
+                fprintf(prof.out, "%s,%ld,%.6f,%s,%llu,,,,,\n", prof.run, generation, secs, counters[i], (unsigned long long)v[i]);
+    }
+    else if(!have[0] || !have[1])
+        fprintf(prof.out, "},\"counters\":null}\n");
+    else{
+        fprintf(prof.out, "},\"counters\":{");
+        for(i = 0; i < PROF_COUNTERS; i++)
+            if(have[i])
+                fprintf(prof.out, "\"%s\":%llu,", counters[i], (unsigned long long)v[i]);
+        fprintf(prof.out, "\"ipc\":%.3f}}\n", v[0] ? (double)v[1] / v[0] : 0);
+    }
+    fflush(prof.out);
+}
+
+/**
+ * @brief Open the file the timings are written to and the hardware counters.
+ * @param path file to write, CSV if it ends in .csv, otherwise JSON lines
+ * @param every generations between writes, 0 for only at the end of each run
+ * @return 0 if the file was opened, otherwise -1
+ */
+int prof_open(const char *path, long every){
+    size_t len = strlen(path);
+
+    if(!(prof.out = fopen(path, "w")))
+        return -1;
+    prof.csv = len >= 4 && !strcmp(path + len - 4, ".csv");
+    prof.every = every;
+    if(prof.csv)
+        fprintf(prof.out, "run,generation,seconds,phase,count,total_ns,mean_ns,p50_ns,p99_ns,max_ns\n");
+    counters_open();
+    return 0;
+}
+
+/**
+ * @brief Close the file and the hardware counters.
+ */
+void prof_close(void){
+    int i;
+
+    for(i = 0; i < PROF_COUNTERS; i++)
+        if(prof.fd[i] >= 0){
+            close(prof.fd[i]);
+            prof.fd[i] = -1;
+        }
+    if(prof.out)
+        fclose(prof.out);
+    prof.out = NULL;
+}
+
+/**
+ * @brief Start the timings of a run, clearing those of the last one and the hardware counters.
+ * @param fmt printf() format of the name of the run, followed by its arguments
+ */
+void prof_begin(const char *fmt, ...){
+    va_list ap;
+    int i;
+
+    va_start(ap, fmt);
+    vsnprintf(prof.run, sizeof(prof.run), fmt, ap);
+    va_end(ap);
+    memset(phase, 0, sizeof(phase));
+#ifdef __linux__
+    for(i = 0; i < PROF_COUNTERS; i++)
+        if(prof.fd[i] >= 0)
+            ioctl(prof.fd[i], PERF_EVENT_IOC_RESET, 0);
+#else
+    (void)i;
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &prof.start);
+    prof.tick = prof.last = prof_now();
+    prof.written = -1;
+}
+
+/**
+ * @brief Add a sample to a phase.
+ * @param ph the phase
+ * @param ticks time it took
+ */
+void prof_add(enum prof_phase ph, uint64_t ticks){
+    struct phase_t *p = &phase[ph];
+
+    bump(&p->count, 1);
+    bump(&p->total, ticks);
+    bump(&p->bucket[bucket(ticks)], 1);
+    if(ticks > atomic_load_explicit(&p->max, memory_order_relaxed))
+        atomic_store_explicit(&p->max, ticks, memory_order_relaxed);
+}
+
+/**
+ * @brief End a generation, timing it from the end of the last one, and write the timings every few generations.
+ * @param generation the generation just reached
+ */
+void prof_generation(long generation){
+    uint64_t now = prof_now();
+
+    prof_add(PROF_GEN, now - prof.last);
+    prof.last = now;
+    if(prof.out && prof.every && generation % prof.every == 0){
+        prof_write(generation);
+        /* the next generation does not pay for the write */
+        prof.last = prof_now();
+    }
+}
+
+/**
+ * @brief Write the timings at the end of a run, unless they were just written at the same generation.
+ * @param generation the last generation of the run
+ */
+void prof_end(long generation){
+    if(prof.out && prof.written != generation)
+        prof_write(generation);
+}
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file prof.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the phase timings of the main loop, built in with make PROF=1
+ */
+#ifndef PROF_H_
+#define PROF_H_
+
+#include <stdint.h>
+
+/** Phases of the main loop that are timed. */
+enum prof_phase {
+        PROF_EDGE,		/* hedge(), torus() or klein() */
+        PROF_MID,		/* mid() */
+        PROF_SWAP,		/* swapping the present and future matrix */
+        PROF_STEP,		/* a whole step of the engines that do not split into edge and mid */
+        PROF_FRAME,		/* filling a frame from the board */
+        PROF_RENDER,		/* drawing a frame in the window */
+        PROF_POLL,		/* SDL_PollEvent() and handling the events */
+        PROF_GEN,		/* a whole generation, from the end of the last one */
+        PROF_PHASES
+};
+
+#ifdef LIFE_PROF
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+/**
+ * @brief Timestamp in ticks of the time stamp counter, or nanoseconds where there is none.
+ */
+static inline uint64_t prof_now(void){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + t.tv_nsec;
+#endif
+}
+
+int prof_open(const char *path, long every);
+void prof_close(void);
+void prof_begin(const char *fmt, ...);
+void prof_add(enum prof_phase phase, uint64_t ticks);
+void prof_generation(long generation);
+void prof_end(long generation);
+
+/** Take the time at the start of a phase into a new variable t. */
+#define PROF_START(t) uint64_t t = prof_now()
+/** Add the time since PROF_START(t) to a phase. */
+#define PROF_STOP(phase, t) prof_add(phase, prof_now() - (t))
+/** End of a generation, written out every few generations if asked to. */
+#define PROF_GENERATION(g) prof_generation(g)
+/** Start the timings of a run, named for the output with a printf() format. */
+#define PROF_BEGIN(...) prof_begin(__VA_ARGS__)
+/** Write out the timings of the run at its last generation. */
+#define PROF_END(g) prof_end(g)
+/** Close the timings file at the end of the program. */
+#define PROF_CLOSE() prof_close()
+
+#else
+
+#define PROF_START(t)
+#define PROF_STOP(phase, t) ((void)0)
+#define PROF_GENERATION(g) ((void)0)
+#define PROF_BEGIN(...) ((void)0)
+#define PROF_END(g) ((void)0)
+#define PROF_CLOSE() ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,365 @@
+/**
+ * @file render.c
+ * @brief Viewport renderer for convey's game of life
+ * @details 
+ * The window looks at any part of a board of any size through a view that
+ * can be panned and zoomed. The simulation fills a frame of samples for the
+ * current view: one cell per sample when zoomed in, and the density of a
+ * block of cells per sample when zoomed out. The renderer expands the samples
+ * into a streaming texture the size of the window, so the cost of a frame
+ * follows the window and not the board. The steps mark the rows that change,
+ * and only the strips of the window showing those rows are filled and
+ * uploaded, so a quiet board costs little to draw. They also keep a census of
+ * the live cells of each tile, so a zoomed out sample adds up a few tile
+ * counts instead of the cells of its block.
+ * 
+ * Arrow keys or dragging with the left button pan, + and - or the mouse wheel
+ * zoom about the middle of the window.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+#include "bitlife.h"
+#include "triple.h"
+#include "render.h"
+
+/** 
+ * @brief Open the window and make the texture. Return 0 if sussesful or -1 if SDL failed.
+ * @param r the renderer
+ * @param width window width in pixels
+ * @param height window height in pixels
+ * @param red pixle's intensity value for red of a live cell
+ * @param green pixle's intensity value for green of a live cell
+ * @param blue pixle's intensity value for blue of a live cell
+ */
+int render_init(struct render_t *r, int width, int height, unsigned char red, unsigned char green, unsigned char blue){
+    int d, k;
+
+    if(SDL_Init(SDL_INIT_VIDEO) < 0)
+        return -1;
+    r->width = width;
+    r->height = height;
+    r->window = SDL_CreateWindow("Conway's Game of Life", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, SDL_WINDOW_SHOWN);
+    if(!r->window)
+        return -1;
+    r->renderer = SDL_CreateRenderer(r->window, -1, 0);
+    if(!r->renderer)
+        return -1;
+    r->texture = SDL_CreateTexture(r->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if(!r->texture)
+        return -1;
+    /* a block with any live cell is drawn at least a quarter bright so it can be seen */
+    r->shade[0] = 0xff000000u;
+    for(d = 1; d < 256; d++){
+        k = 64 + d * 191 / 255;
+        r->shade[d] = 0xff000000u | (Uint32)(red * k / 255) << 16 | (Uint32)(green * k / 255) << 8 | (Uint32)(blue * k / 255);
+    }
+    return 0;
+}
+
+/** 
+ * @brief Close the window.
+ * @param r the renderer
+ */
+void render_quit(struct render_t *r){
+    SDL_DestroyTexture(r->texture);
+    SDL_DestroyRenderer(r->renderer);
+    SDL_DestroyWindow(r->window);
+    SDL_Quit();
+}
+
+/** 
+ * @brief Fill and upload the pixels of screen x samples i0 to i1 - 1 of a frame.
+ * @param r the renderer
+ * @param f frame to draw
+ * @param i0 first sample
+ * @param i1 sample after the last
+ */
+static void render_strip(struct render_t *r, struct frame_t *f, int i0, int i1){
+    int px, py, pitch, z = f->zoom > 0 ? f->zoom : 0;
+    SDL_Rect rect = { i0 << z, 0, (i1 - i0) << z, r->height };
+    unsigned char **s = f->cells->row;
+    void *pixels;
+    Uint32 *line;
+
+    if(rect.x + rect.w > r->width)
+        rect.w = r->width - rect.x;
+    if(SDL_LockTexture(r->texture, &rect, &pixels, &pitch))
+        return;
+    for(py = 0; py < rect.h; py++){
+        line = (Uint32 *)((char *)pixels + (long)py * pitch) - rect.x;
+        for(px = rect.x; px < rect.x + rect.w; px++)
+            line[px] = r->shade[s[px >> z][py >> z]];
+    }
+    SDL_UnlockTexture(r->texture);
+}
+
+/** 
+ * @brief Draw a frame. Only the runs of dirty samples are uploaded unless the whole frame changed.
+ * @param r the renderer
+ * @param f frame to draw
+ */
+void render_frame(struct render_t *r, struct frame_t *f){
+    int i, i0;
+
+    if(f->full)
+        render_strip(r, f, 0, f->w);
+    else
+        for(i = 0; i < f->w; i++){
+            if(!f->dirty[i])
+                continue;
+            for(i0 = i; i < f->w && f->dirty[i]; i++)
+                ;
+            render_strip(r, f, i0, i);
+        }
+    SDL_RenderCopy(r->renderer, r->texture, NULL, NULL);
+    SDL_RenderPresent(r->renderer);
+}
+
+/** 
+ * @brief Cells covered by a number of pixels at a zoom.
+ * @param pixels number of pixels
+ * @param zoom zoom of the view
+ */
+static long span(long pixels, int zoom){
+    return zoom >= 0 ? pixels >> zoom : pixels << -zoom;
+}
+
+/** 
+ * @brief Start the view at the top left of the board.
+ * @param v the view
+ * @param width window width in pixels
+ * @param height window height in pixels
+ * @param zoom starting zoom
+ */
+void view_init(struct view_t *v, int width, int height, int zoom){
+    atomic_init(&v->x, 0);
+    atomic_init(&v->y, 0);
+    atomic_init(&v->zoom, zoom);
+    v->width = width;
+    v->height = height;
+    v->drag = 0;
+}
+
+/** 
+ * @brief Set the origin, zoom and size of a frame from the view.
+ * @details Zoomed out, the origin is rounded down to a whole block so a block always covers the same cells.
+ * @param v the view
+ * @param f frame to set up
+ */
+void view_frame(struct view_t *v, struct frame_t *f){
+    int z = atomic_load(&v->zoom);
+    long block = z >= 0 ? 1 : 1L << -z;
+
+    f->zoom = z;
+    f->x = atomic_load(&v->x) & ~(block - 1);
+    f->y = atomic_load(&v->y) & ~(block - 1);
+    f->w = z >= 0 ? (v->width + (1 << z) - 1) >> z : v->width;
+    f->h = z >= 0 ? (v->height + (1 << z) - 1) >> z : v->height;
+}
+
+/** 
+ * @brief Zoom by one step in or out, keeping the cell in the middle of the window in place.
+ * @param v the view
+ * @param step 1 to zoom in, -1 to zoom out
+ */
+static void zoom_by(struct view_t *v, int step){
+    int z = atomic_load(&v->zoom), nz = z + step;
+    long cx, cy;
+
+    if(nz < ZOOM_MIN || nz > ZOOM_MAX)
+        return;
+    cx = atomic_load(&v->x) + span(v->width / 2, z);
+    cy = atomic_load(&v->y) + span(v->height / 2, z);
+    atomic_store(&v->x, cx - span(v->width / 2, nz));
+    atomic_store(&v->y, cy - span(v->height / 2, nz));
+    atomic_store(&v->zoom, nz);
+}
+
+/** 
+ * @brief Pan or zoom the view for a key, wheel or mouse event. Other events are ignored.
+ * @param v the view
+ * @param e the event
+ */
+void view_event(struct view_t *v, SDL_Event *e){
+    int z = atomic_load(&v->zoom);
+
+    switch(e->type){
+        case SDL_KEYDOWN:
+            switch(e->key.keysym.sym){
+                case SDLK_LEFT:
+                    atomic_fetch_sub(&v->x, span(v->width / 8, z) + 1);
+                    break;
+                case SDLK_RIGHT:
+                    atomic_fetch_add(&v->x, span(v->width / 8, z) + 1);
+                    break;
+                case SDLK_UP:
+                    atomic_fetch_sub(&v->y, span(v->height / 8, z) + 1);
+                    break;
+                case SDLK_DOWN:
+                    atomic_fetch_add(&v->y, span(v->height / 8, z) + 1);
+                    break;
+                case SDLK_PLUS:
+                case SDLK_EQUALS:
+                    zoom_by(v, 1);
+                    break;
+                case SDLK_MINUS:
+                    zoom_by(v, -1);
+                    break;
+            }
+            break;
+        case SDL_MOUSEWHEEL:
+            if(e->wheel.y)
+                zoom_by(v, e->wheel.y > 0 ? 1 : -1);
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            v->drag = e->type == SDL_MOUSEBUTTONDOWN;
+            break;
+        case SDL_MOUSEMOTION:
+            if(v->drag && (e->motion.state & SDL_BUTTON_LMASK)){
+                atomic_fetch_sub(&v->x, span(e->motion.xrel, z));
+                atomic_fetch_sub(&v->y, span(e->motion.yrel, z));
+            }
+            break;
+    }
+}
+
+/** 
+ * @brief Sample value of a block of cells from the count of live cells in it. A block with any live cell is at
+ * least 1, so a lone pattern never drops out of view.
+ * @param live live cells in the block
+ * @param cells cells in the block
+ */
+static unsigned char shade_of(long live, long cells){
+    return live ? (live * 255 + cells - 1) / cells : 0;
+}
+
+/** 
+ * @brief Clip the span of a block, start to start + block - 1, to the board. Return 0 if none of it is on the board.
+ * @param start first row or collum of the block
+ * @param block rows or collums of the block
+ * @param size rows or collums of the board
+ * @param lo set to the first on the board
+ * @param hi set to one past the last on the board
+ */
+static int clip(long start, long block, long size, long *lo, long *hi){
+    *lo = start < 0 ? 0 : start;
+    *hi = start + block > size ? size : start + block;
+    return *lo < *hi;
+}
+
+/** 
+ * @brief Live cells of a packed row in collums c0 to c1 - 1, counted a word at a time.
+ * @param w words of the row
+ * @param c0 first collum
+ * @param c1 collum after the last, more than c0
+ */
+static long bits_in(const uint64_t *w, long c0, long c1){
+    long k = c0 / 64, end = (c1 - 1) / 64, live;
+    uint64_t first = ~(uint64_t)0 << (c0 % 64), last = ~(uint64_t)0 >> (63 - (c1 - 1) % 64);
+
+    if(k == end)
+        return __builtin_popcountll(w[k] & first & last);
+    live = __builtin_popcountll(w[k] & first) + __builtin_popcountll(w[end] & last);
+    for(k++; k < end; k++)
+        live += __builtin_popcountll(w[k]);
+    return live;
+}
+
+/** 
+ * @brief Live cells of a byte row in collums c0 to c1 - 1, counted eight at a time as the bits of a word.
+ * @param row the row
+ * @param c0 first collum
+ * @param c1 collum after the last, more than c0
+ */
+static long bytes_in(const unsigned char *row, long c0, long c1){
+    long live = 0;
+    uint64_t x;
+
+    for(; c0 + 8 <= c1; c0 += 8){
+        memcpy(&x, row + c0, 8);
+        live += __builtin_popcountll(x);
+    }
+    for(; c0 < c1; c0++)
+        live += row[c0];
+    return live;
+}
+
+/** 
+ * @brief Live cells of the part on the board of a block of 2^shift cells a side, shift at least 6, from its tiles.
+ * @details The block lines up on its size, so it is covered exactly by the tiles of the largest level no larger than
+ * it, at most four by four of them.
+ * @param s the census
+ * @param shift log2 of the side of the block
+ * @param r0 first row of the block on the board
+ * @param r1 row after the last on the board
+ * @param c0 first collum of the block on the board
+ * @param c1 collum after the last on the board
+ */
+static long census_block(const struct census_t *s, int shift, long r0, long r1, long c0, long c1){
+    int k = (shift - 6) / 3 < CENSUS_LEVELS - 1 ? (shift - 6) / 3 : CENSUS_LEVELS - 1, t = 6 + 3 * k;
+    long live = 0, i, j;
+
+    for(i = r0 >> t; i <= (r1 - 1) >> t; i++)
+        for(j = c0 >> t; j <= (c1 - 1) >> t; j++)
+            live += s->count[k][i * s->cols[k] + j];
+    return live;
+}
+
+/** 
+ * @brief Fill the dirty samples of a frame, set up by view_frame(), from a byte matrix. Cells off the board are dead.
+ * @details Zoomed out, each sample is the exact density of its block: the sum of the tiles of the census of g
+ * that cover it once blocks are 64 cells a side, otherwise the cells of the block on the board counted eight at a
+ * time. So a sample costs at most 16 counts or 128 words, whatever the zoom. Only the dirty samples are counted.
+ * @param f the frame
+ * @param g the matrix
+ */
+void frame_from_grid(struct frame_t *f, struct grid_t *g){
+    int shift = f->zoom >= 0 ? 0 : -f->zoom, i, j;
+    long block = 1L << shift, live, r, r0, r1, c0, c1;
+
+    for(i = 0; i < f->w; i++)
+        for(j = 0; j < f->h && (f->full || f->dirty[i]); j++){
+            live = 0;
+            if(clip(f->x + i * block, block, g->m_row, &r0, &r1) && clip(f->y + j * block, block, g->n_col, &c0, &c1)){
+                if(g->census && shift >= 6)
+                    live = census_block(g->census, shift, r0, r1, c0, c1);
+                else
+                    for(r = r0; r < r1; r++)
+                        live += bytes_in(g->row[r], c0, c1);
+            }
+            f->cells->row[i][j] = shade_of(live, block * block);
+        }
+}
+
+/** 
+ * @brief Fill the dirty samples of a frame, set up by view_frame(), from a bit matrix. Cells off the board are dead.
+ * @details Counted the same way as frame_from_grid(), a popcount of each word of the block below 64 cells a side
+ * or when there is no census.
+ * @param f the frame
+ * @param b the matrix
+ */
+void frame_from_bits(struct frame_t *f, struct bitgrid_t *b){
+    int shift = f->zoom >= 0 ? 0 : -f->zoom, i, j;
+    long block = 1L << shift, live, r, r0, r1, c0, c1;
+
+    for(i = 0; i < f->w; i++)
+        for(j = 0; j < f->h && (f->full || f->dirty[i]); j++){
+            live = 0;
+            if(clip(f->x + i * block, block, b->m_row, &r0, &r1) && clip(f->y + j * block, block, b->n_col, &c0, &c1)){
+                if(b->census && shift >= 6)
+                    live = census_block(b->census, shift, r0, r1, c0, c1);
+                else
+                    for(r = r0; r < r1; r++)
+                        live += bits_in(b->word + r * b->words, c0, c1);
+            }
+            f->cells->row[i][j] = shade_of(live, block * block);
+        }
+}
@@ -0,0 +1,56 @@
+/**
+ * @file render.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the viewport renderer
+ */
+#ifndef RENDER_H_
+#define RENDER_H_
+
+#include <stdatomic.h>
+#include "SDL2/SDL.h"
+
+struct grid_t;
+struct bitgrid_t;
+struct frame_t;
+
+/** Smallest zoom, 2^16 by 2^16 cells to a pixel. */
+#define ZOOM_MIN -16
+
+/** Largest zoom, 16 pixels to a cell. */
+#define ZOOM_MAX 4
+
+/**
+ * Part of the board in the window. The renderer moves it and the simulation reads it when filling a frame.
+ * x and y are the board row and collum at the top left of the window. 2^zoom pixels to a cell when zoom >= 0,
+ * otherwise 2^-zoom cells to a pixel.
+ */
+struct view_t {
+        atomic_long x;
+        atomic_long y;
+        atomic_int zoom;
+        int width;			/* window size in pixels */
+        int height;
+        int drag;			/* left button held */
+};
+
+/** Window and the streaming texture the frames are drawn into. */
+struct render_t {
+        SDL_Window *window;
+        SDL_Renderer *renderer;
+        SDL_Texture *texture;
+        int width;
+        int height;
+        Uint32 shade[256];		/* pixel color of each sample value */
+};
+
+int render_init(struct render_t *r, int width, int height, unsigned char red, unsigned char green, unsigned char blue);
+void render_quit(struct render_t *r);
+void render_frame(struct render_t *r, struct frame_t *f);
+void view_init(struct view_t *v, int width, int height, int zoom);
+void view_frame(struct view_t *v, struct frame_t *f);
+void view_event(struct view_t *v, SDL_Event *e);
+void frame_from_grid(struct frame_t *f, struct grid_t *g);
+void frame_from_bits(struct frame_t *f, struct bitgrid_t *b);
+
+#endif
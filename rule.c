@@ -0,0 +1,96 @@
+/**
+ * @file rule.c
+ * @brief B/S rules of life like cellular automata
+ * @details
+ * A rule names the neighbour counts a dead cell is born with and a live cell
+ * survives with, as in B3/S23 for convey's game of life. The rule is read once
+ * and every engine picks its kernels for it before the run, so no cell looks
+ * at the rule string. Rules of RULE_LIST have kernels specialised at build
+ * time; any other rule runs on kernels reading the next[][] table.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include "rule.h"
+#include "kernel.h"
+
+struct rule_t rule = {
+    1u << 3, 1u << 2 | 1u << 3, RULE_LIFE,
+    { { 0, 0, 0, 1, 0, 0, 0, 0, 0 }, { 0, 0, 1, 1, 0, 0, 0, 0, 0 } },
+    "B3/S23"
+};
+
+/** Birth and survive masks of the rules of RULE_LIST, by id. */
+#define RULE_MASKS(id, name, birth, survive) { birth, survive },
+static const unsigned masks[RULE_ANY][2] = { RULE_LIST(RULE_MASKS) };
+#undef RULE_MASKS
+
+/**
+ * @brief Read a rule as B then S digits, or S then B, split by a /, as in B36/S23 or S23/B36. Letters may be lower case.
+ * @param s the rule string
+ * @param r set to the rule
+ * @return 0 if the rule was read, -1 if it is not a B/S rule
+ */
+int rule_parse(const char *s, struct rule_t *r){
+    unsigned mask[2] = { 0, 0 }, seen = 0;
+    int part, i, k;
+    char *name;
+
+    for(part = 0; part < 2; part++){
+        if(part && *s++ != '/')
+            return -1;
+        if(*s == 'B' || *s == 'b')
+            i = 0;
+        else if(*s == 'S' || *s == 's')
+            i = 1;
+        else
+            return -1;
+        if(seen >> i & 1)
+            return -1;
+        seen |= 1u << i;
+        for(s++; *s >= '0' && *s <= '8'; s++)
+            mask[i] |= 1u << (*s - '0');
+    }
+    if(*s)
+        return -1;
+
+    r->birth = mask[0];
+    r->survive = mask[1];
+    for(k = 0; k <= 8; k++){
+        r->next[0][k] = r->birth >> k & 1;
+        r->next[1][k] = r->survive >> k & 1;
+    }
+    for(r->id = 0; r->id < RULE_ANY; r->id++)
+        if(masks[r->id][0] == r->birth && masks[r->id][1] == r->survive)
+            break;
+    /* written back in B/S order with the counts sorted, so equal rules have equal names */
+    name = r->name;
+    *name++ = 'B';
+    for(k = 0; k <= 8; k++)
+        if(r->birth >> k & 1)
+            *name++ = '0' + k;
+    *name++ = '/';
+    *name++ = 'S';
+    for(k = 0; k <= 8; k++)
+        if(r->survive >> k & 1)
+            *name++ = '0' + k;
+    *name = 0;
+    return 0;
+}
+
+/**
+ * @brief Set the rule every engine runs, and build the kernel tables for it.
+ * @param s the rule string
+ * @return 0 if the rule was set, -1 if it is not a B/S rule
+ */
+int rule_set(const char *s){
+    struct rule_t r;
+
+    if(rule_parse(s, &r))
+        return -1;
+    rule = r;
+    kernel_rule();
+    return 0;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file rule.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the B/S rules of life like cellular automata
+ */
+#ifndef RULE_H_
+#define RULE_H_
+
+/** Bytes kept of a rule string, its 0 included, the size of the rule in a snapshot. */
+#define RULE_NAME 32
+
+/**
+ * Rules with kernels of their own, specialised at build time: X(id, name, birth, survive).
+ * Bit k of birth and survive is set for k live neighbours. Every other rule runs on the table driven kernels.
+ */
+#define RULE_LIST(X) \
+        X(LIFE, "B3/S23", 1u << 3, 1u << 2 | 1u << 3) \
+        X(HIGHLIFE, "B36/S23", 1u << 3 | 1u << 6, 1u << 2 | 1u << 3) \
+        X(SEEDS, "B2/S", 1u << 2, 0u) \
+        X(DAYNIGHT, "B3678/S34678", 1u << 3 | 1u << 6 | 1u << 7 | 1u << 8, 1u << 3 | 1u << 4 | 1u << 6 | 1u << 7 | 1u << 8)
+
+#define RULE_ID(id, name, birth, survive) RULE_##id,
+/** Index of a rule of RULE_LIST, then RULE_ANY for any other rule. */
+enum rule_id { RULE_LIST(RULE_ID) RULE_ANY };
+#undef RULE_ID
+
+/** A B/S rule. */
+struct rule_t {
+        unsigned birth;			/* bit k set if a dead cell with k live neighbours is born */
+        unsigned survive;		/* bit k set if a live cell with k live neighbours stays alive */
+        enum rule_id id;		/* kernels the engines run the rule on */
+        unsigned char next[2][9];	/* next[alive][k], the next state of a cell with k live neighbours */
+        char name[RULE_NAME];		/* the rule as B/S */
+};
+
+/** Rule every engine runs. B3/S23 until rule_set() is called. */
+extern struct rule_t rule;
+
+int rule_parse(const char *s, struct rule_t *r);
+int rule_set(const char *s);
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * @file snap.c
+ * @brief Binary snapshots of the board for convey's game of life
+ * @details 
+ * A snapshot is a 64 byte header with the size, edge, generation and rule of the board, then the board one bit per
+ * cell. Snapshots are written to a temporary file that is renamed over the old one once it is on disk, so a crash
+ * while checkpointing leaves the last snapshot whole. Restoring maps the file and reads the live cells as runs
+ * straight from the mapping.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "life.h"
+#include "bitlife.h"
+#include "snap.h"
+
+_Static_assert(sizeof(struct snap_head_t) == 64, "snapshot header must be 64 bytes");
+
+/** 
+ * @brief Write a snapshot from either matrix, replacing the file only once the new one is complete. A byte matrix is
+ * packed into bits first.
+ * @param path snapshot file
+ * @param g byte matrix to save, or NULL
+ * @param b packed matrix to save if g is NULL
+ * @param type type of edge - hedge, torus, klein
+ * @param generation generations run to reach the board
+ * @return 0 if the snapshot was written, otherwise -1
+ */
+static int save(const char *path, struct grid_t *g, struct bitgrid_t *b, char type, long generation){
+    struct snap_head_t head = { SNAP_MAGIC, 0 };
+    char *tmp = malloc(strlen(path) + 5);
+    struct bitgrid_t *packed = NULL;
+    FILE *fp;
+    int r, ok;
+
+    head.m_row = g ? g->m_row : b->m_row;
+    head.n_col = g ? g->n_col : b->n_col;
+    head.words = (head.n_col + 63) / 64;
+    head.edge = type;
+    head.generation = generation;
+    strcpy(head.rule, rule.name);
+
+    if(g){
+        if((packed = init_bitgrid(g->m_row, g->n_col)))
+            bit_from_grid(packed, g);
+        b = packed;
+    }
+    if(!tmp || !b){
+        free(tmp);
+        if(packed)
+            free_bitgrid(packed);
+        return -1;
+    }
+    sprintf(tmp, "%s.tmp", path);
+    if(!(fp = fopen(tmp, "wb"))){
+        free(tmp);
+        if(packed)
+            free_bitgrid(packed);
+        return -1;
+    }
+
+    ok = fwrite(&head, sizeof(head), 1, fp) == 1;
+    for(r = 0; ok && r < (int)head.m_row; r++)
+        ok = fwrite(b->word + (size_t)r * b->words, sizeof(uint64_t), head.words, fp) == head.words;
+    ok = ok && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    ok = fclose(fp) == 0 && ok;
+    ok = ok && rename(tmp, path) == 0;
+    if(!ok)
+        remove(tmp);
+
+    free(tmp);
+    if(packed)
+        free_bitgrid(packed);
+    return ok ? 0 : -1;
+}
+
+/** 
+ * @brief Write a snapshot of the byte matrix.
+ * @param path snapshot file
+ * @param g matrix to save
+ * @param type type of edge - hedge, torus, klein
+ * @param generation generations run to reach the board
+ * @return 0 if the snapshot was written, otherwise -1
+ */
+int snap_save(const char *path, struct grid_t *g, char type, long generation){
+    return save(path, g, NULL, type, generation);
+}
+
+/** 
+ * @brief Write a snapshot of the packed matrix. Its words are already the layout of the file.
+ * @param path snapshot file
+ * @param b matrix to save
+ * @param type type of edge - hedge, torus, klein
+ * @param generation generations run to reach the board
+ * @return 0 if the snapshot was written, otherwise -1
+ */
+int snap_save_bits(const char *path, struct bitgrid_t *b, char type, long generation){
+    return save(path, NULL, b, type, generation);
+}
+
+/** 
+ * @brief Map a snapshot and check its header. Return the snapshot or NULL if it could not be mapped or is not valid.
+ * @param path snapshot file
+ */
+struct snap_t *snap_open(const char *path){
+    struct snap_t *s = malloc(sizeof(struct snap_t));
+    const struct snap_head_t *h;
+    struct rule_t r;
+    struct stat st;
+    void *map;
+    int fd;
+
+    if(!s)
+        return NULL;
+    if((fd = open(path, O_RDONLY)) < 0){
+        free(s);
+        return NULL;
+    }
+    if(fstat(fd, &st) || (size_t)st.st_size < sizeof(struct snap_head_t)
+       || (map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+        close(fd);
+        free(s);
+        return NULL;
+    }
+    close(fd);
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    s->head = h = map;
+    s->word = (const uint64_t *)(h + 1);
+    s->size = st.st_size;
+    if(memcmp(h->magic, SNAP_MAGIC, 8) || h->m_row < 3 || h->n_col < 3 || h->m_row > 0x7fffffff || h->n_col > 0x7fffffff
+       || h->words != (h->n_col + 63) / 64 || s->size != sizeof(struct snap_head_t) + (size_t)h->m_row * h->words * sizeof(uint64_t)
+       || (h->edge != 'h' && h->edge != 't' && h->edge != 'k') || !memchr(h->rule, 0, sizeof(h->rule)) || rule_parse(h->rule, &r)){
+        snap_close(s);
+        return NULL;
+    }
+    return s;
+}
+
+/** 
+ * @brief Unmap a snapshot.
+ * @param s the snapshot
+ */
+void snap_close(struct snap_t *s){
+    munmap((void *)s->head, s->size);
+    free(s);
+}
+
+/** 
+ * @brief Read the live cells of a snapshot as runs along each row, the way pattern_read() reads a pattern.
+ * @details Cell (r, c) is passed as x = c, y = r. Words with no live cells are skipped whole.
+ * @param s the snapshot
+ * @param cell called with ctx and each run of live cells
+ * @param ctx passed to cell
+ * @return number of live cells
+ */
+long snap_read(struct snap_t *s, cell_fn cell, void *ctx){
+    const uint64_t *w;
+    uint64_t bits;
+    long cells = 0;
+    int r, c, start, n_col = s->head->n_col;
+
+    for(r = 0; r < (int)s->head->m_row; r++){
+        w = s->word + (size_t)r * s->head->words;
+        c = 0;
+        while(c < n_col){
+            bits = w[c >> 6] >> (c & 63);
+            if(!bits){
+                c = (c | 63) + 1;
+                continue;
+            }
+            start = c += __builtin_ctzll(bits);
+            if(start >= n_col)
+                break;
+            while(c < n_col){
+                bits = ~w[c >> 6] >> (c & 63);
+                if(!bits){
+                    c = (c | 63) + 1;
+                    continue;
+                }
+                c += __builtin_ctzll(bits);
+                break;
+            }
+            if(c > n_col)
+                c = n_col;
+            cell(ctx, start, r, c - start);
+            cells += c - start;
+        }
+    }
+    return cells;
+}
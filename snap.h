@@ -0,0 +1,48 @@
+/**
+ * @file snap.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for binary snapshots of the board, to checkpoint and restore long runs
+ */
+#ifndef SNAP_H_
+#define SNAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "life.h"
+#include "rule.h"
+
+struct bitgrid_t;
+
+/** First bytes of every snapshot file. */
+#define SNAP_MAGIC "GOLSNAP1"
+
+/**
+ * Header at the start of a snapshot, 64 bytes in the byte order of the host.
+ * The m_row * words 64 bit words of the board follow it, cell (r, c) being bit c % 64 of word[r * words + c / 64].
+ */
+struct snap_head_t {
+        char magic[8];		/* SNAP_MAGIC */
+        uint32_t m_row;
+        uint32_t n_col;
+        uint32_t words;		/* words per row, (n_col + 63) / 64 */
+        char edge;		/* type of edge - hedge, torus, klein */
+        char pad[3];
+        int64_t generation;	/* generations run to reach this board */
+        char rule[RULE_NAME];	/* rule the board was run under as B/S, 0 terminated */
+};
+
+/** A snapshot file mapped into memory. */
+struct snap_t {
+        const struct snap_head_t *head;
+        const uint64_t *word;	/* the board, right after the header */
+        size_t size;		/* bytes mapped */
+};
+
+int snap_save(const char *path, struct grid_t *g, char type, long generation);
+int snap_save_bits(const char *path, struct bitgrid_t *b, char type, long generation);
+struct snap_t *snap_open(const char *path);
+void snap_close(struct snap_t *s);
+long snap_read(struct snap_t *s, cell_fn cell, void *ctx);
+
+#endif
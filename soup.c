@@ -0,0 +1,202 @@
+/**
+ * @file soup.c
+ * @brief Runs many random soups of convey's game of life to see how they end
+ * @details 
+ * Every soup is a board filled at random from its seed, each cell alive with even odds. A soup runs on the bit
+ * packed engine until the board repeats or the generation limit is reached, and its final population, the
+ * generation it settled at and its period are kept. Threads claim seeds in chunks and each steps its soups one at
+ * a time in its own pair of bit matrices, small enough to stay in the cache of its core. Boards of up to 64
+ * collums and SOUP_ROWS rows, the usual soup, are stepped a whole row to a word.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "life.h"
+#include "bitlife.h"
+#include "cycle.h"
+#include "rule.h"
+#include "soup.h"
+
+/** 
+ * @brief Next number of a splitmix64 sequence.
+ * @param state state of the sequence, advanced
+ */
+static uint64_t next_random(uint64_t *state){
+    return hash_key((*state)++);
+}
+
+/** 
+ * @brief Fill the matrix with the soup of a seed, each cell alive with even odds.
+ * @details The sequence starts at a mix of the seed, so neighbouring seeds do not share numbers.
+ * @param b the matrix
+ * @param seed seed of the soup
+ */
+static void soup_fill(struct bitgrid_t *b, uint64_t seed){
+    uint64_t state = hash_key(seed), last = (b->n_col % 64) ? ~(uint64_t)0 >> (64 - b->n_col % 64) : 0;
+    uint64_t *w;
+    int r, i;
+
+    for(r = 0; r < b->m_row; r++){
+        w = b->word + (long)r * b->words;
+        for(i = 0; i < b->words; i++)
+            w[i] = next_random(&state);
+        w[b->n_col / 64] &= last;
+    }
+}
+
+/** 
+ * @brief Advance a bit matrix of at most 64 collums and SOUP_ROWS rows one generation of B3/S23, each row being its first word.
+ * @details The neighbours to the west and east of every row are found once with their ghost cells, which are
+ * from the same row for torus and the flipped row for klein, then the eight neighbours of all cells of a row are
+ * summed at once with bitwise adders. The rows past the top and bottom are dead for hedge and wrap otherwise.
+ * A row of at most 64 cells is its own exact row hash, so each new row is also written to the row hashes.
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param hash row hashes, each set to its row of f, and the board hash kept with them
+ */
+static void narrow_step(struct bitgrid_t *p, struct bitgrid_t *f, char type, struct rowhash_t *hash){
+    int r, m = p->m_row, n = p->n_col, words = p->words;
+    uint64_t mask = n == 64 ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1;
+    uint64_t west[SOUP_ROWS + 2], east[SOUP_ROWS + 2], cur[SOUP_ROWS + 2], *w = west + 1, *e = east + 1, *c = cur + 1;
+    uint64_t s0, c0, s1, c1, s2, c2, x, k, t, two, out, src;
+
+    for(r = 0; r < m; r++){
+        c[r] = p->word[(long)r * words];
+        src = type == 'k' ? p->word[(long)(m - 1 - r) * words] : c[r];
+        w[r] = c[r] << 1 & mask;
+        e[r] = c[r] >> 1;
+        if(type != 'h'){
+            w[r] |= src >> (n - 1) & 1;
+            e[r] |= (src & 1) << (n - 1);
+        }
+    }
+    if(type == 'h'){
+        w[-1] = e[-1] = c[-1] = w[m] = e[m] = c[m] = 0;
+    }
+    else{
+        w[-1] = w[m - 1], e[-1] = e[m - 1], c[-1] = c[m - 1];
+        w[m] = w[0], e[m] = e[0], c[m] = c[0];
+    }
+
+    for(r = 0; r < m; r++){
+        /* ones and twos of the row above, the west and east of the row, and the row below */
+        s0 = w[r - 1] ^ c[r - 1] ^ e[r - 1];
+        c0 = (w[r - 1] & c[r - 1]) | (e[r - 1] & (w[r - 1] ^ c[r - 1]));
+        s1 = w[r] ^ e[r];
+        c1 = w[r] & e[r];
+        s2 = w[r + 1] ^ c[r + 1] ^ e[r + 1];
+        c2 = (w[r + 1] & c[r + 1]) | (e[r + 1] & (w[r + 1] ^ c[r + 1]));
+        x = s0 ^ s1 ^ s2;
+        k = (s0 & s1) | (s2 & (s0 ^ s1));
+        /* alive with exactly one two among c0, c1, c2 and k: 3 neighbours, or 2 and alive */
+        t = c0 ^ c1 ^ c2 ^ k;
+        two = (c0 & c1) | (c2 & k) | ((c0 ^ c1) & (c2 ^ k));
+        out = t & ~two & (x | c[r]);
+
+        if(hash->row[r] != out)
+            hash->board ^= row_mix(hash->row[r], r) ^ row_mix(out, r);
+        f->word[(long)r * words] = hash->row[r] = out;
+    }
+}
+
+/** 
+ * @brief Run one soup until it repeats or reaches the generation limit.
+ * @param b the batch
+ * @param p present matrix, swapped with f as the soup steps
+ * @param f future matrix
+ * @param c hashes shared by both matrices
+ * @param out the result of the soup, its seed already set
+ */
+static void soup_run(struct batch_t *b, struct bitgrid_t **p, struct bitgrid_t **f, struct cycle_t *c, struct soup_t *out){
+    struct bitgrid_t *tmp;
+    long g, period = 0, population = 0;
+    int i, narrow = b->n_col <= 64 && b->m_row <= SOUP_ROWS && rule.id == RULE_LIFE;
+
+    soup_fill(*p, out->seed);
+    if(narrow){
+        for(i = 0; i < (*p)->m_row; i++)
+            c->hash.row[i] = (*p)->word[(long)i * (*p)->words];
+        cycle_rows(c);
+    }
+    else
+        cycle_bits(c, *p);
+    cycle_check(c, 0);
+    for(g = 1; g <= b->gens && !period; g++){
+        if(narrow)
+            narrow_step(*p, *f, b->type, &c->hash);
+        else
+            bit_step(*p, *f, b->type);
+        tmp = *p;
+        *p = *f;
+        *f = tmp;
+        period = cycle_check(c, g);
+    }
+    g--;
+
+    for(i = 0; i < (*p)->m_row * (*p)->words; i++)
+        population += __builtin_popcountll((*p)->word[i]);
+    out->population = population;
+    out->period = period;
+    out->settled = period ? g - period : -1;
+}
+
+/** 
+ * @brief Body of the search threads. Claim chunks of seeds and run them until none are left.
+ * @param arg the batch
+ */
+static void *soup_thread(void *arg){
+    struct batch_t *b = arg;
+    struct bitgrid_t *p = init_bitgrid(b->m_row, b->n_col), *f = init_bitgrid(b->m_row, b->n_col);
+    struct cycle_t *c = init_cycle(b->m_row, b->n_col);
+    long i, start;
+
+    /* a thread that could not allocate claims no seeds and leaves them to the others */
+    if( p && f && c ){
+        /* narrow boards keep their row hashes themselves */
+        if(b->n_col > 64 || b->m_row > SOUP_ROWS || rule.id != RULE_LIFE)
+            p->hash = f->hash = &c->hash;
+        while((start = atomic_fetch_add(&b->next, SOUP_CHUNK)) < b->count)
+            for(i = start; i < start + SOUP_CHUNK && i < b->count; i++){
+                b->result[i].seed = b->first + i;
+                soup_run(b, &p, &f, c, &b->result[i]);
+            }
+    }
+    if(p)
+        free_bitgrid(p);
+    if(f)
+        free_bitgrid(f);
+    if(c)
+        free_cycle(c);
+    return NULL;
+}
+
+/** 
+ * @brief Run every soup of the batch on its threads and fill in the results.
+ * @param b the batch, with result room for count soups
+ * @return 0 if every soup ran, otherwise -1 as no thread could allocate its boards
+ */
+int soup_batch(struct batch_t *b){
+    pthread_t *tid = malloc(b->threads * sizeof(pthread_t));
+    int t, started;
+
+    if(!tid)
+        return -1;
+    atomic_store(&b->next, 0);
+    for(started = 0; started < b->threads; started++)
+        if(pthread_create(&tid[started], NULL, soup_thread, b))
+            break;
+    if(!started){
+        free(tid);
+        return -1;
+    }
+    for(t = 0; t < started; t++)
+        pthread_join(tid[t], NULL);
+    free(tid);
+    return atomic_load(&b->next) < b->count ? -1 : 0;
+}
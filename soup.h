@@ -0,0 +1,44 @@
+/**
+ * @file soup.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for searching many random soups at once
+ */
+#ifndef SOUP_H_
+#define SOUP_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/** Generations a soup runs for when no limit is given. */
+#define SOUP_GENS 10000
+
+/** Most rows of a board stepped a row to a word, when it has at most 64 collums. */
+#define SOUP_ROWS 256
+
+/** Seeds a thread takes at a time. */
+#define SOUP_CHUNK 64
+
+/** How one soup ended. */
+struct soup_t {
+        uint64_t seed;
+        long population;	/* live cells at the end */
+        long settled;		/* first generation of the cycle it settled into, or -1 */
+        long period;		/* period of the cycle, or 0 if none was found */
+};
+
+/** A range of soups searched across threads. Each thread claims SOUP_CHUNK seeds at a time from next. */
+struct batch_t {
+        int m_row, n_col;
+        char type;		/* type of edge - hedge, torus, klein */
+        long gens;		/* most generations a soup runs */
+        uint64_t first;		/* seed of the first soup */
+        long count;		/* number of soups */
+        int threads;
+        struct soup_t *result;	/* one per soup, in seed order */
+        atomic_long next;	/* index of the next soup to claim */
+};
+
+int soup_batch(struct batch_t *b);
+
+#endif
@@ -0,0 +1,294 @@
+/**
+ * @file sparse.c
+ * @brief Sparse engine for convey's game of life on an unbounded plane
+ * @details 
+ * Only the live cells are stored, in a hash table keyed by their coordinates,
+ * so memory and the cost of a generation follow the population rather than
+ * the area the pattern covers. Each generation every live cell adds one to
+ * the count of its eight neighbours in a second table, and the cells the rule
+ * gives life to with their count make up the next generation. Only cells next
+ * to a live cell are counted, so rules with B0 can not run on the plane.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs Coordinates wrap around past the range of an int.
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+#include "sparse.h"
+#include "rule.h"
+
+/** Slots of a new table. */
+#define MAP_START 1024
+
+/** 
+ * @brief Key of the cell at x, y.
+ * @param x x cordinate
+ * @param y y cordinate
+ */
+static uint64_t cell_key(int x, int y){
+    return (uint64_t)(uint32_t)x << 32 | (uint32_t)y;
+}
+
+/** 
+ * @brief Allocate the slots of a table, all free. Return 0 if sussesful or -1 if malloc failed.
+ * @param map the table
+ * @param cap number of slots, a power of two
+ */
+static int map_init(struct cellmap_t *map, size_t cap){
+    map->key = malloc(cap * sizeof(uint64_t));
+    map->val = calloc(cap, 1);
+    if(!map->key || !map->val){
+        free(map->key);
+        free(map->val);
+        return -1;
+    }
+    map->cap = cap;
+    map->used = 0;
+    return 0;
+}
+
+/** 
+ * @brief Free every slot of a table.
+ * @param map the table
+ */
+static void map_clear(struct cellmap_t *map){
+    memset(map->val, 0, map->cap);
+    map->used = 0;
+}
+
+/** 
+ * @brief Slot of key, taking a free slot for it if it is not in the table.
+ * @details The caller must make val nonzero when a free slot is returned.
+ * @param map the table
+ * @param key key of the cell
+ */
+static size_t map_slot(struct cellmap_t *map, uint64_t key){
+    size_t mask = map->cap - 1, i = (key * 0x9E3779B97F4A7C15ull) >> 20 & mask;
+
+    while(map->val[i] && map->key[i] != key)
+        i = (i + 1) & mask;
+    if(!map->val[i]){
+        map->key[i] = key;
+        map->used++;
+    }
+    return i;
+}
+
+/** 
+ * @brief Make sure another add keeps the table at most half full. Return 0 if sussesful or -1 if malloc failed.
+ * @param map the table
+ * @param adds number of keys that may be added
+ */
+static int map_reserve(struct cellmap_t *map, size_t adds){
+    struct cellmap_t old = *map;
+    size_t cap = map->cap, i, j;
+
+    while(2 * (map->used + adds) > cap)
+        cap *= 2;
+    if(cap == map->cap)
+        return 0;
+    if(map_init(map, cap)){
+        *map = old;
+        return -1;
+    }
+    for(i = 0; i < old.cap; i++)
+        if(old.val[i]){
+            j = map_slot(map, old.key[i]);
+            map->val[j] = old.val[i];
+        }
+    free(old.key);
+    free(old.val);
+    return 0;
+}
+
+/** 
+ * @brief Empty a table and size it for a number of keys: grown to be at most half full, or shrunk while they would
+ * fill less than an eighth of it, so a table does not keep the size of the largest generation. Return 0 if
+ * sussesful or -1 if malloc failed growing it, leaving the table as it was.
+ * @details A table that can not be shrunk for want of memory is only emptied.
+ * @param map the table
+ * @param keys number of keys that will be added
+ */
+static int map_fit(struct cellmap_t *map, size_t keys){
+    struct cellmap_t old = *map;
+    size_t cap = map->cap;
+
+    while(2 * keys > cap)
+        cap *= 2;
+    while(cap > MAP_START && 8 * keys < cap)
+        cap /= 2;
+    if(cap == map->cap || map_init(map, cap)){
+        *map = old;
+        if(cap > old.cap)
+            return -1;
+        map_clear(map);
+        return 0;
+    }
+    free(old.key);
+    free(old.val);
+    return 0;
+}
+
+/** 
+ * @brief Creates an empty plane. Return adress of the plane is sussesful or NULL if malloc failed.
+ */
+struct sparse_t *init_sparse(void){
+    struct sparse_t *s = malloc(sizeof(struct sparse_t));
+
+    if(!s)
+        return NULL;
+    if(map_init(&s->live, MAP_START)){
+        free(s);
+        return NULL;
+    }
+    if(map_init(&s->work, MAP_START)){
+        free(s->live.key);
+        free(s->live.val);
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+/** 
+ * @brief Frees the plane.
+ * @param s the plane
+ */
+void free_sparse(struct sparse_t *s){
+    free(s->live.key);
+    free(s->live.val);
+    free(s->work.key);
+    free(s->work.val);
+    free(s);
+}
+
+/** 
+ * @brief Set the cell at x, y alive. Return 0 if sussesful or -1 if malloc failed.
+ * @param s the plane
+ * @param x x cordinate
+ * @param y y cordinate
+ */
+int sparse_add(struct sparse_t *s, int x, int y){
+    if(map_reserve(&s->live, 1))
+        return -1;
+    s->live.val[map_slot(&s->live, cell_key(x, y))] = 1;
+    return 0;
+}
+
+/** 
+ * @brief Set a run of cells from pattern_read() alive.
+ * @param ctx the plane
+ * @param x x cordinate of the first cell
+ * @param y y cordinate
+ * @param n number of cells
+ */
+void sparse_cell(void *ctx, int x, int y, int n){
+    int i;
+
+    for(i = 0; i < n; i++)
+        if(sparse_add(ctx, x + i, y)){
+            printf("Sparse plane allocation has failed.\n");
+            exit(EXIT_FAILURE);
+        }
+}
+
+/** 
+ * @brief Advance the plane one generation. Return 0 if sussesful or -1 if malloc failed, leaving the plane as it was.
+ * @details The work table holds the neighbour count of a cell shifted up one bit, and bit 0 set if the cell is alive.
+ * @param s the plane
+ */
+int sparse_step(struct sparse_t *s){
+    struct cellmap_t *live = &s->live, *work = &s->work;
+    size_t i, j, next = 0;
+    int x, y, dx, dy;
+
+    /* each live cell counts itself and its eight neighbours */
+    if(map_fit(work, 9 * live->used))
+        return -1;
+    for(i = 0; i < live->cap; i++){
+        if(!live->val[i])
+            continue;
+        x = (int)(live->key[i] >> 32);
+        y = (int)(uint32_t)live->key[i];
+        for(dx = -1; dx <= 1; dx++)
+            for(dy = -1; dy <= 1; dy++){
+                j = map_slot(work, cell_key(x + dx, y + dy));
+                work->val[j] += dx || dy ? 2 : 1;
+            }
+    }
+
+    for(i = 0; i < work->cap; i++)
+        next += rule.next[work->val[i] & 1][work->val[i] >> 1];
+    if(map_fit(live, next))
+        return -1;
+    for(i = 0; i < work->cap; i++)
+        if(rule.next[work->val[i] & 1][work->val[i] >> 1])
+            live->val[map_slot(live, work->key[i])] = 1;
+    return 0;
+}
+
+/** 
+ * @brief Copy the cells of the plane in the region of the matrix starting at x0, y0 into the matrix.
+ * @param g the matrix, row y - y0 and collum x - x0 for the cell at x, y
+ * @param s the plane
+ * @param x0 x cordinate of the first collum
+ * @param y0 y cordinate of the first row
+ */
+void sparse_to_grid(struct grid_t *g, struct sparse_t *s, int x0, int y0){
+    size_t i;
+    long x, y;
+    int r;
+
+    for(r = 0; r < g->m_row; r++)
+        memset(g->row[r], 0, g->n_col);
+    for(i = 0; i < s->live.cap; i++){
+        if(!s->live.val[i])
+            continue;
+        x = (long)(int)(s->live.key[i] >> 32) - x0;
+        y = (long)(int)(uint32_t)s->live.key[i] - y0;
+        if(x >= 0 && x < g->n_col && y >= 0 && y < g->m_row)
+            g->row[y][x] = 1;
+    }
+}
+
+/** 
+ * @brief Fill samples of 2^shift by 2^shift cells with the density, 0 to 255, of the plane under them.
+ * @details Cost follows the population, not the area. A sample with any live cell is at least 1.
+ * @param g samples, row y and collum x for the sample of the cell at x, y
+ * @param s the plane
+ * @param rows samples to fill down g
+ * @param cols samples to fill across g
+ * @param x0 x cordinate of the first sample
+ * @param y0 y cordinate of the first sample
+ * @param shift a sample is 2^shift cells square
+ * @return 0 if sussesful or -1 if malloc failed
+ */
+int sparse_density(struct grid_t *g, struct sparse_t *s, int rows, int cols, long x0, long y0, int shift){
+    uint32_t *count = calloc((size_t)rows * cols, sizeof(uint32_t)), v;
+    size_t i;
+    long x, y;
+    int r, c;
+
+    if(!count)
+        return -1;
+    for(i = 0; i < s->live.cap; i++){
+        if(!s->live.val[i])
+            continue;
+        x = ((long)(int)(s->live.key[i] >> 32) - x0) >> shift;
+        y = ((long)(int)(uint32_t)s->live.key[i] - y0) >> shift;
+        if(x >= 0 && x < cols && y >= 0 && y < rows)
+            count[y * cols + x]++;
+    }
+    for(r = 0; r < rows; r++)
+        for(c = 0; c < cols; c++){
+            v = count[r * cols + c];
+            v = v ? (uint32_t)(((uint64_t)v * 255) >> (2 * shift)) : 0;
+            g->row[r][c] = count[r * cols + c] && !v ? 1 : v;
+        }
+    free(count);
+    return 0;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file sparse.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the sparse Conway Game of Life engine on an unbounded plane
+ */
+#ifndef SPARSE_H_
+#define SPARSE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct grid_t;
+
+/**
+ * Open addressing hash table keyed by cell coordinates. A slot with val 0 is free.
+ * cap is a power of two and the table is kept at most half full. Stepping shrinks a table its keys fill less
+ * than an eighth of.
+ */
+struct cellmap_t {
+        uint64_t *key;
+        unsigned char *val;
+        size_t cap;
+        size_t used;
+};
+
+/**
+ * Live cells of the plane, x and y anywhere in the range of an int.
+ * live holds the live cells with val 1. work counts the neighbours of every cell next to a live cell while stepping.
+ */
+struct sparse_t {
+        struct cellmap_t live;
+        struct cellmap_t work;
+};
+
+struct sparse_t *init_sparse(void);
+void free_sparse(struct sparse_t *s);
+int sparse_add(struct sparse_t *s, int x, int y);
+void sparse_cell(void *ctx, int x, int y, int n);
+int sparse_step(struct sparse_t *s);
+void sparse_to_grid(struct grid_t *g, struct sparse_t *s, int x0, int y0);
+int sparse_density(struct grid_t *g, struct sparse_t *s, int rows, int cols, long x0, long y0, int shift);
+
+#endif
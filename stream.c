@@ -0,0 +1,302 @@
+/**
+ * @file stream.c
+ * @brief Streams generations of convey's game of life to a file or pipe as binary frames
+ * @details
+ * Frames are queued in a ring of bytes by the simulation and written out by a thread of their own, so a slow disk
+ * or reader never holds up a step. The writer takes what is queued, up to STREAM_WRITE bytes, and hands it to
+ * writev() as one piece or two if it wraps the end of the ring, so many small deltas go out in one large write. A
+ * frame is encoded straight into the ring past head and only published once whole. If the ring fills before it is,
+ * the frame is left out and the next delta is taken against the last frame that went in, so the stream stays whole
+ * with a generation missing. Keyframes are written every interval frames for readers that start or seek partway in.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "life.h"
+#include "bitlife.h"
+#include "stream.h"
+
+_Static_assert(sizeof(struct stream_head_t) == 64, "stream header must be 64 bytes");
+_Static_assert(sizeof(struct stream_frame_t) == 16, "frame header must be 16 bytes");
+
+/**
+ * @brief Writer thread. Writes whatever is queued until the stream is closed and nothing is left.
+ * @details Up to STREAM_WRITE bytes go to each write, from one piece of the ring or two if it wraps. A write that
+ * fails marks the stream failed and the bytes queued are let go, so the simulation is never left with a full ring.
+ * SIGPIPE is blocked so a reader going away fails the write instead of ending the program.
+ * @param arg the stream
+ */
+static void *write_out(void *arg){
+    struct stream_t *s = arg;
+    struct iovec io[2];
+    size_t head, tail, at, n;
+    ssize_t done;
+    sigset_t pipe;
+
+    sigemptyset(&pipe);
+    sigaddset(&pipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe, NULL);
+
+    pthread_mutex_lock(&s->lock);
+    for(;;){
+        tail = atomic_load_explicit(&s->tail, memory_order_relaxed);
+        while((head = atomic_load_explicit(&s->head, memory_order_acquire)) == tail && !s->closing)
+            pthread_cond_wait(&s->more, &s->lock);
+        if(head == tail)
+            break;
+        pthread_mutex_unlock(&s->lock);
+
+        at = tail % s->size;
+        n = head - tail < STREAM_WRITE ? head - tail : STREAM_WRITE;
+        io[0].iov_base = s->ring + at;
+        io[0].iov_len = n < s->size - at ? n : s->size - at;
+        io[1].iov_base = s->ring;
+        io[1].iov_len = n - io[0].iov_len;
+        done = atomic_load(&s->failed) ? (ssize_t)n : writev(s->fd, io, io[1].iov_len ? 2 : 1);
+        if(done < 0 && errno != EINTR){
+            atomic_store(&s->failed, 1);
+            done = n;
+        }
+        if(done > 0)
+            atomic_store_explicit(&s->tail, tail + done, memory_order_release);
+
+        pthread_mutex_lock(&s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+/**
+ * @brief Copy bytes into the ring at position *pos, wrapping at its end, unless they pass limit.
+ * @param s the stream
+ * @param pos position in the ring, moved past the bytes
+ * @param limit first position that is not free
+ * @param src bytes to copy
+ * @param n number of bytes
+ * @return 0 if the bytes were copied, -1 if there is no room for them
+ */
+static int put(struct stream_t *s, size_t *pos, size_t limit, const void *src, size_t n){
+    size_t at = *pos % s->size, first = n < s->size - at ? n : s->size - at;
+
+    if(*pos + n > limit)
+        return -1;
+    memcpy(s->ring + at, src, first);
+    memcpy(s->ring, (const unsigned char *)src + first, n - first);
+    *pos += n;
+    return 0;
+}
+
+/**
+ * @brief Hand the bytes from head to pos to the writer.
+ * @param s the stream
+ * @param pos position after the last byte
+ */
+static void publish(struct stream_t *s, size_t pos){
+    s->bytes += pos - atomic_load_explicit(&s->head, memory_order_relaxed);
+    atomic_store_explicit(&s->head, pos, memory_order_release);
+    pthread_mutex_lock(&s->lock);
+    pthread_cond_signal(&s->more);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * @brief Free the stream and its buffers. The writer must not be running.
+ * @param s the stream
+ */
+static void free_stream(struct stream_t *s){
+    free(s->ring);
+    free(s->last);
+    free(s->next);
+    free(s->run);
+    if(s->bits)
+        free_bitgrid(s->bits);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->more);
+    free(s);
+}
+
+/**
+ * @brief Create or truncate the file, queue the header and start the writer. Return the stream is sussesful or NULL
+ * if the file could not be opened, malloc failed, the thread could not be started or a frame of the board could be
+ * too large for the 32 bit size of its header, errno then being EFBIG.
+ * @details The ring holds STREAM_QUEUE bytes, or two keyframes if that is more, so a keyframe always fits once the
+ * writer has caught up. A delta is at most a keyframe and a run header a row.
+ * @param path file or named pipe to write to
+ * @param m_row number of rows of the board
+ * @param n_col number of collums of the board
+ * @param type type of edge - hedge, torus, klein
+ * @param interval frames from one keyframe to the next, 1 or more
+ */
+struct stream_t *stream_open(const char *path, int m_row, int n_col, char type, int interval){
+    struct stream_t *s = calloc(1, sizeof(struct stream_t));
+    struct stream_head_t head = { STREAM_MAGIC, 0 };
+    size_t board, pos = 0;
+
+    if(!s)
+        return NULL;
+    s->m_row = m_row;
+    s->n_col = n_col;
+    s->words = (n_col + 63) / 64;
+    s->interval = interval;
+    s->since = -1;
+    board = (size_t)m_row * s->words * sizeof(uint64_t);
+    if(board + (size_t)m_row * 2 * sizeof(uint32_t) > UINT32_MAX){
+        free(s);
+        errno = EFBIG;
+        return NULL;
+    }
+    s->size = 2 * (board + sizeof(struct stream_frame_t)) + sizeof(head);
+    if(s->size < STREAM_QUEUE)
+        s->size = STREAM_QUEUE;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->more, NULL);
+    s->ring = malloc(s->size);
+    s->last = calloc(board, 1);
+    s->next = malloc(board);
+    s->run = malloc(s->words * sizeof(uint64_t));
+    s->bits = init_bitgrid(m_row, n_col);
+    if(!s->ring || !s->last || !s->next || !s->run || !s->bits){
+        free_stream(s);
+        return NULL;
+    }
+    if((s->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0){
+        free_stream(s);
+        return NULL;
+    }
+
+    head.m_row = m_row;
+    head.n_col = n_col;
+    head.words = s->words;
+    head.interval = interval;
+    head.edge = type;
+    strcpy(head.rule, rule.name);
+    put(s, &pos, s->size, &head, sizeof(head));
+    publish(s, pos);
+
+    if(pthread_create(&s->writer, NULL, write_out, s)){
+        close(s->fd);
+        free_stream(s);
+        return NULL;
+    }
+    return s;
+}
+
+/**
+ * @brief Queue a frame of either matrix, a keyframe or the changes since the last frame.
+ * @details A byte matrix is packed into bits first. Each row is copied into next, compared to last and its changed
+ * words queued in runs. Runs end at the end of a row.
+ * @param s the stream
+ * @param g byte matrix, or NULL
+ * @param b packed matrix to read if g is NULL
+ * @param generation generation of the board
+ * @return 0 if the frame was queued or left out for want of room, -1 if the stream has failed
+ */
+static int frame(struct stream_t *s, struct grid_t *g, struct bitgrid_t *b, long generation){
+    struct stream_frame_t f = { 0 };
+    size_t start = atomic_load_explicit(&s->head, memory_order_relaxed), pos, limit, end = 0, word;
+    uint64_t *w, *l, *tmp;
+    uint32_t run[2];
+    int r, c, c0, key, ok = 1;
+
+    if(atomic_load(&s->failed))
+        return -1;
+    limit = atomic_load_explicit(&s->tail, memory_order_acquire) + s->size;
+    key = s->since < 0 || s->since >= s->interval;
+    pos = start + sizeof(f);
+    if(g){
+        bit_from_grid(s->bits, g);
+        b = s->bits;
+    }
+
+    for(r = 0; ok && r < s->m_row; r++){
+        w = s->next + (size_t)r * s->words;
+        l = s->last + (size_t)r * s->words;
+        memcpy(w, b->word + (size_t)r * b->words, s->words * sizeof(uint64_t));
+
+        if(key){
+            ok = !put(s, &pos, limit, w, s->words * sizeof(uint64_t));
+            continue;
+        }
+        for(c = 0; ok && c < s->words; ){
+            if(w[c] == l[c]){
+                c++;
+                continue;
+            }
+            for(c0 = c; c < s->words && w[c] != l[c]; c++)
+                s->run[c - c0] = w[c] ^ l[c];
+            word = (size_t)r * s->words + c0;
+            run[0] = word - end;
+            run[1] = c - c0;
+            end = word + run[1];
+            ok = !put(s, &pos, limit, run, sizeof(run)) && !put(s, &pos, limit, s->run, run[1] * sizeof(uint64_t));
+        }
+    }
+    if(!ok){
+        s->dropped++;
+        return 0;
+    }
+
+    f.kind = key ? STREAM_KEY : STREAM_DELTA;
+    f.size = pos - start - sizeof(f);
+    f.generation = generation;
+    put(s, &start, limit, &f, sizeof(f));
+    publish(s, pos);
+    tmp = s->last;
+    s->last = s->next;
+    s->next = tmp;
+    s->since = key ? 1 : s->since + 1;
+    s->frames++;
+    return 0;
+}
+
+/**
+ * @brief Queue a frame of a byte matrix.
+ * @param s the stream
+ * @param g the matrix
+ * @param generation generation of the board
+ * @return 0 if the frame was queued or left out for want of room, -1 if the stream has failed
+ */
+int stream_frame(struct stream_t *s, struct grid_t *g, long generation){
+    return frame(s, g, NULL, generation);
+}
+
+/**
+ * @brief Queue a frame of a packed matrix. Its rows are already the layout of the stream.
+ * @param s the stream
+ * @param b the matrix
+ * @param generation generation of the board
+ * @return 0 if the frame was queued or left out for want of room, -1 if the stream has failed
+ */
+int stream_frame_bits(struct stream_t *s, struct bitgrid_t *b, long generation){
+    return frame(s, NULL, b, generation);
+}
+
+/**
+ * @brief Wait for the writer to write everything queued, then close the file and free the stream.
+ * @param s the stream
+ * @return 0 if every write worked, otherwise -1
+ */
+int stream_close(struct stream_t *s){
+    int failed;
+
+    pthread_mutex_lock(&s->lock);
+    s->closing = 1;
+    pthread_cond_signal(&s->more);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->writer, NULL);
+
+    failed = atomic_load(&s->failed);
+    failed |= close(s->fd) != 0;
+    free_stream(s);
+    return failed ? -1 : 0;
+}
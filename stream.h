@@ -0,0 +1,93 @@
+/**
+ * @file stream.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for streaming generations to a file or pipe as binary frames
+ * @details
+ * A stream is a 64 byte struct stream_head_t then frames, all in the byte order of the host. Each frame is a
+ * struct stream_frame_t then size bytes. A keyframe holds the board one bit per cell, m_row * words 64 bit words,
+ * cell (r, c) being bit c % 64 of word[r * words + c / 64] as in a snapshot. A delta holds runs of changed words:
+ * a 32 bit count of unchanged words to skip, a 32 bit count of words n, then n words to XOR into the board. The
+ * first skip counts from word 0 and each next from the end of the run before. A delta is against the last frame
+ * in the stream, which is not always the generation before: frames the writer has no room for are left out.
+ */
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "rule.h"
+
+struct grid_t;
+struct bitgrid_t;
+
+/** First bytes of every stream. */
+#define STREAM_MAGIC "GOLSTRM1"
+
+/** Bytes the writer may hold before frames are left out, raised to fit two keyframes. */
+#define STREAM_QUEUE ((size_t)64 << 20)
+
+/** Bytes handed to one write at most, so room in the queue frees up as a slow reader catches up. */
+#define STREAM_WRITE ((size_t)4 << 20)
+
+/** Header at the start of a stream. */
+struct stream_head_t {
+        char magic[8];		/* STREAM_MAGIC */
+        uint32_t m_row;
+        uint32_t n_col;
+        uint32_t words;		/* words per row, (n_col + 63) / 64 */
+        uint32_t interval;	/* frames from one keyframe to the next */
+        char edge;		/* type of edge - hedge, torus, klein */
+        char pad[7];
+        char rule[RULE_NAME];	/* rule the board is run under as B/S, 0 terminated */
+};
+
+/** Kind of a frame. */
+enum stream_kind { STREAM_KEY = 'K', STREAM_DELTA = 'D' };
+
+/** Header of each frame. */
+struct stream_frame_t {
+        char kind;		/* enum stream_kind */
+        char pad[3];
+        uint32_t size;		/* bytes after this header */
+        int64_t generation;
+};
+
+/**
+ * Frames queued in a ring of bytes, written out by a thread of their own.
+ * The simulation adds at head and the writer takes from tail. Both only ever grow, the byte at position i being
+ * ring[i % size], so the bytes queued are head - tail. Frames that do not fit are left out rather than waited for.
+ */
+struct stream_t {
+        int fd;
+        int m_row;
+        int n_col;
+        int words;
+        int interval;
+        unsigned char *ring;
+        size_t size;
+        atomic_size_t head;
+        atomic_size_t tail;
+        atomic_int failed;		/* set by the writer if a write failed */
+        int closing;			/* set under lock when the last frame is queued */
+        pthread_mutex_t lock;
+        pthread_cond_t more;		/* signalled when head moves or closing is set */
+        pthread_t writer;
+        uint64_t *last;			/* board of the last frame queued */
+        uint64_t *next;			/* board of the frame being queued, swapped with last once it is */
+        uint64_t *run;			/* changed words of the run being queued */
+        struct bitgrid_t *bits;		/* byte matrix of the frame being queued, packed */
+        long since;			/* frames queued from the last keyframe on, itself included, -1 before the first */
+        long frames;			/* frames queued */
+        long dropped;			/* frames left out */
+        size_t bytes;			/* bytes queued, the header included */
+};
+
+struct stream_t *stream_open(const char *path, int m_row, int n_col, char type, int interval);
+int stream_frame(struct stream_t *s, struct grid_t *g, long generation);
+int stream_frame_bits(struct stream_t *s, struct bitgrid_t *b, long generation);
+int stream_close(struct stream_t *s);
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * @file tile.c
+ * @brief Active tile tracking for convey's game of life
+ * @details 
+ * The matrix is split into tiles. A tile is only updated when it or one of
+ * its neighbour tiles changed in the last generation, so boards that are
+ * mostly empty or settled cost little per generation. A tile that is skipped
+ * still holds the right cells in the future matrix: it did not change last
+ * generation, so the previous generation left in the future matrix equals
+ * the present one. Every tile is updated the first generation.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+#include "tile.h"
+
+/** 
+ * @brief Creates the tiles of a matrix, every tile active. Return adress of tiles is sussesful or NULL if malloc failed.
+ * @param m_row number of row in matrix
+ * @param n_col number of collum in matrix
+ */
+struct tiles_t *init_tiles(int m_row, int n_col){
+    struct tiles_t *t = malloc(sizeof(struct tiles_t));
+    int count;
+
+    if(!t)
+        return NULL;
+    t->m_row = m_row;
+    t->n_col = n_col;
+    t->t_row = (m_row + TILE_SIZE - 1) / TILE_SIZE;
+    t->t_col = (n_col + TILE_SIZE - 1) / TILE_SIZE;
+    count = t->t_row * t->t_col;
+    t->active = malloc(count * sizeof(int));
+    t->next = malloc(count * sizeof(int));
+    t->mark = calloc(count, 1);
+    if(!t->active || !t->next || !t->mark){
+        free_tiles(t);
+        return NULL;
+    }
+    t->n_next = 0;
+    t->updated = 0;
+    tiles_all(t);
+    return t;
+}
+
+/** 
+ * @brief Frees the tiles.
+ * @param t the tiles
+ */
+void free_tiles(struct tiles_t *t){
+    free(t->active);
+    free(t->next);
+    free(t->mark);
+    free(t);
+}
+
+/** 
+ * @brief Make every tile active, for when the matrix was changed outside of tile_step().
+ * @param t the tiles
+ */
+void tiles_all(struct tiles_t *t){
+    int i;
+
+    t->n_active = t->t_row * t->t_col;
+    for(i = 0; i < t->n_active; i++)
+        t->active[i] = i;
+}
+
+/** 
+ * @brief Add tile (i, j) to the tiles of the next generation once.
+ * @param t the tiles
+ * @param i row of the tile
+ * @param j collum of the tile
+ */
+static void mark(struct tiles_t *t, int i, int j){
+    int k = i * t->t_col + j;
+
+    if(!t->mark[k]){
+        t->mark[k] = 1;
+        t->next[t->n_next++] = k;
+    }
+}
+
+/** 
+ * @brief Add the tiles that read a cell of changed tile (i, j) to the next generation.
+ * @details Tiles past the top and bottom wrap for torus and klein, and are left out for hedge. Across the left
+ * and right edge klein reads row r of one side from row m_row - 1 - r of the other, so a change in rows r0 to
+ * r1 - 1 reaches rows m_row - 1 - r1 to m_row - r0 of the tiles on the other side.
+ * @param t the tiles
+ * @param type type of edge - hedge, torus, klein
+ * @param i row of the tile
+ * @param j collum of the tile
+ */
+static void mark_around(struct tiles_t *t, char type, int i, int j){
+    int di, dj, ti, tj, r, r1, m = t->m_row;
+
+    for(dj = -1; dj <= 1; dj++){
+        tj = j + dj;
+        if(tj < 0 || tj >= t->t_col){
+            if(type == 'h')
+                continue;
+            tj = (tj + t->t_col) % t->t_col;
+            if(type == 'k'){
+                r1 = (i + 1) * TILE_SIZE < m ? (i + 1) * TILE_SIZE : m;
+                for(r = m - 1 - r1; r <= m - i * TILE_SIZE; r++)
+                    mark(t, ((r + m) % m) / TILE_SIZE, tj);
+                continue;
+            }
+        }
+        for(di = -1; di <= 1; di++){
+            ti = i + di;
+            if(ti < 0 || ti >= t->t_row){
+                if(type == 'h')
+                    continue;
+                ti = (ti + t->t_row) % t->t_row;
+            }
+            mark(t, ti, tj);
+        }
+    }
+}
+
+/** 
+ * @brief Update the active tiles from p into f and work out the tiles active next generation.
+ * @param t the tiles
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @return number of tiles updated
+ */
+int tile_step(struct tiles_t *t, struct grid_t *p, struct grid_t *f, char type){
+    int k, i, j, r0, c0, *tmp, updated = t->n_active;
+
+    for(k = 0; k < t->n_active; k++){
+        i = t->active[k] / t->t_col;
+        j = t->active[k] % t->t_col;
+        r0 = i * TILE_SIZE;
+        c0 = j * TILE_SIZE;
+        if(step_tile(p, f, type, r0, r0 + TILE_SIZE < t->m_row ? r0 + TILE_SIZE : t->m_row, c0, c0 + TILE_SIZE < t->n_col ? c0 + TILE_SIZE : t->n_col))
+            mark_around(t, type, i, j);
+    }
+
+    for(k = 0; k < t->n_next; k++)
+        t->mark[t->next[k]] = 0;
+    tmp = t->active;
+    t->active = t->next;
+    t->next = tmp;
+    t->n_active = t->n_next;
+    t->n_next = 0;
+    t->updated += updated;
+    return updated;
+}
+
+/** 
+ * @brief Advance the matrix gens generations, updating only the tiles near a change.
+ * @details p and f are swapped once per generation, so on return *p is the last generation.
+ * @param t the tiles
+ * @param p Present Matrix - Current Generation
+ * @param f Future Matrix - Next Generation
+ * @param type type of edge - hedge, torus, klein
+ * @param gens number of generations
+ */
+void tile_run(struct tiles_t *t, struct grid_t **p, struct grid_t **f, char type, long gens){
+    struct grid_t *tmp;
+
+    for(; gens > 0; gens--){
+        tile_step(t, *p, *f, type);
+        tmp = *p;
+        *p = *f;
+        *f = tmp;
+    }
+}
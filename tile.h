@@ -0,0 +1,38 @@
+/**
+ * @file tile.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the active tile tracking of the byte matrix
+ */
+#ifndef TILE_H_
+#define TILE_H_
+
+struct grid_t;
+
+/** Rows and collums of a tile. */
+#define TILE_SIZE 64
+
+/**
+ * The matrix split into TILE_SIZE square tiles, the last row and collum of tiles cut short.
+ * Tile (i, j) is index i * t_col + j. Only the tiles in active are updated each generation.
+ */
+struct tiles_t {
+        int m_row;
+        int n_col;
+        int t_row;
+        int t_col;
+        int *active;		/* tiles to update this generation */
+        int n_active;
+        int *next;		/* tiles to update next generation */
+        int n_next;
+        unsigned char *mark;	/* set for the tiles already in next */
+        long updated;		/* tiles updated since the tiles were made */
+};
+
+struct tiles_t *init_tiles(int m_row, int n_col);
+void free_tiles(struct tiles_t *t);
+void tiles_all(struct tiles_t *t);
+int tile_step(struct tiles_t *t, struct grid_t *p, struct grid_t *f, char type);
+void tile_run(struct tiles_t *t, struct grid_t **p, struct grid_t **f, char type, long gens);
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * @file triple.c
+ * @brief Triple buffer for convey's game of life
+ * @details 
+ * The simulation thread writes a finished generation into the back frame
+ * and publishes it, and the render thread takes the latest published frame
+ * when it draws. Publishing and taking are single atomic exchanges, so the
+ * simulation never waits for a frame to be drawn and the renderer never waits
+ * for a generation to finish. The simulation only fills a frame once the
+ * renderer has taken the last one, so generations between two draws cost
+ * nothing to skip.
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @bugs None
+ * @todo none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "life.h"
+#include "triple.h"
+
+/** 
+ * @brief Creates the three frames. Return adress of the buffer is sussesful or NULL if malloc failed.
+ * @param m_row number of samples across a frame
+ * @param n_col number of samples down a frame
+ */
+struct triple_t *init_triple(int m_row, int n_col){
+    struct triple_t *t = calloc(1, sizeof(struct triple_t));
+    int i;
+
+    if(!t)
+        return NULL;
+    for(i = 0; i < 3; i++){
+        t->frame[i].dirty = malloc(m_row);
+        if(!(t->frame[i].cells = init_matrix(m_row, n_col)) || !t->frame[i].dirty){
+            free_triple(t);
+            return NULL;
+        }
+    }
+    t->back = 0;
+    atomic_init(&t->middle, 1);
+    t->front = 2;
+    return t;
+}
+
+/** 
+ * @brief Frees the frames.
+ * @param t the buffer
+ */
+void free_triple(struct triple_t *t){
+    int i;
+
+    for(i = 0; i < 3; i++){
+        if(t->frame[i].cells)
+            free_matrix(t->frame[i].cells);
+        free(t->frame[i].dirty);
+    }
+    free(t);
+}
+
+/** 
+ * @brief Frame the writer fills next.
+ * @param t the buffer
+ */
+struct frame_t *triple_back(struct triple_t *t){
+    return &t->frame[t->back];
+}
+
+/** 
+ * @brief Tell the writer if the reader has taken the last frame published, so a new one is worth filling.
+ * @param t the buffer
+ */
+int triple_wanted(struct triple_t *t){
+    return !(atomic_load(&t->middle) & TRIPLE_FRESH);
+}
+
+/** 
+ * @brief Hand the filled back frame to the reader and take the old middle frame as the new back frame.
+ * @param t the buffer
+ */
+void triple_publish(struct triple_t *t){
+    t->back = atomic_exchange(&t->middle, t->back | TRIPLE_FRESH) & ~TRIPLE_FRESH;
+}
+
+/** 
+ * @brief Take the latest published frame if there is one the reader has not seen.
+ * @param t the buffer
+ * @return the new front frame, or NULL if nothing was published since the last take
+ */
+struct frame_t *triple_take(struct triple_t *t){
+    if(!(atomic_load(&t->middle) & TRIPLE_FRESH))
+        return NULL;
+    t->front = atomic_exchange(&t->middle, t->front) & ~TRIPLE_FRESH;
+    return &t->frame[t->front];
+}
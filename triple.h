@@ -0,0 +1,52 @@
+/**
+ * @file triple.h
+ * @author Tommy Pham
+ * @date Fall 2020
+ * @brief Header file for the triple buffer handing frames from the simulation to the renderer
+ */
+#ifndef TRIPLE_H_
+#define TRIPLE_H_
+
+#include <stdatomic.h>
+
+struct grid_t;
+
+/** Set in middle while the middle frame holds a generation the reader has not taken. */
+#define TRIPLE_FRESH 4
+
+/**
+ * What the window shows of one generation: samples of the board starting at board row x, collum y.
+ * Zoomed in (zoom >= 0) a sample is one cell drawn 2^zoom pixels wide. Zoomed out a sample is the density,
+ * 0 to 255, of a block of 2^-zoom by 2^-zoom cells drawn as one pixel.
+ * Unless full is set, only the samples [i][] with dirty[i] set are filled and need drawing; the rest are as
+ * the last frame drawn left them.
+ */
+struct frame_t {
+        struct grid_t *cells;		/* sample [i][j] is drawn at screen x i, y j before scaling */
+        long x, y;
+        int zoom;
+        int w, h;			/* samples in use, at most the size of cells */
+        unsigned char *dirty;		/* set for each screen x sample that changed */
+        int full;			/* every sample changed */
+};
+
+/**
+ * Three frames, one for the writer (back), one for the reader (front) and one in between (middle).
+ * The writer fills back then swaps it with middle; the reader swaps front with middle when middle is fresh.
+ * The swaps are atomic exchanges, so neither side ever waits on the other.
+ */
+struct triple_t {
+        struct frame_t frame[3];
+        atomic_int middle;		/* index of the middle frame, with TRIPLE_FRESH */
+        int back;			/* only used by the writer */
+        int front;			/* only used by the reader */
+};
+
+struct triple_t *init_triple(int m_row, int n_col);
+void free_triple(struct triple_t *t);
+struct frame_t *triple_back(struct triple_t *t);
+int triple_wanted(struct triple_t *t);
+void triple_publish(struct triple_t *t);
+struct frame_t *triple_take(struct triple_t *t);
+
+#endif